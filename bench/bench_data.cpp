@@ -0,0 +1,112 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench_data.h"
+#include "corpus.h"
+#include "io/stream_reader.h"
+#include "nbt_tags.h"
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace nbt;
+
+namespace bench
+{
+
+namespace //anonymous
+{
+    std::unique_ptr<tag_compound> make_arrays()
+    {
+        std::mt19937 rng(42);
+        std::vector<int8_t> bytes(1 << 20);
+        std::vector<int32_t> ints(1 << 18);
+        std::vector<int64_t> longs(1 << 17);
+        for(auto& x: bytes)
+            x = int8_t(rng());
+        for(auto& x: ints)
+            x = int32_t(rng());
+        for(auto& x: longs)
+            x = int64_t(uint64_t(rng()) << 32 | rng());
+        return std::unique_ptr<tag_compound>(new tag_compound{
+            {"bytes", tag_byte_array(std::move(bytes))},
+            {"ints", tag_int_array(std::move(ints))},
+            {"longs", tag_long_array(std::move(longs))}
+        });
+    }
+
+    std::unique_ptr<tag_compound> make_nested()
+    {
+        //Alternate between compounds and single-element lists of compounds
+        tag_compound inner{{"leaf", "bottom"}, {"depth", 0}};
+        for(int depth = 1; depth < 256; ++depth)
+        {
+            tag_compound outer{{"depth", depth}, {"list", tag_list::of<tag_compound>({std::move(inner)})}};
+            inner = std::move(outer);
+        }
+        return std::unique_ptr<tag_compound>(new tag_compound(std::move(inner)));
+    }
+}
+
+const char* fixture_name(int f)
+{
+    switch(f)
+    {
+    case bigtest: return "bigtest";
+    case chunk: return "chunk";
+    case arrays: return "arrays";
+    case nested: return "nested";
+    default: return "?";
+    }
+}
+
+std::unique_ptr<tag_compound> make_fixture(int f)
+{
+    switch(f)
+    {
+    case bigtest:
+    {
+        std::ifstream file(NBT_TESTFILES_DIR "/bigtest_uncompr", std::ios::binary);
+        return io::read_compound(file).second;
+    }
+    case chunk: return corpus::generator().chunk(0, 0);
+    case arrays: return make_arrays();
+    case nested: return make_nested();
+    default: throw std::invalid_argument("Unknown fixture");
+    }
+}
+
+std::string read_testfile(const std::string& name)
+{
+    std::ifstream file(NBT_TESTFILES_DIR "/" + name, std::ios::binary);
+    if(!file)
+        throw std::runtime_error("Could not open " + name);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void fixture_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("fixture");
+    for(int f = 0; f < fixture_count; ++f)
+        b->Arg(f);
+}
+
+}
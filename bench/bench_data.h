@@ -0,0 +1,60 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BENCH_DATA_H_INCLUDED
+#define BENCH_DATA_H_INCLUDED
+
+#include <benchmark/benchmark.h>
+#include "tag_compound.h"
+#include <memory>
+#include <string>
+
+///Inputs shared by the benchmarks
+namespace bench
+{
+
+///The trees that the benchmarks run on
+enum fixture
+{
+    ///test/testfiles/bigtest_uncompr, about 1.5 KiB
+    bigtest,
+    ///A chunk from corpus::generator with the default options, about 160 KiB
+    chunk,
+    ///A few large byte, int and long arrays
+    arrays,
+    ///Compounds and lists nested 512 levels deep
+    nested,
+    fixture_count
+};
+
+///Returns the name of the fixture for benchmark labels
+const char* fixture_name(int f);
+
+///Builds the fixture's tree; the result is the same on every call
+std::unique_ptr<nbt::tag_compound> make_fixture(int f);
+
+///Returns the contents of a file in test/testfiles
+std::string read_testfile(const std::string& name);
+
+///Adds one argument per fixture to a benchmark
+void fixture_args(benchmark::internal::Benchmark* b);
+
+}
+
+#endif // BENCH_DATA_H_INCLUDED
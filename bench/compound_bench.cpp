@@ -0,0 +1,155 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <benchmark/benchmark.h>
+#include "flat_map.h"
+#include "io/imemstream.h"
+#include "io/stream_reader.h"
+#include "nbt_tags.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nbt;
+
+namespace
+{
+    typedef std::map<std::string, value> std_map;
+    typedef detail::flat_map<std::string, value> flat_map;
+
+    //Keys of the top level compound in bigtest.nbt
+    const std::vector<std::string> bigtest_keys{
+        "byteTest", "shortTest", "intTest", "longTest", "floatTest", "doubleTest",
+        "byteArrayTest (the first 1000 values of (n*n*255+n*7)%100, starting with n=0 (0, 62, 34, 16, 8, ...))",
+        "stringTest", "listTest (compound)", "listTest (long)", "listTest (end)",
+        "nested compound test", "intArrayTest", "longArrayTest"
+    };
+
+    //Keys of a typical entity compound within a chunk
+    const std::vector<std::string> entity_keys{
+        "AbsorptionAmount", "Air", "ArmorDropChances", "ArmorItems", "Attributes",
+        "Brain", "CanPickUpLoot", "DeathTime", "FallDistance", "FallFlying", "Fire",
+        "HandDropChances", "HandItems", "Health", "HurtByTimestamp", "HurtTime",
+        "Invulnerable", "LeftHanded", "Motion", "OnGround", "PersistenceRequired",
+        "PortalCooldown", "Pos", "Rotation", "UUID", "id"
+    };
+
+    //Keys of a chunk section
+    const std::vector<std::string> section_keys{
+        "BlockLight", "SkyLight", "Y", "biomes", "block_states"
+    };
+
+    const std::vector<std::string>& get_keys(int set)
+    {
+        switch(set)
+        {
+        case 0: return bigtest_keys;
+        case 1: return entity_keys;
+        default: return section_keys;
+        }
+    }
+
+    ///The keys in the order in which they typically arrive, i.e. not sorted
+    std::vector<std::string> shuffled(const std::vector<std::string>& keys)
+    {
+        std::vector<std::string> ret = keys;
+        std::shuffle(ret.begin(), ret.end(), std::mt19937(42));
+        return ret;
+    }
+
+    template<class Map>
+    Map build(const std::vector<std::string>& keys)
+    {
+        Map map;
+        for(const auto& key: keys)
+            map.emplace(key, value(tag_int(42)));
+        return map;
+    }
+
+    void key_set_args(benchmark::internal::Benchmark* b)
+    {
+        b->ArgName("keyset")->Arg(0)->Arg(1)->Arg(2);
+    }
+}
+
+template<class Map>
+static void BM_compound_build(benchmark::State& state)
+{
+    const auto keys = shuffled(get_keys(state.range(0)));
+    for(auto _: state)
+    {
+        Map map = build<Map>(keys);
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_compound_build, std_map)->Apply(key_set_args);
+BENCHMARK_TEMPLATE(BM_compound_build, flat_map)->Apply(key_set_args);
+
+template<class Map>
+static void BM_compound_lookup(benchmark::State& state)
+{
+    const auto keys = shuffled(get_keys(state.range(0)));
+    const Map map = build<Map>(keys);
+    for(auto _: state)
+    {
+        for(const auto& key: keys)
+            benchmark::DoNotOptimize(map.find(key));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_compound_lookup, std_map)->Apply(key_set_args);
+BENCHMARK_TEMPLATE(BM_compound_lookup, flat_map)->Apply(key_set_args);
+
+template<class Map>
+static void BM_compound_iterate(benchmark::State& state)
+{
+    const Map map = build<Map>(get_keys(state.range(0)));
+    for(auto _: state)
+    {
+        for(const auto& kv: map)
+            benchmark::DoNotOptimize(kv.second.get_ptr().get());
+    }
+    state.SetItemsProcessed(state.iterations() * map.size());
+}
+BENCHMARK_TEMPLATE(BM_compound_iterate, std_map)->Apply(key_set_args);
+BENCHMARK_TEMPLATE(BM_compound_iterate, flat_map)->Apply(key_set_args);
+
+//Reading a whole file with the storage that the library was built with
+static void BM_compound_read_bigtest(benchmark::State& state)
+{
+    std::ifstream file(NBT_TESTFILES_DIR "/bigtest_uncompr", std::ios::binary);
+    const std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+#ifdef NBT_FLAT_COMPOUND
+    state.SetLabel("flat_map");
+#else
+    state.SetLabel("std::map");
+#endif
+    for(auto _: state)
+    {
+        io::imemstream is(data);
+        benchmark::DoNotOptimize(io::read_compound(is));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_compound_read_bigtest);
@@ -0,0 +1,124 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <benchmark/benchmark.h>
+#include "bench_data.h"
+#include "io/imemstream.h"
+#include "io/omemstream.h"
+#include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include <sstream>
+#include <string>
+
+using namespace nbt;
+
+namespace
+{
+    const endian::endian endians[] = {endian::big, endian::little, endian::network};
+    const char* const endian_names[] = {"/big", "/little", "/network"};
+
+    endian::endian get_endian(const benchmark::State& state)
+    {
+        return endians[state.range(1)];
+    }
+
+    void set_label(benchmark::State& state)
+    {
+        state.SetLabel(std::string(bench::fixture_name(state.range(0)))
+                       + endian_names[state.range(1)]);
+    }
+
+    void fixture_endian_args(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({"fixture", "endian"})->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2}});
+    }
+
+    std::string serialize(const tag_compound& comp, endian::endian e)
+    {
+        std::ostringstream os;
+        io::write_tag("", comp, os, e);
+        return os.str();
+    }
+}
+
+//Decoding from memory, which is the fast path of stream_reader
+static void BM_read(benchmark::State& state)
+{
+    const endian::endian e = get_endian(state);
+    const std::string data = serialize(*bench::make_fixture(state.range(0)), e);
+    set_label(state);
+    for(auto _: state)
+    {
+        io::imemstream is(data);
+        benchmark::DoNotOptimize(io::read_compound(is, e));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_read)->Apply(fixture_endian_args);
+
+//Decoding through a generic istream
+static void BM_read_istringstream(benchmark::State& state)
+{
+    const endian::endian e = get_endian(state);
+    const std::string data = serialize(*bench::make_fixture(state.range(0)), e);
+    set_label(state);
+    for(auto _: state)
+    {
+        std::istringstream is(data);
+        benchmark::DoNotOptimize(io::read_compound(is, e));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_read_istringstream)->Apply(fixture_endian_args);
+
+//Encoding into memory, which is the fast path of stream_writer
+static void BM_write(benchmark::State& state)
+{
+    const endian::endian e = get_endian(state);
+    const auto comp = bench::make_fixture(state.range(0));
+    set_label(state);
+    size_t size = 0;
+    for(auto _: state)
+    {
+        io::omemstream os;
+        io::write_tag("", *comp, os, e);
+        size = os.size();
+        benchmark::DoNotOptimize(os.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_write)->Apply(fixture_endian_args);
+
+//Encoding through a generic ostream
+static void BM_write_ostringstream(benchmark::State& state)
+{
+    const endian::endian e = get_endian(state);
+    const auto comp = bench::make_fixture(state.range(0));
+    set_label(state);
+    size_t size = 0;
+    for(auto _: state)
+    {
+        std::ostringstream os;
+        io::write_tag("", *comp, os, e);
+        size = os.tellp();
+        benchmark::DoNotOptimize(os);
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_write_ostringstream)->Apply(fixture_endian_args);
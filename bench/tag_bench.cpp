@@ -0,0 +1,161 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <benchmark/benchmark.h>
+#include "bench_data.h"
+#include "tag_compound.h"
+#include "text/json_formatter.h"
+#include "text/json_parser.h"
+#include "text/snbt_parser.h"
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+
+using namespace nbt;
+
+namespace
+{
+    ///Discards its output, so that only the formatting is measured
+    class counting_buffer : public std::streambuf
+    {
+    public:
+        size_t count = 0;
+
+    private:
+        int_type overflow(int_type ch) override
+        {
+            ++count;
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize n) override
+        {
+            count += n;
+            return n;
+        }
+    };
+
+    ///Item strings as they appear in commands and configuration files
+    const char* const snbt_items[] = {
+        "{id: \"minecraft:stone\", Count: 64b}",
+        "{id: \"minecraft:diamond_sword\", Count: 1b, tag: {Damage: 12, Unbreakable: 1b,"
+            " Enchantments: [{id: \"minecraft:sharpness\", lvl: 5s}, {id: \"minecraft:looting\", lvl: 3s}],"
+            " display: {Name: '{\"text\":\"Blade\",\"italic\":false}', Lore: ['\"Sharp\"', '\"Old\"']}}}",
+        "{id: \"minecraft:filled_map\", Count: 1b, tag: {map: 42, Decorations: [{id: \"+\", type: 9b,"
+            " x: 128.0d, z: -256.5d, rot: 180.0d}], display: {MapColor: 4674921}}}",
+        "{id: \"minecraft:firework_rocket\", Count: 3b, tag: {Fireworks: {Flight: 2b,"
+            " Explosions: [{Type: 1b, Colors: [I; 11743532, 14602026], FadeColors: [I; 15435844]}]}}}",
+        "{id: \"minecraft:player_head\", Count: 1b, tag: {SkullOwner: {Id: [I; -1, 2147483647, 12, 7],"
+            " Properties: {textures: [{Value: \"eyJ0ZXh0dXJlcyI6e319\"}]}}}}",
+    };
+}
+
+static void BM_json_print(benchmark::State& state)
+{
+    const auto comp = bench::make_fixture(state.range(0));
+    const text::json_formatter fmt;
+    state.SetLabel(bench::fixture_name(state.range(0)));
+    size_t size = 0;
+    for(auto _: state)
+    {
+        counting_buffer buf;
+        std::ostream os(&buf);
+        fmt.print(os, *comp);
+        size = buf.count;
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_json_print)->Apply(bench::fixture_args);
+
+//Compact strict JSON, as used for exporting
+static void BM_json_strict(benchmark::State& state)
+{
+    const auto comp = bench::make_fixture(state.range(0));
+    text::json_options opts;
+    opts.syntax = text::json_syntax::strict;
+    opts.pretty = false;
+    const text::json_formatter fmt(opts);
+    state.SetLabel(bench::fixture_name(state.range(0)));
+    size_t size = 0;
+    for(auto _: state)
+    {
+        counting_buffer buf;
+        std::ostream os(&buf);
+        fmt.print(os, *comp);
+        size = buf.count;
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_json_strict)->Apply(bench::fixture_args);
+
+//Reading back typed JSON written by the formatter
+static void BM_json_parse(benchmark::State& state)
+{
+    const auto comp = bench::make_fixture(state.range(0));
+    text::json_options opts;
+    opts.syntax = text::json_syntax::strict;
+    opts.types = text::json_types::typed;
+    opts.pretty = false;
+    std::ostringstream os;
+    text::json_formatter(opts).print(os, *comp);
+    const std::string json = os.str();
+    const text::json_parser parser(text::json_types::typed);
+    state.SetLabel(bench::fixture_name(state.range(0)));
+    for(auto _: state)
+        benchmark::DoNotOptimize(parser.parse(json));
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_json_parse)->Apply(bench::fixture_args);
+
+static void BM_parse_snbt(benchmark::State& state)
+{
+    const text::snbt_parser parser;
+    size_t size = 0;
+    for(const char* item: snbt_items)
+        size += std::char_traits<char>::length(item);
+    for(auto _: state)
+    {
+        for(const char* item: snbt_items)
+            benchmark::DoNotOptimize(parser.parse(item));
+    }
+    state.SetItemsProcessed(state.iterations() * std::size(snbt_items));
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_parse_snbt);
+
+static void BM_clone(benchmark::State& state)
+{
+    const auto comp = bench::make_fixture(state.range(0));
+    state.SetLabel(bench::fixture_name(state.range(0)));
+    for(auto _: state)
+        benchmark::DoNotOptimize(comp->clone());
+}
+BENCHMARK(BM_clone)->Apply(bench::fixture_args);
+
+//Comparing two equal trees, which has to visit every tag
+static void BM_equal(benchmark::State& state)
+{
+    const auto comp = bench::make_fixture(state.range(0));
+    const auto copy = bench::make_fixture(state.range(0));
+    state.SetLabel(bench::fixture_name(state.range(0)));
+    for(auto _: state)
+        benchmark::DoNotOptimize(*comp == *copy);
+}
+BENCHMARK(BM_equal)->Apply(bench::fixture_args);
@@ -0,0 +1,136 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <benchmark/benchmark.h>
+#include "bench_data.h"
+#include "io/imemstream.h"
+#include "io/izlibstream.h"
+#include "io/omemstream.h"
+#include "io/ozlibstream.h"
+#include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include "io/zlib_buffer.h"
+#include "nbt_tags.h"
+#include <sstream>
+#include <string>
+
+using namespace nbt;
+
+namespace
+{
+    ///bigtest is about as large as a small packet, where the setup cost matters most
+    std::unique_ptr<tag_compound> read_bigtest()
+    {
+        return bench::make_fixture(bench::bigtest);
+    }
+
+    std::string compress_bigtest()
+    {
+        std::string out;
+        zlib::deflater().compress_tag("", *read_bigtest(), out);
+        return out;
+    }
+}
+
+//Compressing one tag per call, setting up a new ozlibstream each time
+static void BM_deflate_ozlibstream(benchmark::State& state)
+{
+    const auto comp = read_bigtest();
+    for(auto _: state)
+    {
+        std::ostringstream str;
+        zlib::ozlibstream ozls(str);
+        io::write_tag("", *comp, ozls);
+        ozls.close();
+        benchmark::DoNotOptimize(str.str());
+    }
+}
+BENCHMARK(BM_deflate_ozlibstream);
+
+//Compressing one tag per call, reusing the same deflater
+static void BM_deflate_deflater(benchmark::State& state)
+{
+    const auto comp = read_bigtest();
+    zlib::deflater def;
+    std::string out;
+    for(auto _: state)
+    {
+        def.compress_tag("", *comp, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_deflate_deflater);
+
+static void BM_inflate_izlibstream(benchmark::State& state)
+{
+    const std::string data = compress_bigtest();
+    for(auto _: state)
+    {
+        std::istringstream str(data);
+        zlib::izlibstream izls(str);
+        benchmark::DoNotOptimize(io::read_compound(izls));
+    }
+}
+BENCHMARK(BM_inflate_izlibstream);
+
+static void BM_inflate_inflater(benchmark::State& state)
+{
+    const std::string data = compress_bigtest();
+    zlib::inflater inf;
+    for(auto _: state)
+        benchmark::DoNotOptimize(inf.read_compound(data.data(), data.size()));
+}
+BENCHMARK(BM_inflate_inflater);
+
+//Reading gzip compressed files, as with level.dat or .nbt structure files.
+//The throughput is that of the compressed data.
+static void BM_read_gzip(benchmark::State& state)
+{
+    std::string data;
+    zlib::deflater(-1, true).compress_tag("", *bench::make_fixture(state.range(0)), data);
+    state.SetLabel(bench::fixture_name(state.range(0)));
+    for(auto _: state)
+    {
+        io::imemstream is(data);
+        zlib::izlibstream izls(is);
+        benchmark::DoNotOptimize(io::read_compound(izls));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_read_gzip)->Apply(bench::fixture_args);
+
+//The throughput is that of the compressed data
+static void BM_write_gzip(benchmark::State& state)
+{
+    const auto comp = bench::make_fixture(state.range(0));
+    state.SetLabel(bench::fixture_name(state.range(0)));
+    size_t size = 0;
+    for(auto _: state)
+    {
+        io::omemstream os;
+        {
+            zlib::ozlibstream ozls(os, -1, true);
+            io::write_tag("", *comp, ozls);
+        }
+        size = os.size();
+        benchmark::DoNotOptimize(os.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_write_gzip)->Apply(bench::fixture_args);
@@ -0,0 +1,117 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORPUS_H_INCLUDED
+#define CORPUS_H_INCLUDED
+
+#include "tag_compound.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include "nbt_export.h"
+
+namespace nbt
+{
+
+/**
+ * @brief Generation of synthetic NBT data in realistic shapes
+ *
+ * The generated trees resemble Minecraft's chunks and level.dat files, so
+ * that benchmarks and fuzzers can work on realistic inputs of any size
+ * without shipping world data. The contents are random, but reproducible:
+ * the same options always produce the same trees, on every platform.
+ */
+namespace corpus
+{
+
+///Parameters of the generated data. Counts are means unless noted otherwise.
+struct options
+{
+    ///Seed of the random numbers
+    uint32_t seed = 0;
+
+    ///Number of sections per chunk (exact)
+    unsigned sections = 24;
+    ///Maximum number of different blocks per section; the palette sizes are uniformly distributed
+    unsigned max_palette = 32;
+    ///Maximum number of different biomes per section
+    unsigned max_biomes = 4;
+
+    ///Block entities per chunk, Poisson distributed
+    double block_entities = 8;
+    ///Fraction of the block entities that are containers with items
+    double containers = 0.5;
+    ///Slots per container that hold an item
+    double items_per_container = 12;
+
+    ///Entities per chunk, Poisson distributed
+    double entities = 6;
+
+    ///Probability that an item carries additional NBT (enchantments, names, etc.)
+    double item_tag_chance = 0.25;
+    ///Probability that an item with NBT is a container with items itself
+    double nested_container_chance = 0.3;
+    ///Maximum depth of containers nested in items
+    unsigned max_item_depth = 4;
+};
+
+/**
+ * @brief Generates synthetic chunks, level data and items
+ *
+ * Chunks depend only on the options and their coordinates, so they can be
+ * generated in any order and on several threads with separate generators.
+ */
+class NBT_EXPORT generator
+{
+public:
+    explicit generator(const options& opt = options());
+
+    const options& get_options() const { return opt; }
+
+    /**
+     * @brief Generates the chunk at the given chunk coordinates
+     *
+     * The chunk has the layout that Anvil region files use since 1.18:
+     * sections with block state and biome palettes and packed long arrays,
+     * heightmaps, block entities and entities.
+     */
+    std::unique_ptr<tag_compound> chunk(int x, int z) const;
+
+    /**
+     * @brief Generates the root compound of a level.dat file
+     *
+     * It contains a "Data" compound with world settings, game rules and a
+     * player with a filled inventory.
+     */
+    std::unique_ptr<tag_compound> level() const;
+
+    /**
+     * @brief Generates a single item stack
+     * @param index selects the item; different indices give independent items
+     */
+    std::unique_ptr<tag_compound> item(uint32_t index) const;
+
+private:
+    options opt;
+};
+
+}
+}
+
+#endif // CORPUS_H_INCLUDED
@@ -21,6 +21,7 @@
 #define ENDIAN_STR_H_INCLUDED
 
 #include <cstdint>
+#include <cstring>
 #include <iosfwd>
 #include "nbt_export.h"
 
@@ -31,7 +32,16 @@
 namespace endian
 {
 
-enum endian { little, big };
+/**
+ * @brief Byte order of binary NBT data
+ *
+ * @c network is the encoding of the Bedrock edition network protocol.
+ * It is little endian, except that io::stream_reader and io::stream_writer
+ * store Int and Long values, and the lengths of strings, lists and arrays,
+ * as variable length integers (see varint.h). The functions in this
+ * namespace treat it like @c little.
+ */
+enum endian { little, big, network };
 
 ///Reads number from stream in specified endian
 template<class T>
@@ -89,22 +99,202 @@ NBT_EXPORT void write_big(std::ostream& os, int64_t x);
 NBT_EXPORT void write_big(std::ostream& os, float x);
 NBT_EXPORT void write_big(std::ostream& os, double x);
 
+///Reads an array of numbers from stream in specified endian
+NBT_EXPORT void read_array(std::istream& is, int16_t* arr, size_t n, endian e);
+NBT_EXPORT void read_array(std::istream& is, int32_t* arr, size_t n, endian e);
+NBT_EXPORT void read_array(std::istream& is, int64_t* arr, size_t n, endian e);
+NBT_EXPORT void read_array(std::istream& is, float* arr, size_t n, endian e);
+NBT_EXPORT void read_array(std::istream& is, double* arr, size_t n, endian e);
+
+///Writes an array of numbers to stream in specified endian
+NBT_EXPORT void write_array(std::ostream& os, const int16_t* arr, size_t n, endian e);
+NBT_EXPORT void write_array(std::ostream& os, const int32_t* arr, size_t n, endian e);
+NBT_EXPORT void write_array(std::ostream& os, const int64_t* arr, size_t n, endian e);
+NBT_EXPORT void write_array(std::ostream& os, const float* arr, size_t n, endian e);
+NBT_EXPORT void write_array(std::ostream& os, const double* arr, size_t n, endian e);
+
+///Writes an array of numbers to memory in specified endian, dst needs not be aligned
+NBT_EXPORT void write_array(char* dst, const int16_t* arr, size_t n, endian e);
+NBT_EXPORT void write_array(char* dst, const int32_t* arr, size_t n, endian e);
+NBT_EXPORT void write_array(char* dst, const int64_t* arr, size_t n, endian e);
+NBT_EXPORT void write_array(char* dst, const float* arr, size_t n, endian e);
+NBT_EXPORT void write_array(char* dst, const double* arr, size_t n, endian e);
+
+/**
+ * @brief Converts an array of numbers between the specified and the native
+ * byte order, in place
+ *
+ * Uses SIMD instructions where available.
+ */
+NBT_EXPORT void convert_array(int16_t* arr, size_t n, endian e);
+NBT_EXPORT void convert_array(int32_t* arr, size_t n, endian e);
+NBT_EXPORT void convert_array(int64_t* arr, size_t n, endian e);
+NBT_EXPORT void convert_array(float* arr, size_t n, endian e);
+NBT_EXPORT void convert_array(double* arr, size_t n, endian e);
+
+///Reads number from memory in specified endian
+template<class T>
+void read(const char* p, T& x, endian e);
+///Reads number from memory in little endian
+template<class T>
+void read_little(const char* p, T& x);
+///Reads number from memory in big endian
+template<class T>
+void read_big(const char* p, T& x);
+
+///Writes number to memory in specified endian
+template<class T>
+void write(char* p, T x, endian e);
+///Writes number to memory in little endian
+template<class T>
+void write_little(char* p, T x);
+///Writes number to memory in big endian
+template<class T>
+void write_big(char* p, T x);
+
 template<class T>
 void read(std::istream& is, T& x, endian e)
 {
-    if(e == little)
-        read_little(is, x);
-    else
+    if(e == big)
         read_big(is, x);
+    else
+        read_little(is, x);
 }
 
 template<class T>
 void write(std::ostream& os, T x, endian e)
 {
-    if(e == little)
+    if(e == big)
+        write_big(os, x);
+    else
         write_little(os, x);
+}
+
+///@cond
+namespace detail
+{
+    ///Meta-struct that holds the unsigned integer type with the given size
+    template<size_t N> struct uint_of_size;
+    template<> struct uint_of_size<1> { typedef uint8_t  type; };
+    template<> struct uint_of_size<2> { typedef uint16_t type; };
+    template<> struct uint_of_size<4> { typedef uint32_t type; };
+    template<> struct uint_of_size<8> { typedef uint64_t type; };
+
+    //Compilers recognize these patterns and turn them into single loads
+    inline void load_little(const unsigned char* p, uint8_t& x)  { x = p[0]; }
+    inline void load_little(const unsigned char* p, uint16_t& x)
+    {
+        x =  uint16_t(p[0])
+          | (uint16_t(p[1]) << 8);
+    }
+    inline void load_little(const unsigned char* p, uint32_t& x)
+    {
+        x =  uint32_t(p[0])
+          | (uint32_t(p[1]) << 8)
+          | (uint32_t(p[2]) << 16)
+          | (uint32_t(p[3]) << 24);
+    }
+    inline void load_little(const unsigned char* p, uint64_t& x)
+    {
+        x =  uint64_t(p[0])
+          | (uint64_t(p[1]) << 8)
+          | (uint64_t(p[2]) << 16)
+          | (uint64_t(p[3]) << 24)
+          | (uint64_t(p[4]) << 32)
+          | (uint64_t(p[5]) << 40)
+          | (uint64_t(p[6]) << 48)
+          | (uint64_t(p[7]) << 56);
+    }
+
+    inline void load_big(const unsigned char* p, uint8_t& x)  { x = p[0]; }
+    inline void load_big(const unsigned char* p, uint16_t& x)
+    {
+        x =  uint16_t(p[1])
+          | (uint16_t(p[0]) << 8);
+    }
+    inline void load_big(const unsigned char* p, uint32_t& x)
+    {
+        x =  uint32_t(p[3])
+          | (uint32_t(p[2]) << 8)
+          | (uint32_t(p[1]) << 16)
+          | (uint32_t(p[0]) << 24);
+    }
+    inline void load_big(const unsigned char* p, uint64_t& x)
+    {
+        x =  uint64_t(p[7])
+          | (uint64_t(p[6]) << 8)
+          | (uint64_t(p[5]) << 16)
+          | (uint64_t(p[4]) << 24)
+          | (uint64_t(p[3]) << 32)
+          | (uint64_t(p[2]) << 40)
+          | (uint64_t(p[1]) << 48)
+          | (uint64_t(p[0]) << 56);
+    }
+
+    template<class U>
+    void store_little(unsigned char* p, U x)
+    {
+        for(size_t i = 0; i < sizeof(U); ++i)
+            p[i] = static_cast<unsigned char>(x >> (8 * i));
+    }
+
+    template<class U>
+    void store_big(unsigned char* p, U x)
+    {
+        for(size_t i = 0; i < sizeof(U); ++i)
+            p[i] = static_cast<unsigned char>(x >> (8 * (sizeof(U) - 1 - i)));
+    }
+}
+///@endcond
+
+template<class T>
+void read(const char* p, T& x, endian e)
+{
+    if(e == big)
+        read_big(p, x);
     else
-        write_big(os, x);
+        read_little(p, x);
+}
+
+template<class T>
+void read_little(const char* p, T& x)
+{
+    typename detail::uint_of_size<sizeof(T)>::type tmp;
+    detail::load_little(reinterpret_cast<const unsigned char*>(p), tmp);
+    std::memcpy(&x, &tmp, sizeof(T)); //also takes care of floating point values
+}
+
+template<class T>
+void read_big(const char* p, T& x)
+{
+    typename detail::uint_of_size<sizeof(T)>::type tmp;
+    detail::load_big(reinterpret_cast<const unsigned char*>(p), tmp);
+    std::memcpy(&x, &tmp, sizeof(T));
+}
+
+template<class T>
+void write(char* p, T x, endian e)
+{
+    if(e == big)
+        write_big(p, x);
+    else
+        write_little(p, x);
+}
+
+template<class T>
+void write_little(char* p, T x)
+{
+    typename detail::uint_of_size<sizeof(T)>::type tmp;
+    std::memcpy(&tmp, &x, sizeof(T));
+    detail::store_little(reinterpret_cast<unsigned char*>(p), tmp);
+}
+
+template<class T>
+void write_big(char* p, T x)
+{
+    typename detail::uint_of_size<sizeof(T)>::type tmp;
+    std::memcpy(&tmp, &x, sizeof(T));
+    detail::store_big(reinterpret_cast<unsigned char*>(p), tmp);
 }
 
 }
@@ -0,0 +1,189 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FLAT_MAP_H_INCLUDED
+#define FLAT_MAP_H_INCLUDED
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace nbt
+{
+
+namespace detail
+{
+    /**
+     * @brief Associative container that keeps its entries in a sorted vector
+     *
+     * Provides the subset of the std::map interface that tag_compound needs.
+     * Lookups are binary searches over contiguous memory and the entries need
+     * no separate allocations, which makes it faster than std::map for the
+     * small containers that are common in NBT data. Iteration order is the
+     * same as with std::map.
+     *
+     * Unlike with std::map, inserting or erasing entries invalidates all
+     * iterators and references to the entries.
+     * The keys must not be modified through the iterators.
+     */
+    template<class Key, class T>
+    class flat_map
+    {
+    public:
+        typedef Key key_type;
+        typedef T mapped_type;
+        typedef std::pair<Key, T> value_type;
+        typedef typename std::vector<value_type>::iterator iterator;
+        typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+        flat_map() {}
+
+        /**
+         * @brief Replaces the contents with the given entries in arbitrary order
+         *
+         * Faster than inserting the entries one by one. If a key occurs more
+         * than once, the first entry wins, like with repeated emplace calls.
+         */
+        void assign(std::vector<value_type>&& unsorted)
+        {
+            entries = std::move(unsorted);
+            auto less = [](const value_type& a, const value_type& b) { return a.first < b.first; };
+            if(entries.size() <= 32)
+            {
+                //Insertion sort is stable and needs no extra memory, ideal for small maps
+                for(auto it = entries.begin(); it != entries.end(); ++it)
+                    std::rotate(std::upper_bound(entries.begin(), it, *it, less), it, it + 1);
+            }
+            else
+                std::stable_sort(entries.begin(), entries.end(), less);
+            entries.erase(std::unique(entries.begin(), entries.end(),
+                [](const value_type& a, const value_type& b) { return a.first == b.first; }),
+                entries.end());
+        }
+
+        iterator begin() { return entries.begin(); }
+        iterator end()   { return entries.end(); }
+        const_iterator begin() const  { return entries.begin(); }
+        const_iterator end() const    { return entries.end(); }
+        const_iterator cbegin() const { return entries.cbegin(); }
+        const_iterator cend() const   { return entries.cend(); }
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        void clear() { entries.clear(); }
+        void reserve(size_t n) { entries.reserve(n); }
+
+        /*
+         * The lookup functions accept any key type that can be compared with
+         * Key, e.g. std::string_view for std::string keys, so that lookups
+         * don't need to construct a temporary Key.
+         */
+        template<class K>
+        iterator find(const K& key)
+        {
+            auto it = lower_bound(key);
+            return (it != end() && it->first == key) ? it : end();
+        }
+
+        template<class K>
+        const_iterator find(const K& key) const
+        {
+            return const_cast<flat_map&>(*this).find(key);
+        }
+
+        template<class K>
+        T& at(const K& key)
+        {
+            auto it = find(key);
+            if(it == end())
+                throw std::out_of_range("flat_map::at");
+            return it->second;
+        }
+
+        template<class K>
+        const T& at(const K& key) const
+        {
+            return const_cast<flat_map&>(*this).at(key);
+        }
+
+        template<class K>
+        T& operator[](const K& key)
+        {
+            auto it = lower_bound(key);
+            if(it == end() || it->first != key)
+                it = entries.emplace(it, Key(key), T());
+            return it->second;
+        }
+
+        ///Inserts an entry if the key does not exist yet, like std::map::emplace
+        template<class K, class... Args>
+        std::pair<iterator, bool> emplace(K&& key, Args&&... args)
+        {
+            //Fast path for entries that arrive in sorted order
+            if(entries.empty() || entries.back().first < key)
+            {
+                entries.emplace_back(std::forward<K>(key), T(std::forward<Args>(args)...));
+                return {end() - 1, true};
+            }
+            auto it = lower_bound(key);
+            if(it->first == key)
+                return {it, false};
+            it = entries.emplace(it, std::forward<K>(key), T(std::forward<Args>(args)...));
+            return {it, true};
+        }
+
+        template<class K>
+        size_t erase(const K& key)
+        {
+            auto it = find(key);
+            if(it == end())
+                return 0;
+            entries.erase(it);
+            return 1;
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return entries.erase(begin() + (pos - cbegin()));
+        }
+
+        //Without this, erasing by iterator would pick the key template above
+        iterator erase(iterator pos) { return entries.erase(pos); }
+
+        friend bool operator==(const flat_map& lhs, const flat_map& rhs)
+        { return lhs.entries == rhs.entries; }
+        friend bool operator!=(const flat_map& lhs, const flat_map& rhs)
+        { return !(lhs == rhs); }
+
+    private:
+        std::vector<value_type> entries;
+
+        template<class K>
+        iterator lower_bound(const K& key)
+        {
+            return std::lower_bound(entries.begin(), entries.end(), key,
+                [](const value_type& entry, const K& k) { return entry.first < k; });
+        }
+    };
+}
+
+}
+
+#endif // FLAT_MAP_H_INCLUDED
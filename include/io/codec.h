@@ -0,0 +1,124 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CODEC_H_INCLUDED
+#define CODEC_H_INCLUDED
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "nbt_export.h"
+
+namespace nbt
+{
+namespace io
+{
+
+///The compression schemes of chunks in region files
+enum class compression : uint8_t
+{
+    gzip = 1,
+    zlib = 2,
+    none = 3,
+    ///LZ4 in the block format of lz4-java
+    lz4 = 4,
+    custom = 127
+};
+
+///Exception that gets thrown by the LZ4 and zstd codecs
+class NBT_EXPORT codec_error : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief A compression algorithm
+ *
+ * The codecs are obtained with get_codec or find_codec. Which of them are
+ * available depends on the libraries that were found when building:
+ *
+ * name | scheme            | requires
+ * -----|-------------------|---------
+ * none | compression::none | -
+ * gzip | compression::gzip | zlib (NBT_HAVE_ZLIB)
+ * zlib | compression::zlib | zlib (NBT_HAVE_ZLIB)
+ * lz4  | compression::lz4  | LZ4 (NBT_HAVE_LZ4)
+ * zstd | -                 | zstd (NBT_HAVE_ZSTD)
+ *
+ * All member functions can be called from several threads at once.
+ */
+class NBT_EXPORT codec
+{
+public:
+    virtual ~codec() noexcept {}
+
+    ///Returns the name of the codec
+    virtual const char* name() const = 0;
+
+    ///Returns the compression scheme of the codec in region files, or compression::custom if there is none
+    virtual compression scheme() const = 0;
+
+    /**
+     * @brief Compresses the data in one go into @c out, replacing its contents
+     * @param level the compression level, or -1 for the codec's default.
+     * The range of levels depends on the codec.
+     * @throw codec_error or zlib::zlib_error if the compression fails
+     */
+    virtual void compress(const char* data, size_t size, std::string& out, int level = -1) const = 0;
+
+    /**
+     * @brief Decompresses the data in one go into @c out, replacing its contents
+     * @param size_hint the expected size of the decompressed data, or 0 if unknown
+     * @throw codec_error or zlib::zlib_error if the data is corrupt or truncated
+     */
+    virtual void decompress(const char* data, size_t size, std::string& out, size_t size_hint = 0) const = 0;
+
+    /**
+     * @brief Returns an istream that decompresses the data read from @c is
+     *
+     * The returned stream must be destroyed before @c is.
+     */
+    virtual std::unique_ptr<std::istream> open_istream(std::istream& is) const = 0;
+
+    /**
+     * @brief Returns an ostream that compresses the data and writes it to @c os
+     *
+     * The compressed data is completed when the returned stream is
+     * destroyed, which must happen before @c os is destroyed.
+     * @param level the compression level, or -1 for the codec's default
+     */
+    virtual std::unique_ptr<std::ostream> open_ostream(std::ostream& os, int level = -1) const = 0;
+};
+
+///Returns the codec for the compression scheme, or null if it is not available
+NBT_EXPORT const codec* get_codec(compression scheme);
+
+///Returns the codec with the given name, or null if it is not available
+NBT_EXPORT const codec* find_codec(const std::string& name);
+
+///Returns all available codecs
+NBT_EXPORT std::vector<const codec*> available_codecs();
+
+}
+}
+
+#endif // CODEC_H_INCLUDED
@@ -0,0 +1,99 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef IMEMSTREAM_H_INCLUDED
+#define IMEMSTREAM_H_INCLUDED
+
+#include <istream>
+#include <streambuf>
+#include <string>
+#include "nbt_export.h"
+
+namespace nbt
+{
+namespace io
+{
+
+/**
+ * @brief Stream buffer used by io::imemstream
+ *
+ * Reads directly from a contiguous block of memory without copying it.
+ * The memory must stay valid for as long as the buffer is in use.
+ * @sa imemstream
+ */
+class NBT_EXPORT imem_streambuf : public std::streambuf
+{
+public:
+    /**
+     * @param data pointer to the first byte of the block
+     * @param size the length of the block in bytes
+     */
+    imem_streambuf(const char* data, size_t size);
+
+    ///Returns a pointer to the current read position
+    const char* cur() const { return gptr(); }
+
+    ///Returns the number of bytes that are left to read
+    size_t remaining() const { return egptr() - gptr(); }
+
+    /**
+     * @brief Advances the read position by n bytes
+     *
+     * No bounds checking is performed, @c n must not exceed remaining().
+     */
+    void advance(size_t n) { setg(eback(), gptr() + n, egptr()); }
+
+private:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+/**
+ * @brief An istream that reads from a contiguous block of memory
+ *
+ * In contrast to std::istringstream, the data is not copied. When an
+ * io::stream_reader reads from an imemstream, it bypasses most of the
+ * std::istream machinery and decodes directly from the memory block.
+ *
+ * The memory must stay valid for as long as the stream is in use.
+ */
+class NBT_EXPORT imemstream : public std::istream
+{
+public:
+    /**
+     * @param data pointer to the first byte of the block
+     * @param size the length of the block in bytes
+     */
+    imemstream(const char* data, size_t size):
+        std::istream(&buf), buf(data, size)
+    {}
+
+    ///Reads from the contents of the given string, which must outlive the stream
+    explicit imemstream(const std::string& str):
+        imemstream(str.data(), str.size())
+    {}
+
+private:
+    imem_streambuf buf;
+};
+
+}
+}
+
+#endif // IMEMSTREAM_H_INCLUDED
@@ -0,0 +1,90 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LEVEL_DAT_H_INCLUDED
+#define LEVEL_DAT_H_INCLUDED
+
+#include "tag_compound.h"
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace nbt
+{
+namespace io
+{
+
+/**
+ * @brief The 8 byte header in front of the NBT data in level.dat files of
+ * the Bedrock edition
+ *
+ * Both fields are stored in little endian.
+ */
+struct level_dat_header
+{
+    ///The storage version of the world
+    int32_t version;
+    ///The length in bytes of the named tag that follows
+    uint32_t length;
+};
+
+///The contents of a Bedrock edition level.dat file
+struct level_dat
+{
+    ///The storage version of the world
+    int32_t version;
+    ///The name of the root tag, usually empty
+    std::string name;
+    std::unique_ptr<tag_compound> root;
+};
+
+/**
+ * @brief Reads the header of a Bedrock edition level.dat file
+ * @throw input_error on failure
+ */
+NBT_EXPORT level_dat_header read_level_dat_header(std::istream& is);
+
+///Writes the header of a Bedrock edition level.dat file
+NBT_EXPORT void write_level_dat_header(std::ostream& os, const level_dat_header& header);
+
+/**
+ * @brief Reads a Bedrock edition level.dat file
+ *
+ * The header is followed by a named compound in little endian. The
+ * compound is decoded from memory, see stream_reader.
+ * @throw input_error on failure, if the tag is not a compound, or if its
+ * length does not match the header
+ */
+NBT_EXPORT level_dat read_level_dat(std::istream& is);
+
+/**
+ * @brief Writes a Bedrock edition level.dat file
+ * @param version the storage version of the world
+ * @param key the name of the root tag
+ * @param root the root tag
+ * @param os the stream to write to
+ * @throw std::length_error if the tag is too large
+ */
+NBT_EXPORT void write_level_dat(int32_t version, const std::string& key, const tag_compound& root, std::ostream& os);
+
+}
+}
+
+#endif // LEVEL_DAT_H_INCLUDED
@@ -0,0 +1,198 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LZ4STREAM_H_INCLUDED
+#define LZ4STREAM_H_INCLUDED
+
+#include "io/codec.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "nbt_export.h"
+
+/**
+ * @brief LZ4 compression in the block stream format of lz4-java
+ *
+ * This is the format that Minecraft uses for chunks with compression type 4.
+ * The data is split into blocks of at most 64 KiB (by default), and each
+ * block is preceded by a 21 byte header:
+ *
+ * - the magic "LZ4Block"
+ * - a token, 0x10 for stored or 0x20 for LZ4 compressed blocks, plus the
+ *   base two logarithm of the block size minus 10
+ * - the compressed and the original size, as 32 bit little endian
+ * - an XXH32 checksum of the original data, see lz4::checksum
+ *
+ * The stream ends with an empty stored block.
+ */
+namespace lz4
+{
+
+///The default size of the blocks
+constexpr size_t default_block_size = 1 << 16;
+
+/**
+ * @brief Returns the checksum of a block as stored in its header
+ *
+ * This is the XXH32 hash with seed 0x9747b28c, of which lz4-java only
+ * keeps the lower 28 bits.
+ */
+NBT_EXPORT uint32_t checksum(const char* data, size_t size);
+
+/**
+ * @brief Compresses the data into a block stream
+ *
+ * The contents of @c out are replaced.
+ * @param level the compression level, 0 for fast LZ4 or 1 to 12 for LZ4 HC,
+ * or -1 for default (fast)
+ * @param block_size the maximum size of the blocks, a power of two between
+ * 1 KiB and 32 MiB
+ * @throw nbt::io::codec_error if the arguments are invalid
+ */
+NBT_EXPORT void compress(const char* data, size_t size, std::string& out, int level = -1,
+                         size_t block_size = default_block_size);
+
+/**
+ * @brief Decompresses a block stream
+ *
+ * The contents of @c out are replaced. Decompression stops at the end mark.
+ * @param size_hint the expected size of the decompressed data, or 0 if unknown
+ * @throw nbt::io::codec_error if the data is corrupt or truncated, or a
+ * checksum doesn't match
+ */
+NBT_EXPORT void decompress(const char* data, size_t size, std::string& out, size_t size_hint = 0);
+
+/**
+ * @brief Stream buffer used by lz4::ilz4stream
+ * @sa ilz4stream
+ */
+class NBT_EXPORT decompress_streambuf : public std::streambuf
+{
+public:
+    ///@param input the istream to wrap
+    explicit decompress_streambuf(std::istream& input):
+        is(input)
+    {}
+
+    ///@return the wrapped istream
+    std::istream& get_istr() const { return is; }
+
+private:
+    std::istream& is;
+    std::vector<char> in;
+    std::vector<char> out;
+    bool stream_end = false;
+
+    int_type underflow() override;
+};
+
+/**
+ * @brief An istream adapter that decompresses an LZ4 block stream
+ *
+ * The blocks are read from the wrapped istream one at a time, and reading
+ * stops exactly after the end mark.
+ * @sa decompress_streambuf
+ */
+class NBT_EXPORT ilz4stream : public std::istream
+{
+public:
+    ///@param input the istream to wrap
+    explicit ilz4stream(std::istream& input):
+        std::istream(&buf), buf(input)
+    {}
+
+    ///@return the wrapped istream
+    std::istream& get_istr() const { return buf.get_istr(); }
+
+private:
+    decompress_streambuf buf;
+};
+
+/**
+ * @brief Stream buffer used by lz4::olz4stream
+ * @sa olz4stream
+ */
+class NBT_EXPORT compress_streambuf : public std::streambuf
+{
+public:
+    /**
+     * @param output the ostream to wrap
+     * @param level the compression level, see lz4::compress
+     * @param block_size the maximum size of the blocks, see lz4::compress
+     * @throw nbt::io::codec_error if the arguments are invalid
+     */
+    explicit compress_streambuf(std::ostream& output, int level = -1, size_t block_size = default_block_size);
+    ~compress_streambuf() noexcept;
+
+    ///@return the wrapped ostream
+    std::ostream& get_ostr() const { return os; }
+
+    ///Writes the pending data and the end mark to the output
+    void close();
+
+    ///@return true if the end mark has not been written yet
+    bool is_open() const { return is_open_; }
+
+private:
+    std::ostream& os;
+    int level;
+    std::vector<char> in;
+    std::string out;
+    bool is_open_ = true;
+
+    void write_block();
+
+    int_type overflow(int_type ch) override;
+    int sync() override;
+};
+
+/**
+ * @brief An ostream adapter that compresses data into an LZ4 block stream
+ *
+ * The end mark is written by close() or when the stream is destroyed.
+ * @sa compress_streambuf
+ */
+class NBT_EXPORT olz4stream : public std::ostream
+{
+public:
+    /**
+     * @param output the ostream to wrap
+     * @param level the compression level, see lz4::compress
+     * @param block_size the maximum size of the blocks, see lz4::compress
+     */
+    explicit olz4stream(std::ostream& output, int level = -1, size_t block_size = default_block_size):
+        std::ostream(&buf), buf(output, level, block_size)
+    {}
+
+    ///@return the wrapped ostream
+    std::ostream& get_ostr() const { return buf.get_ostr(); }
+
+    ///Writes the pending data and the end mark to the output
+    void close();
+
+private:
+    compress_streambuf buf;
+};
+
+}
+
+#endif // LZ4STREAM_H_INCLUDED
@@ -0,0 +1,163 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OMEMSTREAM_H_INCLUDED
+#define OMEMSTREAM_H_INCLUDED
+
+#include <climits>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include "nbt_export.h"
+
+namespace nbt
+{
+namespace io
+{
+
+/**
+ * @brief Stream buffer used by io::omemstream
+ *
+ * Writes into a contiguous block of memory. The block is either owned by
+ * the buffer and grows as needed, or provided by the caller and has a
+ * fixed size, in which case writing past its end fails.
+ * @sa omemstream
+ */
+class NBT_EXPORT omem_streambuf : public std::streambuf
+{
+public:
+    ///Writes into an internal buffer that initially has room for @c capacity bytes
+    explicit omem_streambuf(size_t capacity = 0);
+
+    /**
+     * @brief Writes into the given block of memory
+     *
+     * The memory must stay valid for as long as the buffer is in use.
+     */
+    omem_streambuf(char* data, size_t size);
+
+    omem_streambuf(const omem_streambuf&) = delete;
+    omem_streambuf& operator=(const omem_streambuf&) = delete;
+
+    ///Returns a pointer to the written data
+    const char* data() const { return pbase(); }
+    ///Returns the number of bytes that have been written
+    size_t size() const { return pptr() - pbase(); }
+    ///Returns the number of bytes that can be written without growing
+    size_t capacity() const { return epptr() - pbase(); }
+
+    /**
+     * @brief Returns a pointer where n bytes can be written, growing the
+     * buffer if necessary
+     *
+     * The bytes only become part of the output once advance() is called.
+     * @return null if the buffer has a fixed size that is too small
+     */
+    char* reserve(size_t n)
+    {
+        if(static_cast<size_t>(epptr() - pptr()) >= n || grow(n))
+            return pptr();
+        return nullptr;
+    }
+
+    /**
+     * @brief Advances the write position by n bytes
+     *
+     * No bounds checking is performed, the bytes must have been reserved.
+     */
+    void advance(size_t n)
+    {
+        if(n <= INT_MAX)
+            pbump(static_cast<int>(n));
+        else
+            advance_large(n);
+    }
+
+    ///Returns a copy of the written data
+    std::string str() const { return std::string(data(), size()); }
+
+    /**
+     * @brief Moves the written data out of an internal buffer and clears it
+     *
+     * For a buffer with a fixed size, the data is copied instead.
+     */
+    std::string take();
+
+    ///Discards the written data, keeping the memory for reuse
+    void clear() { setp(pbase(), epptr()); }
+
+private:
+    std::string storage;
+    bool fixed;
+
+    bool grow(size_t n);
+    void advance_large(size_t n);
+
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+};
+
+/**
+ * @brief An ostream that writes into a contiguous block of memory
+ *
+ * When an io::stream_writer writes to an omemstream, it bypasses the
+ * std::ostream machinery and encodes directly into the memory block. The
+ * result can then be passed on as a whole, e.g. to a compressor or a file.
+ */
+class NBT_EXPORT omemstream : public std::ostream
+{
+public:
+    ///Writes into an internal buffer that initially has room for @c capacity bytes
+    explicit omemstream(size_t capacity = 0):
+        std::ostream(&buf), buf(capacity)
+    {}
+
+    /**
+     * @brief Writes into the given block of memory, which must outlive the stream
+     *
+     * Writing more than @c size bytes sets the badbit.
+     */
+    omemstream(char* data, size_t size):
+        std::ostream(&buf), buf(data, size)
+    {}
+
+    ///Returns the stream buffer
+    omem_streambuf* rdbuf() const { return &buf; }
+
+    ///Returns a pointer to the written data
+    const char* data() const { return buf.data(); }
+    ///Returns the number of bytes that have been written
+    size_t size() const { return buf.size(); }
+    ///Returns a copy of the written data
+    std::string str() const { return buf.str(); }
+    ///Moves the written data out of the stream and clears it
+    std::string take() { return buf.take(); }
+
+    ///Discards the written data and clears the stream's error state
+    void reset() { buf.clear(); clear(); }
+
+private:
+    mutable omem_streambuf buf;
+};
+
+}
+}
+
+#endif // OMEMSTREAM_H_INCLUDED
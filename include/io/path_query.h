@@ -0,0 +1,123 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PATH_QUERY_H_INCLUDED
+#define PATH_QUERY_H_INCLUDED
+
+#include "endian_str.h"
+#include "tag.h"
+#include "value.h"
+#include <initializer_list>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace nbt
+{
+namespace io
+{
+
+class stream_reader;
+
+/**
+ * @brief Extracts the values at given paths from a tag in a stream
+ *
+ * The query walks through the binary data and only constructs the tags that
+ * are matched by one of the paths. All other subtrees are skipped at byte
+ * level with stream_reader::skip_payload.
+ *
+ * A path is a sequence of keys separated by dots, each of which can be
+ * followed by list indices in brackets, e.g. @c DataVersion or
+ * @c Level.Sections[*].Y . The key @c * matches all keys of a compound and
+ * the index @c [*] matches all elements of a list. Keys that contain dots,
+ * brackets or quotes can be written in double quotes, inside of which a
+ * backslash escapes the next character. Paths start inside the root tag,
+ * whose name is ignored.
+ *
+ * Example:
+ * @code
+ * io::path_query query{"DataVersion", "Level.Sections[*].Y"};
+ * auto result = query.run(stream);
+ * int32_t version = static_cast<int32_t>(result[0].at(0));
+ * @endcode
+ */
+class NBT_EXPORT path_query
+{
+public:
+    ///For each path, the matched values in the order they appear in the stream
+    typedef std::vector<std::vector<value>> result_type;
+
+    /**
+     * @brief Parses the given paths
+     * @throw std::invalid_argument if one of the paths is malformed
+     */
+    path_query(std::initializer_list<std::string> paths);
+    explicit path_query(const std::vector<std::string>& paths);
+
+    ///Returns the number of paths
+    size_t size() const { return paths.size(); }
+
+    /**
+     * @brief Reads a named tag with the reader and extracts the values
+     * @throw input_error on failure
+     */
+    result_type run(stream_reader& reader) const;
+
+    /**
+     * @brief Reads a named tag from the stream and extracts the values
+     * @throw input_error on failure
+     */
+    result_type run(std::istream& is, endian::endian e = endian::big) const;
+
+private:
+    struct segment
+    {
+        enum kind_t { key, any_key, index, any_index } kind;
+        std::string name;
+        int32_t idx;
+    };
+
+    ///Position within one of the paths
+    struct state
+    {
+        size_t path;
+        size_t pos;
+    };
+
+    std::vector<std::vector<segment>> paths;
+
+    static std::vector<segment> parse(const std::string& path);
+
+    template<class Pred>
+    void advance(const std::vector<state>& states, Pred matches,
+                 std::vector<size_t>& ended, std::vector<state>& next) const;
+
+    void walk_payload(stream_reader& reader, tag_type type,
+                      const std::vector<state>& states, result_type& result) const;
+    void walk_child(stream_reader& reader, tag_type type, const std::vector<size_t>& ended,
+                    const std::vector<state>& next, result_type& result) const;
+    void walk_tag(const tag& t, const std::vector<state>& states, result_type& result) const;
+    void collect(const tag& t, const std::vector<size_t>& ended,
+                 const std::vector<state>& next, result_type& result) const;
+};
+
+}
+}
+
+#endif // PATH_QUERY_H_INCLUDED
@@ -0,0 +1,132 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef REGION_DECODER_H_INCLUDED
+#define REGION_DECODER_H_INCLUDED
+
+#include "io/region_reader.h"
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nbt
+{
+namespace io
+{
+
+/**
+ * @brief Decodes all chunks of a set of region files on several threads
+ *
+ * Every worker thread has its own queue of tasks. A task either opens a
+ * region file, which queues the decoding of each of its chunks on the same
+ * worker, or decompresses and reads one chunk. Workers that run out of tasks
+ * steal from the other end of another worker's queue, which keeps all
+ * threads busy even though the size of chunks and region files varies a lot.
+ *
+ * Example:
+ * @code
+ * io::region_decoder decoder;
+ * decoder.add_directory("world/region");
+ * decoder.run([](io::region_decoder::chunk& c) {
+ *     if(c.error)
+ *         std::rethrow_exception(c.error);
+ *     convert(c.file, c.x, c.z, *c.data);
+ * });
+ * @endcode
+ */
+class NBT_EXPORT region_decoder
+{
+public:
+    ///A decoded chunk, or the error that occurred when decoding it
+    struct chunk
+    {
+        ///Path of the region file
+        std::string file;
+        /**
+         * Coordinates of the chunk relative to the region, or -1 if the
+         * error concerns the region file as a whole
+         */
+        int x = -1;
+        int z = -1;
+        ///Time of the last modification in seconds since the epoch
+        int32_t timestamp = 0;
+        ///The chunk's root compound, or null if an error occurred
+        std::unique_ptr<tag_compound> data;
+        ///The exception that was thrown while decoding the chunk, if any
+        std::exception_ptr error;
+    };
+
+    typedef std::function<void(chunk&)> callback;
+
+    /**
+     * @brief Creates a decoder that uses the given number of threads
+     *
+     * The calling thread of run counts as one of them. If @p threads is 0,
+     * the number of hardware threads is used.
+     */
+    explicit region_decoder(unsigned threads = 0);
+
+    ///Returns the number of threads that run will use
+    unsigned threads() const { return num_threads; }
+
+    ///Adds a region file to be decoded
+    void add_file(const std::string& path);
+
+    /**
+     * @brief Adds all region files (*.mca) in the given directory
+     * @throw input_error if the directory cannot be read
+     */
+    void add_directory(const std::string& path);
+
+    ///Returns the paths of the region files that have been added
+    const std::vector<std::string>& files() const { return paths; }
+
+    /**
+     * @brief Decodes all chunks and passes each of them to the callback
+     *
+     * The callback is called on the worker threads as soon as a chunk has
+     * been decoded, so it may be called concurrently and in any order.
+     * Chunks that cannot be read and region files that cannot be opened
+     * are passed with the error set instead of throwing. External chunks
+     * are reported the same way.
+     *
+     * If the callback throws, the remaining tasks are dropped and the first
+     * exception is rethrown once all threads have finished.
+     */
+    void run(const callback& cb) const;
+
+    /**
+     * @brief Decodes all chunks and returns them
+     *
+     * The chunks are sorted by file in the order they were added, then by
+     * their position in the region.
+     */
+    std::vector<chunk> decode_all() const;
+
+private:
+    unsigned num_threads;
+    std::vector<std::string> paths;
+};
+
+}
+}
+
+#endif // REGION_DECODER_H_INCLUDED
@@ -0,0 +1,150 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef REGION_READER_H_INCLUDED
+#define REGION_READER_H_INCLUDED
+
+#include "tag_compound.h"
+#include "io/codec.h"
+#include "io/zlib_streambuf.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace nbt
+{
+namespace io
+{
+
+/**
+ * @brief Reads chunks from an Anvil region file (.mca)
+ *
+ * A region file holds the chunks of a 32x32 chunk area. It starts with a
+ * table of the chunks' locations and a table of their timestamps, 4 KiB
+ * each, followed by the chunks, which are compressed individually.
+ *
+ * The file is memory-mapped, and the compressed data of the chunks is handed
+ * out without copying. All const member functions can be called from
+ * several threads at once.
+ *
+ * The chunk coordinates passed to the member functions can be absolute or
+ * relative to the region, only their lowest five bits are used.
+ */
+class NBT_EXPORT region_reader
+{
+public:
+    ///Number of chunks along each side of a region
+    static constexpr int region_size = 32;
+    ///Number of chunks in a region
+    static constexpr int chunk_count = region_size * region_size;
+    ///Size of a sector, the unit in which space in the file is allocated
+    static constexpr size_t sector_size = 4096;
+
+    typedef io::compression compression;
+
+    ///The raw data of a chunk in the file
+    struct chunk_data
+    {
+        /**
+         * Pointer to the compressed data, or null if the chunk doesn't exist.
+         * With compression::custom, the data start with the name of the
+         * codec as a string in NBT format.
+         */
+        const char* data = nullptr;
+        ///Size of the compressed data
+        size_t size = 0;
+        compression scheme = compression::zlib;
+        /**
+         * True if the chunk is too large for the region file and stored in
+         * a separate file c.x.z.mcc instead. In that case, data is null.
+         */
+        bool external = false;
+        ///Time of the last modification in seconds since the epoch
+        int32_t timestamp = 0;
+
+        ///Returns true if the chunk exists
+        explicit operator bool() const { return data != nullptr || external; }
+    };
+
+    /**
+     * @brief Memory-maps the region file at the given path
+     *
+     * Empty files are treated as regions without chunks.
+     * @throw input_error if the file cannot be opened or mapped, or if its
+     * header is truncated
+     */
+    explicit region_reader(const std::string& path);
+
+    /**
+     * @brief Reads the region from a block of memory
+     *
+     * The memory must stay valid for as long as the reader is in use.
+     * @throw input_error if the header is truncated
+     */
+    region_reader(const char* data, size_t size);
+
+    region_reader(region_reader&&) noexcept;
+    region_reader& operator=(region_reader&&) noexcept;
+    ~region_reader() noexcept;
+
+    ///Returns true if the chunk exists
+    bool has_chunk(int x, int z) const;
+
+    /**
+     * @brief Returns the raw data of a chunk
+     *
+     * The returned data point into the file and stay valid for as long as
+     * the reader exists.
+     * @throw input_error if the location of the chunk is invalid
+     */
+    chunk_data get_chunk(int x, int z) const;
+
+    /**
+     * @brief Decompresses the data of a chunk into the given buffer
+     *
+     * The codec is chosen by the chunk's compression scheme, see get_codec.
+     * Chunks with compression::custom are decompressed by the codec that
+     * find_codec returns for the name in front of the data.
+     * Passing the same buffer for many chunks avoids reallocations.
+     * @throw input_error if the codec is not available or the chunk is external
+     * @throw zlib::zlib_error or codec_error if the data is corrupt
+     */
+    static void decompress(const chunk_data& chunk, std::string& out);
+
+    /**
+     * @brief Decompresses and reads a chunk
+     * @return the chunk's root compound, or null if the chunk doesn't exist
+     * @throw input_error if the chunk cannot be read
+     * @throw zlib::zlib_error or codec_error if the data is corrupt
+     */
+    std::unique_ptr<tag_compound> read_chunk(int x, int z) const;
+
+private:
+    struct mapping;
+    std::unique_ptr<mapping> map;
+    const char* data;
+    size_t size;
+
+    void check_header() const;
+};
+
+}
+}
+
+#endif // REGION_READER_H_INCLUDED
@@ -0,0 +1,151 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef REGION_WRITER_H_INCLUDED
+#define REGION_WRITER_H_INCLUDED
+
+#include "io/region_reader.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace nbt
+{
+namespace io
+{
+
+/**
+ * @brief Writes chunks into an Anvil region file (.mca)
+ *
+ * Only the chunks that are written are touched in the file. A chunk that
+ * still fits into the sectors it occupied before is rewritten in place,
+ * otherwise it is moved to the first free run of sectors that is large
+ * enough, which is tracked in a bitmap of the file's sectors. Sectors that
+ * become free are reused, but the file only shrinks when compact is called.
+ *
+ * The location and timestamp of a chunk are updated in the header right
+ * after its data has been written.
+ *
+ * Errors when accessing the file are reported with std::ios_base::failure.
+ */
+class NBT_EXPORT region_writer
+{
+public:
+    typedef region_reader::compression compression;
+
+    ///Maximum number of sectors that a chunk can occupy
+    static constexpr size_t max_chunk_sectors = 255;
+
+    /**
+     * @brief Opens the region file at the given path, or creates it if it
+     * doesn't exist
+     * @throw input_error if the header of the file is truncated or contains
+     * invalid or overlapping chunk locations
+     * @throw std::ios_base::failure if the file cannot be opened
+     */
+    explicit region_writer(const std::string& path);
+
+    region_writer(region_writer&&) = default;
+    region_writer& operator=(region_writer&&) = default;
+
+    ///Returns true if the chunk exists
+    bool has_chunk(int x, int z) const;
+
+    /**
+     * @brief Serializes and compresses a chunk and writes it into the file
+     * @param level the compression level, or -1 for the codec's default
+     * @param timestamp the time of the modification in seconds since the
+     * epoch, or -1 for the current time
+     * @throw std::length_error if the compressed chunk is larger than
+     * max_chunk_sectors sectors
+     * @throw std::invalid_argument if get_codec returns no codec for the scheme
+     * @throw std::filesystem::filesystem_error if the chunk was stored in an
+     * external file before, which cannot be deleted
+     */
+    void write_chunk(int x, int z, const tag_compound& data, compression scheme = compression::zlib,
+                     int level = -1, int32_t timestamp = -1);
+
+    /**
+     * @brief Serializes and compresses a chunk with the given codec
+     *
+     * Codecs without a compression scheme of their own, such as zstd, are
+     * stored as compression::custom, preceded by the name of the codec.
+     * @copydetails write_chunk(int, int, const tag_compound&, compression, int, int32_t)
+     */
+    void write_chunk(int x, int z, const tag_compound& data, const codec& c,
+                     int level = -1, int32_t timestamp = -1);
+
+    /**
+     * @brief Writes already compressed chunk data into the file
+     *
+     * With compression::custom, the data must start with the name of the
+     * codec, see region_reader::chunk_data.
+     *
+     * If the chunk was stored in an external file c.x.z.mcc before, that
+     * file is deleted, unless the external flag (0x80) is set in @p scheme.
+     * @throw std::length_error if the data is larger than max_chunk_sectors sectors
+     * @throw std::filesystem::filesystem_error if the external file cannot be deleted
+     */
+    void write_chunk_data(int x, int z, const char* data, size_t size, compression scheme,
+                          int32_t timestamp = -1);
+
+    /**
+     * @brief Removes the chunk from the region and frees its sectors
+     *
+     * Also deletes the external file c.x.z.mcc if the chunk was stored in one.
+     * @throw std::filesystem::filesystem_error if the external file cannot be deleted
+     */
+    void remove_chunk(int x, int z);
+
+    /**
+     * @brief Moves all chunks to the front of the file, in the order they
+     * appear in the file, and truncates it after the last chunk
+     * @throw std::filesystem::filesystem_error if the file cannot be truncated
+     */
+    void compact();
+
+    ///Writes all buffered data to the file
+    void flush();
+
+    ///Returns the number of sectors in the file, including the header
+    size_t sector_count() const { return used.size(); }
+    ///Returns the number of sectors that are not used by any chunk
+    size_t free_sectors() const;
+
+private:
+    std::string path;
+    std::fstream file;
+    ///Location table, the sector offset in the upper 24 bits and the sector count in the lower 8
+    std::vector<uint32_t> locations;
+    ///Bitmap of the sectors that are in use
+    std::vector<bool> used;
+
+    static int chunk_index(int x, int z);
+    size_t allocate(size_t count);
+    void mark(uint32_t loc, bool value);
+    ///Returns true if the chunk at the location is stored in an external file
+    bool is_external(uint32_t loc);
+    void write_header_entry(int index, int32_t timestamp);
+};
+
+}
+}
+
+#endif // REGION_WRITER_H_INCLUDED
@@ -23,13 +23,58 @@
 #include "endian_str.h"
 #include "tag.h"
 #include "tag_compound.h"
-#include <iosfwd>
+#include "io/imemstream.h"
+#include "io/stream_visitor.h"
+#include "stats.h"
+#include "varint.h"
+#include <algorithm>
+#include <istream>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
 
 namespace nbt
 {
+
+namespace detail
+{
+    /**
+     * @brief The bytes of a compound or list payload that has not been decoded yet
+     * @sa io::stream_reader::set_lazy
+     */
+    struct lazy_payload
+    {
+        ///The buffer holding the payload, possibly shared with other payloads
+        std::shared_ptr<const std::string> buf;
+        size_t offset;
+        size_t size;
+        endian::endian endian;
+    };
+
+    /**
+     * @brief Reads @p n elements into the vector or string @p c
+     *
+     * The container grows block by block, so that a bogus length can't make
+     * us allocate huge amounts of memory before we hit the end of the input.
+     * @param read called as read(dst, len) to read len elements to dst
+     * @param is the stream that @p read reads from. Reading stops when it fails.
+     */
+    template<class Container, class Read>
+    void read_in_blocks(Container& c, size_t n, const std::istream& is, Read&& read)
+    {
+        const size_t block_len = 65536;
+        c.clear();
+        for(size_t i = 0; i < n && is; i += block_len)
+        {
+            size_t len = std::min(block_len, n - i);
+            c.resize(i + len);
+            read(&c[i], len);
+        }
+    }
+}
+
 namespace io
 {
 
@@ -43,7 +88,8 @@ class NBT_EXPORT input_error : public std::runtime_error
  * @brief Reads a named tag from the stream, making sure that it is a compound
  * @param is the stream to read from
  * @param e the byte order of the source data. The Java edition
- * of Minecraft uses Big Endian, the Pocket edition uses Little Endian
+ * of Minecraft uses Big Endian, the Pocket edition uses Little Endian,
+ * its network protocol endian::network
  * @throw input_error on failure, or if the tag in the stream is not a compound
  */
 NBT_EXPORT std::pair<std::string, std::unique_ptr<tag_compound>> read_compound(std::istream& is, endian::endian e = endian::big);
@@ -52,7 +98,8 @@ NBT_EXPORT std::pair<std::string, std::unique_ptr<tag_compound>> read_compound(s
  * @brief Reads a named tag from the stream
  * @param is the stream to read from
  * @param e the byte order of the source data. The Java edition
- * of Minecraft uses Big Endian, the Pocket edition uses Little Endian
+ * of Minecraft uses Big Endian, the Pocket edition uses Little Endian,
+ * its network protocol endian::network
  * @throw input_error on failure
  */
 NBT_EXPORT std::pair<std::string, std::unique_ptr<tag>> read_tag(std::istream& is, endian::endian e = endian::big);
@@ -60,7 +107,12 @@ NBT_EXPORT std::pair<std::string, std::unique_ptr<tag>> read_tag(std::istream& i
 /**
  * @brief Helper class for reading NBT tags from input streams
  *
- * Can be reused to read multiple tags
+ * Can be reused to read multiple tags.
+ *
+ * If the stream reads from an io::imem_streambuf (e.g. an io::imemstream),
+ * numbers and strings are decoded directly from the memory block, which is
+ * a lot faster than going through the std::istream interface. Such streams
+ * also support lazy reading, see set_lazy().
  */
 class NBT_EXPORT stream_reader
 {
@@ -68,7 +120,8 @@ public:
     /**
      * @param is the stream to read from
      * @param e the byte order of the source data. The Java edition
-     * of Minecraft uses Big Endian, the Pocket edition uses Little Endian
+     * of Minecraft uses Big Endian, the Pocket edition uses Little Endian,
+     * its network protocol endian::network
      */
     explicit stream_reader(std::istream& is, endian::endian e = endian::big) noexcept;
 
@@ -77,6 +130,24 @@ public:
     ///Returns the byte order
     endian::endian get_endian() const;
 
+    /**
+     * @brief Enables or disables lazy reading
+     *
+     * In lazy mode, the payloads of compounds and lists that are nested in
+     * the tag being read are only validated and copied as raw bytes. They
+     * are decoded one level at a time when they are first accessed, so
+     * reading a few values from a large tree doesn't need to construct all
+     * the others. The tag returned by read_compound or read_tag itself is
+     * decoded right away, while read_payload also records it. Decoding can still throw
+     * std::bad_alloc, but no input_error since the data has been validated.
+     *
+     * Lazy reading only works if the stream reads from an
+     * io::imem_streambuf. Otherwise, everything is decoded right away.
+     */
+    void set_lazy(bool lazy) { lazy_ = lazy; }
+    ///Returns true if lazy reading is enabled
+    bool is_lazy() const { return lazy_; }
+
     /**
      * @brief Reads a named tag from the stream, making sure that it is a compound
      * @throw input_error on failure, or if the tag in the stream is not a compound
@@ -95,6 +166,51 @@ public:
      */
     std::unique_ptr<tag> read_payload(tag_type type);
 
+    /**
+     * @brief Skips over a tag payload of the given type
+     *
+     * Validates the payload like reading it would, but does not construct
+     * any tags.
+     * @throw input_error on failure
+     */
+    void skip_payload(tag_type type);
+
+    /**
+     * @brief Parses a named tag from the stream, reporting it to the visitor
+     *
+     * No tags are constructed, see stream_visitor.
+     * @return false if the visitor stopped parsing, true otherwise
+     * @throw input_error on failure
+     */
+    bool parse(stream_visitor& visitor);
+
+    /**
+     * @brief Parses a tag payload of the given type, reporting it to the visitor
+     * @return false if the visitor stopped parsing, true otherwise
+     * @throw input_error on failure
+     */
+    bool parse_payload(tag_type type, stream_visitor& visitor);
+
+    /**
+     * @brief Records the payload of a compound or list for lazy reading
+     *
+     * Skips over the payload and returns its bytes, or returns null without
+     * reading anything if the reader is not in lazy mode, the stream does
+     * not read from memory, or the payload is not nested in a tag that is
+     * read with read_payload.
+     * @throw input_error on failure
+     */
+    std::shared_ptr<const detail::lazy_payload> record_payload(tag_type type);
+
+    /**
+     * @brief Decodes a payload that has been recorded with record_payload
+     *
+     * Calls @c read with a lazy reader over the recorded bytes. Payloads
+     * recorded by that reader share the buffer instead of copying it.
+     */
+    template<class F>
+    static void read_recorded(const detail::lazy_payload& payload, F&& read);
+
     /**
      * @brief Reads a tag type from the stream
      * @param allow_end whether to consider tag_type::End valid
@@ -105,29 +221,199 @@ public:
     /**
      * @brief Reads a binary number from the stream
      *
+     * With endian::network, 32 and 64 bit integers are read as zigzag
+     * encoded varints.
      * On failure, will set the failbit on the stream.
      */
     template<class T>
     void read_num(T& x);
 
+    /**
+     * @brief Reads an array of binary numbers from the stream
+     *
+     * Much faster than calling read_num for each element.
+     * On failure, will set the failbit on the stream.
+     */
+    template<class T>
+    void read_array(T* arr, size_t n);
+
+    /**
+     * @brief Skips an array of binary numbers in the stream
+     *
+     * Varints are validated like read_array would.
+     * On failure, will set the failbit on the stream.
+     */
+    template<class T>
+    void skip_array(size_t n);
+
+    /**
+     * @brief Reads raw bytes from the stream
+     *
+     * On failure, will set the failbit on the stream.
+     */
+    void read_raw(char* dst, size_t n);
+
+    /**
+     * @brief Skips raw bytes in the stream
+     *
+     * On failure, will set the failbit on the stream.
+     */
+    void skip_raw(size_t n);
+
     /**
      * @brief Reads an NBT string from the stream
      *
-     * An NBT string consists of two bytes indicating the length, followed by
-     * the characters encoded in modified UTF-8.
+     * An NBT string consists of two bytes indicating the length (a varint
+     * with endian::network), followed by the characters encoded in modified UTF-8.
      * @throw input_error on failure
      */
     std::string read_string();
 
 private:
     std::istream& is;
+    ///The stream's buffer if it reads from memory, otherwise null
+    imem_streambuf* const mem_buf;
     const endian::endian endian;
+    bool lazy_ = false;
+    ///Number of nested read_payload calls
+    unsigned nesting = 0;
+    ///The buffer that mem_buf reads from when decoding a recorded payload
+    std::shared_ptr<const std::string> lazy_buf;
+
+    ///Returns true if n bytes can be taken from mem_buf directly
+    bool mem_available(size_t n) const
+    { return mem_buf && is.good() && is.rdbuf() == mem_buf && mem_buf->remaining() >= n; }
+
+    ///Reads the length of a string
+    size_t read_string_length();
+
+    ///Reads an unsigned varint, returns false on failure
+    template<class U>
+    bool read_varint(U& x);
+    ///Reads n zigzag encoded varints
+    template<class T>
+    void read_varint_array(T* arr, size_t n);
 };
 
 template<class T>
 void stream_reader::read_num(T& x)
 {
-    endian::read(is, x, endian);
+    if constexpr(varint::is_encoded<T>)
+        if(endian == endian::network)
+        {
+            std::make_unsigned_t<T> u;
+            if(read_varint(u))
+                x = varint::zigzag_decode(u);
+            return;
+        }
+    stats::detail::bytes_read(sizeof(T));
+    if(mem_available(sizeof(T)))
+    {
+        endian::read(mem_buf->cur(), x, endian);
+        mem_buf->advance(sizeof(T));
+    }
+    else
+        endian::read(is, x, endian);
+}
+
+template<class T>
+void stream_reader::read_array(T* arr, size_t n)
+{
+    if constexpr(varint::is_encoded<T>)
+        if(endian == endian::network)
+            return read_varint_array(arr, n);
+    stats::detail::bytes_read(n * sizeof(T));
+    if(mem_available(n * sizeof(T)))
+    {
+        std::memcpy(arr, mem_buf->cur(), n * sizeof(T));
+        mem_buf->advance(n * sizeof(T));
+        endian::convert_array(arr, n, endian);
+    }
+    else
+        endian::read_array(is, arr, n, endian);
+}
+
+template<class T>
+void stream_reader::skip_array(size_t n)
+{
+    if constexpr(varint::is_encoded<T>)
+        if(endian == endian::network)
+        {
+            //The lengths are not known without decoding
+            T buf[1024];
+            for(size_t len; n > 0 && is; n -= len)
+            {
+                len = std::min(n, sizeof(buf) / sizeof(T));
+                read_varint_array(buf, len);
+            }
+            return;
+        }
+    skip_raw(n * sizeof(T));
+}
+
+template<class U>
+bool stream_reader::read_varint(U& x)
+{
+    if(mem_available(1))
+    {
+        const char* p = mem_buf->cur();
+        const char* next = varint::decode(p, p + mem_buf->remaining(), x);
+        if(!next)
+        {
+            is.setstate(std::ios::failbit);
+            return false;
+        }
+        stats::detail::bytes_read(next - p);
+        mem_buf->advance(next - p);
+        return true;
+    }
+    varint::read(is, x);
+    if(!is)
+        return false;
+    stats::detail::bytes_read(varint::size(x));
+    return true;
+}
+
+template<class T>
+void stream_reader::read_varint_array(T* arr, size_t n)
+{
+    if(n > 0 && mem_available(1))
+    {
+        const char* p = mem_buf->cur();
+        const char* next = varint::decode_array(p, p + mem_buf->remaining(), arr, n);
+        if(!next)
+        {
+            is.setstate(std::ios::failbit);
+            return;
+        }
+        stats::detail::bytes_read(next - p);
+        mem_buf->advance(next - p);
+    }
+    else
+        for(size_t i = 0; i < n && is; ++i)
+            read_num(arr[i]);
+}
+
+template<class F>
+void stream_reader::read_recorded(const detail::lazy_payload& payload, F&& read)
+{
+    imemstream is(payload.buf->data() + payload.offset, payload.size);
+    stream_reader reader(is, payload.endian);
+    reader.lazy_ = true;
+    reader.lazy_buf = payload.buf;
+    read(reader);
+}
+
+inline void stream_reader::read_raw(char* dst, size_t n)
+{
+    stats::detail::bytes_read(n);
+    if(mem_available(n))
+    {
+        std::memcpy(dst, mem_buf->cur(), n);
+        mem_buf->advance(n);
+    }
+    else
+        is.read(dst, n);
 }
 
 }
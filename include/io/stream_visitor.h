@@ -0,0 +1,111 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef STREAM_VISITOR_H_INCLUDED
+#define STREAM_VISITOR_H_INCLUDED
+
+#include "tag.h"
+#include <cstdint>
+#include <string>
+
+namespace nbt
+{
+namespace io
+{
+
+/**
+ * @brief Base class for receivers of the events of stream_reader::parse
+ *
+ * The parser reads the tags from the stream and reports them as events,
+ * without constructing any tags, so that arbitrarily large data can be
+ * processed with constant memory. For example, the root tag
+ * <tt>"Level": {"a": 1b, "b": [2, 3]}</tt> results in the events
+ * @code
+ * key("Level", Compound), begin_compound(),
+ *     key("a", Byte), primitive(int8_t(1)),
+ *     key("b", List), begin_list(Int, 2), primitive(2), primitive(3), end_list(),
+ * end_compound()
+ * @endcode
+ * Arrays are reported in chunks between begin_array and end_array.
+ *
+ * Each callback returns an action that tells the parser how to continue.
+ * All callbacks do nothing and return action::proceed by default.
+ */
+class stream_visitor
+{
+public:
+    enum class action
+    {
+        ///Continue parsing
+        proceed,
+        /**
+         * Only valid for key and the begin events, otherwise the same as
+         * proceed: skips the tag without reporting its contents and its end
+         */
+        skip,
+        /**
+         * Skips the rest of the compound, list or array the event belongs to.
+         * Its end event is still reported. Keys and begin events belong to
+         * the enclosing tag, not the one they begin.
+         */
+        leave,
+        ///Stops parsing, stream_reader::parse returns false
+        stop
+    };
+
+    virtual ~stream_visitor() noexcept = 0; //Abstract class
+
+    ///Called for each key of a compound and for the name of the root tag
+    virtual action key(const std::string& /*name*/, tag_type /*type*/) { return action::proceed; }
+
+    virtual action begin_compound() { return action::proceed; }
+    virtual action end_compound() { return action::proceed; }
+
+    /**
+     * @brief Called at the start of a list
+     *
+     * Lists with content type tag_end are reported as empty lists with
+     * content type tag_type::Null.
+     */
+    virtual action begin_list(tag_type /*el_type*/, int32_t /*length*/) { return action::proceed; }
+    virtual action end_list() { return action::proceed; }
+
+    virtual action primitive(int8_t /*val*/) { return action::proceed; }
+    virtual action primitive(int16_t /*val*/) { return action::proceed; }
+    virtual action primitive(int32_t /*val*/) { return action::proceed; }
+    virtual action primitive(int64_t /*val*/) { return action::proceed; }
+    virtual action primitive(float /*val*/) { return action::proceed; }
+    virtual action primitive(double /*val*/) { return action::proceed; }
+    virtual action string(const std::string& /*str*/) { return action::proceed; }
+
+    ///Called at the start of a byte, int or long array
+    virtual action begin_array(tag_type /*type*/, int32_t /*length*/) { return action::proceed; }
+    ///Called with consecutive parts of the array's contents
+    virtual action array_data(const int8_t* /*data*/, size_t /*n*/) { return action::proceed; }
+    virtual action array_data(const int32_t* /*data*/, size_t /*n*/) { return action::proceed; }
+    virtual action array_data(const int64_t* /*data*/, size_t /*n*/) { return action::proceed; }
+    virtual action end_array() { return action::proceed; }
+};
+
+inline stream_visitor::~stream_visitor() noexcept {}
+
+}
+}
+
+#endif // STREAM_VISITOR_H_INCLUDED
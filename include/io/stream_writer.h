@@ -22,8 +22,14 @@
 
 #include "tag.h"
 #include "endian_str.h"
+#include "io/omemstream.h"
+#include "stats.h"
+#include "varint.h"
+#include <algorithm>
+#include <cstring>
 #include <iosfwd>
 #include <string>
+#include <type_traits>
 
 namespace nbt
 {
@@ -43,14 +49,30 @@ class output_error : public std::runtime_error
  * @param t the tag
  * @param os the stream to write to
  * @param e the byte order of the written data. The Java edition
- * of Minecraft uses Big Endian, the Pocket edition uses Little Endian
+ * of Minecraft uses Big Endian, the Pocket edition uses Little Endian,
+ * its network protocol endian::network
  */
 NBT_EXPORT void write_tag(const std::string& key, const tag& t, std::ostream& os, endian::endian e = endian::big);
 
+/**
+ * @brief Computes the number of bytes that writing the tag's payload produces
+ *
+ * Walks the tag once without writing anything. Lists of primitives and
+ * lazily read payloads that have not been decoded yet are measured without
+ * visiting their elements.
+ * @param t the tag
+ * @param e the byte order the payload would be written in
+ */
+NBT_EXPORT size_t serialized_size(const tag& t, endian::endian e = endian::big);
+
 /**
  * @brief Helper class for writing NBT tags to output streams
  *
- * Can be reused to write multiple tags
+ * Can be reused to write multiple tags.
+ *
+ * If the stream writes to an io::omem_streambuf (e.g. an io::omemstream),
+ * numbers and strings are encoded directly into its memory, which is a lot
+ * faster than going through the std::ostream interface.
  */
 class NBT_EXPORT stream_writer
 {
@@ -63,11 +85,10 @@ public:
     /**
      * @param os the stream to write to
      * @param e the byte order of the written data. The Java edition
-     * of Minecraft uses Big Endian, the Pocket edition uses Little Endian
+     * of Minecraft uses Big Endian, the Pocket edition uses Little Endian,
+     * its network protocol endian::network
      */
-    explicit stream_writer(std::ostream& os, endian::endian e = endian::big) noexcept:
-        os(os), endian(e)
-    {}
+    explicit stream_writer(std::ostream& os, endian::endian e = endian::big) noexcept;
 
     ///Returns the stream
     std::ostream& get_ostr() const { return os; }
@@ -79,10 +100,26 @@ public:
      */
     void write_tag(const std::string& key, const tag& t);
 
+    /**
+     * @brief Returns the number of bytes that write_tag would write for the
+     * given named tag
+     * @sa serialized_size
+     */
+    size_t tag_size(const std::string& key, const tag& t) const
+    { return 1 + string_size(key) + serialized_size(t, endian); }
+
+    ///Returns the number of bytes that write_string would write
+    size_t string_size(const std::string& str) const
+    { return (endian == endian::network ? varint::size(str.size()) : 2) + str.size(); }
+
     /**
      * @brief Writes the given tag's payload into the stream
      */
-    void write_payload(const tag& t) { t.write_payload(*this); }
+    void write_payload(const tag& t)
+    {
+        stats::detail::tag_written(t.get_type());
+        t.write_payload(*this);
+    }
 
     /**
      * @brief Writes a tag type to the stream
@@ -91,28 +128,132 @@ public:
 
     /**
      * @brief Writes a binary number to the stream
+     *
+     * With endian::network, 32 and 64 bit integers are written as zigzag
+     * encoded varints.
      */
     template<class T>
     void write_num(T x);
 
+    /**
+     * @brief Writes an array of binary numbers to the stream
+     *
+     * Much faster than calling write_num for each element.
+     */
+    template<class T>
+    void write_array(const T* arr, size_t n);
+
+    /**
+     * @brief Writes raw bytes to the stream
+     */
+    void write_raw(const char* src, size_t n);
+
     /**
      * @brief Writes an NBT string to the stream
      *
-     * An NBT string consists of two bytes indicating the length, followed by
-     * the characters encoded in modified UTF-8.
+     * An NBT string consists of two bytes indicating the length (a varint
+     * with endian::network), followed by the characters encoded in modified UTF-8.
      * @throw std::length_error if the string is too long for NBT
      */
     void write_string(const std::string& str);
 
 private:
     std::ostream& os;
+    ///The stream's buffer if it writes to memory, otherwise null
+    omem_streambuf* const mem_buf;
     const endian::endian endian;
+
+    ///Returns a pointer where n bytes can be stored in mem_buf directly, or null
+    char* mem_reserve(size_t n)
+    { return mem_buf && os.good() && os.rdbuf() == mem_buf ? mem_buf->reserve(n) : nullptr; }
+
+    ///Writes an unsigned varint
+    template<class U>
+    void write_varint(U x);
+    ///Writes n zigzag encoded varints
+    template<class T>
+    void write_varint_array(const T* arr, size_t n);
 };
 
 template<class T>
 void stream_writer::write_num(T x)
 {
-    endian::write(os, x, endian);
+    if constexpr(varint::is_encoded<T>)
+        if(endian == endian::network)
+            return write_varint(varint::zigzag_encode(x));
+    stats::detail::bytes_written(sizeof(T));
+    if(char* p = mem_reserve(sizeof(T)))
+    {
+        endian::write(p, x, endian);
+        mem_buf->advance(sizeof(T));
+    }
+    else
+        endian::write(os, x, endian);
+}
+
+template<class T>
+void stream_writer::write_array(const T* arr, size_t n)
+{
+    if constexpr(varint::is_encoded<T>)
+        if(endian == endian::network)
+            return write_varint_array(arr, n);
+    stats::detail::bytes_written(n * sizeof(T));
+    if(char* p = mem_reserve(n * sizeof(T)))
+    {
+        endian::write_array(p, arr, n, endian);
+        mem_buf->advance(n * sizeof(T));
+    }
+    else
+        endian::write_array(os, arr, n, endian);
+}
+
+template<class U>
+void stream_writer::write_varint(U x)
+{
+    char buf[varint::max_size64];
+    char* p = mem_reserve(sizeof(buf));
+    char* end = varint::encode(p ? p : buf, x);
+    if(p)
+    {
+        mem_buf->advance(end - p);
+        stats::detail::bytes_written(end - p);
+    }
+    else
+        write_raw(buf, end - buf);
+}
+
+template<class T>
+void stream_writer::write_varint_array(const T* arr, size_t n)
+{
+    //Encode block by block, as the size is not known in advance
+    const size_t block_len = 1024;
+    const size_t max_size = sizeof(T) == 4 ? varint::max_size32 : varint::max_size64;
+    char buf[block_len * max_size];
+    for(size_t i = 0; i < n; i += block_len)
+    {
+        size_t len = std::min(block_len, n - i);
+        char* p = mem_reserve(len * max_size);
+        char* end = varint::encode_array(p ? p : buf, arr + i, len);
+        if(p)
+        {
+            mem_buf->advance(end - p);
+            stats::detail::bytes_written(end - p);
+        }
+        else
+            write_raw(buf, end - buf);
+    }
+}
+
+inline void stream_writer::write_raw(const char* src, size_t n)
+{
+    stats::detail::bytes_written(n);
+    if(char* p = mem_reserve(n))
+    {
+        std::memcpy(p, src, n);
+        mem_buf->advance(n);
+    }
+    else
+        os.write(src, n);
 }
 
 }
@@ -0,0 +1,177 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ZLIB_BUFFER_H_INCLUDED
+#define ZLIB_BUFFER_H_INCLUDED
+
+#include "io/zlib_streambuf.h"
+#include "endian_str.h"
+#include "tag_compound.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <zlib.h>
+
+namespace zlib
+{
+
+/**
+ * @brief Compresses blocks of memory in one go, reusing its state
+ *
+ * Setting up a compressor allocates several hundred KiB, which dominates
+ * the cost of compressing small payloads such as network packets. A
+ * deflater keeps its state and its buffers between calls, so it should be
+ * reused for many calls, e.g. one per thread or from a pool. It must not
+ * be used by several threads at once.
+ */
+class NBT_EXPORT deflater
+{
+public:
+    /**
+     * @param level the compression level, ranges from 0 to 9, or -1 for default
+     * @param gzip if true, the output will be in gzip format rather than zlib
+     * @throw zlib_error if the level is invalid
+     */
+    explicit deflater(int level = Z_DEFAULT_COMPRESSION, bool gzip = false);
+    deflater(deflater&&) noexcept;
+    deflater& operator=(deflater&&) noexcept;
+    ~deflater() noexcept;
+
+    int level() const { return level_; }
+    bool is_gzip() const { return gzip_; }
+
+    /**
+     * @brief Compresses the data into @c out, replacing its contents
+     * @throw zlib_error if the compression fails
+     */
+    void compress(const char* data, size_t size, std::string& out);
+
+    /**
+     * @brief Writes a named tag and compresses it into @c out, replacing its contents
+     *
+     * The tag is serialized into a buffer that is kept for the next call.
+     * @throw zlib_error if the compression fails
+     * @throw std::length_error if the tag contains strings or lists that are
+     * too long for NBT
+     */
+    void compress_tag(const std::string& key, const nbt::tag& t, std::string& out,
+                      endian::endian e = endian::big);
+
+private:
+    struct state;
+    std::unique_ptr<state> st;
+    int level_;
+    bool gzip_;
+};
+
+/**
+ * @brief Decompresses zlib or gzip data in one go, reusing its state
+ *
+ * Like deflater, an inflater keeps its state and buffers between calls and
+ * should be reused. It must not be used by several threads at once.
+ */
+class NBT_EXPORT inflater
+{
+public:
+    inflater();
+    inflater(inflater&&) noexcept;
+    inflater& operator=(inflater&&) noexcept;
+    ~inflater() noexcept;
+
+    /**
+     * @brief Decompresses the data into @c out, replacing its contents
+     * @sa zlib::decompress
+     * @throw zlib_error if the data is corrupt or truncated
+     */
+    void decompress(const char* data, size_t size, std::string& out, size_t size_hint = 0);
+
+    /**
+     * @brief Decompresses the data and reads a named compound from it
+     *
+     * The data is decompressed into a buffer that is kept for the next call.
+     * @throw zlib_error if the data is corrupt or truncated
+     * @throw nbt::io::input_error if the tag cannot be read
+     */
+    std::pair<std::string, std::unique_ptr<nbt::tag_compound>>
+    read_compound(const char* data, size_t size, endian::endian e = endian::big);
+
+private:
+    struct state;
+    std::unique_ptr<state> st;
+};
+
+/**
+ * @brief Compresses a block of memory in one go
+ *
+ * Unlike ozlibstream, this needs no intermediate buffers. Uses a deflater
+ * that is kept for the current thread, so repeated calls don't need to set
+ * up the compressor again.
+ * @param data the data to compress
+ * @param size the size of the data
+ * @param out the string to store the compressed data in, its contents are replaced
+ * @param level the compression level, ranges from 0 to 9, or -1 for default
+ * @param gzip if true, the output will be in gzip format rather than zlib
+ * @throw zlib_error if the compression fails
+ */
+NBT_EXPORT void compress(const char* data, size_t size, std::string& out,
+                         int level = Z_DEFAULT_COMPRESSION, bool gzip = false);
+
+///@copydoc compress(const char*, size_t, std::string&, int, bool)
+inline std::string compress(const std::string& data, int level = Z_DEFAULT_COMPRESSION, bool gzip = false)
+{
+    std::string out;
+    compress(data.data(), data.size(), out, level, gzip);
+    return out;
+}
+
+/**
+ * @brief Decompresses zlib or gzip data in one go
+ *
+ * The format is detected automatically. The output is inflated directly
+ * into @c out, which is resized as needed. Passing the same string for many
+ * calls avoids reallocations. The result can be read with an
+ * nbt::io::imemstream:
+ * @code
+ * std::string buf;
+ * zlib::decompress(data, size, buf);
+ * nbt::io::imemstream is(buf);
+ * auto root = nbt::io::read_compound(is).second;
+ * @endcode
+ *
+ * Uses an inflater that is kept for the current thread.
+ * @param data the compressed data
+ * @param size the size of the compressed data
+ * @param out the string to store the decompressed data in, its contents are replaced
+ * @param size_hint the expected size of the decompressed data, or 0 if unknown.
+ * For gzip data, the size stored in the trailer is used.
+ * @throw zlib_error if the data is corrupt or truncated
+ */
+NBT_EXPORT void decompress(const char* data, size_t size, std::string& out, size_t size_hint = 0);
+
+///@copydoc decompress(const char*, size_t, std::string&, size_t)
+inline std::string decompress(const std::string& data, size_t size_hint = 0)
+{
+    std::string out;
+    decompress(data.data(), data.size(), out, size_hint);
+    return out;
+}
+
+}
+
+#endif // ZLIB_BUFFER_H_INCLUDED
@@ -0,0 +1,189 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ZSTDSTREAM_H_INCLUDED
+#define ZSTDSTREAM_H_INCLUDED
+
+#include "io/codec.h"
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "nbt_export.h"
+
+//Declared here so that zstd.h is only needed to build the library
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+
+namespace zstd
+{
+
+/**
+ * @brief Compresses the data into a single zstd frame
+ *
+ * The contents of @c out are replaced.
+ * @param level the compression level, ranges from 1 to 22, or -1 for default
+ * @throw nbt::io::codec_error if the compression fails
+ */
+NBT_EXPORT void compress(const char* data, size_t size, std::string& out, int level = -1);
+
+/**
+ * @brief Decompresses one or more zstd frames
+ *
+ * The contents of @c out are replaced. If the frame stores the size of its
+ * content, which the frames written by this library always do, the output
+ * is allocated once with exactly that size.
+ * @param size_hint the expected size of the decompressed data, or 0 if unknown
+ * @throw nbt::io::codec_error if the data is corrupt or truncated
+ */
+NBT_EXPORT void decompress(const char* data, size_t size, std::string& out, size_t size_hint = 0);
+
+/**
+ * @brief Stream buffer used by zstd::izstdstream
+ * @sa izstdstream
+ */
+class NBT_EXPORT decompress_streambuf : public std::streambuf
+{
+public:
+    /**
+     * @param input the istream to wrap
+     * @param bufsize the size of the input and output buffers
+     * @throw nbt::io::codec_error if zstd fails to allocate its context
+     */
+    explicit decompress_streambuf(std::istream& input, size_t bufsize = 32768);
+    ~decompress_streambuf() noexcept;
+
+    decompress_streambuf(const decompress_streambuf&) = delete;
+    decompress_streambuf& operator=(const decompress_streambuf&) = delete;
+
+    ///@return the wrapped istream
+    std::istream& get_istr() const { return is; }
+
+private:
+    std::istream& is;
+    ZSTD_DCtx* dctx;
+    std::vector<char> in;
+    std::vector<char> out;
+    size_t in_pos = 0;
+    size_t in_end = 0;
+    bool output_pending = false;
+    bool frame_end = false;
+
+    int_type underflow() override;
+};
+
+/**
+ * @brief An istream adapter that decompresses zstd data
+ *
+ * Reading stops at the end of the first frame. Like zlib::izlibstream, it
+ * attempts to seek the wrapped istream back to the point after the frame.
+ * @sa decompress_streambuf
+ */
+class NBT_EXPORT izstdstream : public std::istream
+{
+public:
+    /**
+     * @param input the istream to wrap
+     * @param bufsize the size of the internal buffers
+     */
+    explicit izstdstream(std::istream& input, size_t bufsize = 32768):
+        std::istream(&buf), buf(input, bufsize)
+    {}
+
+    ///@return the wrapped istream
+    std::istream& get_istr() const { return buf.get_istr(); }
+
+private:
+    decompress_streambuf buf;
+};
+
+/**
+ * @brief Stream buffer used by zstd::ozstdstream
+ * @sa ozstdstream
+ */
+class NBT_EXPORT compress_streambuf : public std::streambuf
+{
+public:
+    /**
+     * @param output the ostream to wrap
+     * @param level the compression level, ranges from 1 to 22, or -1 for default
+     * @param bufsize the size of the input and output buffers
+     * @throw nbt::io::codec_error if the level is invalid or zstd fails to
+     * allocate its context
+     */
+    explicit compress_streambuf(std::ostream& output, int level = -1, size_t bufsize = 32768);
+    ~compress_streambuf() noexcept;
+
+    compress_streambuf(const compress_streambuf&) = delete;
+    compress_streambuf& operator=(const compress_streambuf&) = delete;
+
+    ///@return the wrapped ostream
+    std::ostream& get_ostr() const { return os; }
+
+    ///Finishes the frame and writes all pending data to the output
+    void close();
+
+    ///@return true if the frame has not been finished yet
+    bool is_open() const { return is_open_; }
+
+private:
+    std::ostream& os;
+    ZSTD_CCtx* cctx;
+    std::vector<char> in;
+    std::vector<char> out;
+    bool is_open_ = true;
+
+    void compress_chunk(int mode);
+
+    int_type overflow(int_type ch) override;
+    int sync() override;
+};
+
+/**
+ * @brief An ostream adapter that compresses data into a zstd frame
+ *
+ * The frame is finished by close() or when the stream is destroyed.
+ * @sa compress_streambuf
+ */
+class NBT_EXPORT ozstdstream : public std::ostream
+{
+public:
+    /**
+     * @param output the ostream to wrap
+     * @param level the compression level, ranges from 1 to 22, or -1 for default
+     * @param bufsize the size of the internal buffers
+     */
+    explicit ozstdstream(std::ostream& output, int level = -1, size_t bufsize = 32768):
+        std::ostream(&buf), buf(output, level, bufsize)
+    {}
+
+    ///@return the wrapped ostream
+    std::ostream& get_ostr() const { return buf.get_ostr(); }
+
+    ///Finishes the frame and writes all pending data to the output
+    void close();
+
+private:
+    compress_streambuf buf;
+};
+
+}
+
+#endif // ZSTDSTREAM_H_INCLUDED
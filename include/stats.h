@@ -0,0 +1,165 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef STATS_H_INCLUDED
+#define STATS_H_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "nbt_export.h"
+
+namespace nbt
+{
+
+enum class tag_type : int8_t;
+
+/**
+ * @brief Counters of what the library decodes, encodes and allocates
+ *
+ * The counters are only maintained if the library was built with the
+ * CMake option NBT_ENABLE_STATS. Otherwise all hooks compile to nothing and
+ * snapshots are always empty.
+ *
+ * Each thread updates counters of its own, so the cost is small even with
+ * many threads, and a snapshot adds up the counters of all threads.
+ */
+namespace stats
+{
+
+#ifdef NBT_ENABLE_STATS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+///The values of all counters at one point in time
+struct snapshot
+{
+    ///Decoded tags, indexed by tag_type. Elements of lists count as tags.
+    std::array<uint64_t, 13> tags_read{};
+    ///Encoded tags, indexed by tag_type
+    std::array<uint64_t, 13> tags_written{};
+    /**
+     * Uncompressed bytes consumed by io::stream_reader. Payloads that are
+     * read lazily are counted again, along with their tags, when decoded.
+     */
+    uint64_t bytes_read = 0;
+    ///Uncompressed bytes produced by io::stream_writer
+    uint64_t bytes_written = 0;
+    ///Tags allocated by tag::create, which the reader uses for all tags
+    uint64_t tags_created = 0;
+    /**
+     * Deepest nesting of decoded tags, where the tag passed to the reader
+     * has depth 1. Lazily decoded payloads start over at depth 1.
+     */
+    unsigned max_depth = 0;
+    ///Time spent decompressing (zlib, and the LZ4 and zstd codecs)
+    std::chrono::nanoseconds inflate_time{0};
+    ///Time spent in io::stream_reader, excluding the decompression it caused
+    std::chrono::nanoseconds parse_time{0};
+
+    uint64_t total_tags_read() const;
+    uint64_t total_tags_written() const;
+};
+
+///Returns the current values of the counters, summed over all threads
+NBT_EXPORT snapshot get_snapshot();
+
+///Sets all counters to zero
+NBT_EXPORT void reset();
+
+///Hooks that are called from within the library
+namespace detail
+{
+#ifdef NBT_ENABLE_STATS
+    NBT_EXPORT void tag_read(tag_type type, uint64_t n = 1);
+    NBT_EXPORT void tag_written(tag_type type, uint64_t n = 1);
+    NBT_EXPORT void bytes_read(uint64_t n);
+    NBT_EXPORT void bytes_written(uint64_t n);
+    NBT_EXPORT void tag_created();
+
+    ///Marks one more level of nesting for its lifetime and updates the maximum depth
+    class NBT_EXPORT depth_guard
+    {
+    public:
+        depth_guard();
+        ~depth_guard();
+        depth_guard(const depth_guard&) = delete;
+        depth_guard& operator=(const depth_guard&) = delete;
+    };
+
+    ///Adds its lifetime to the inflate time
+    class NBT_EXPORT inflate_timer
+    {
+    public:
+        inflate_timer();
+        ~inflate_timer();
+        inflate_timer(const inflate_timer&) = delete;
+        inflate_timer& operator=(const inflate_timer&) = delete;
+
+    private:
+        std::chrono::steady_clock::time_point start;
+    };
+
+    ///Adds its lifetime minus the inflate time to the parse time; nested timers are ignored
+    class NBT_EXPORT parse_timer
+    {
+    public:
+        parse_timer();
+        ~parse_timer();
+        parse_timer(const parse_timer&) = delete;
+        parse_timer& operator=(const parse_timer&) = delete;
+
+    private:
+        std::chrono::steady_clock::time_point start;
+        uint64_t inflate_start;
+        bool outermost;
+    };
+#else
+    inline void tag_read(tag_type, uint64_t = 1) {}
+    inline void tag_written(tag_type, uint64_t = 1) {}
+    inline void bytes_read(uint64_t) {}
+    inline void bytes_written(uint64_t) {}
+    inline void tag_created() {}
+
+    class depth_guard
+    {
+    public:
+        depth_guard() {}
+    };
+
+    class inflate_timer
+    {
+    public:
+        inflate_timer() {}
+    };
+
+    class parse_timer
+    {
+    public:
+        parse_timer() {}
+    };
+#endif
+}
+
+}
+}
+
+#endif // STATS_H_INCLUDED
@@ -20,6 +20,7 @@
 #ifndef TAG_H_INCLUDED
 #define TAG_H_INCLUDED
 
+#include <cstddef>
 #include <cstdint>
 #include <iosfwd>
 #include <memory>
@@ -118,6 +119,16 @@ public:
      */
     static std::unique_ptr<tag> create(tag_type type);
 
+    /**
+     * @brief Allocates memory for a tag
+     *
+     * The memory comes from the tag_arena that is active on the current
+     * thread, or from the heap if there is none.
+     */
+    static void* operator new(std::size_t size);
+    ///Frees the memory of a tag, unless it was allocated from a tag_arena
+    static void operator delete(void* ptr) noexcept;
+
     friend NBT_EXPORT bool operator==(const tag& lhs, const tag& rhs);
     friend NBT_EXPORT bool operator!=(const tag& lhs, const tag& rhs);
 
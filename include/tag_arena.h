@@ -0,0 +1,125 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TAG_ARENA_H_INCLUDED
+#define TAG_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "nbt_export.h"
+
+namespace nbt
+{
+
+/**
+ * @brief Monotonic memory region from which tags can be allocated
+ *
+ * While an arena is active on a thread (see tag_arena::scope), all tags that
+ * are created on that thread, e.g. by io::stream_reader, are allocated from
+ * the arena rather than from the heap. Deleting such a tag runs its
+ * destructor, but does not free its memory. Instead, the memory of all tags
+ * is released at once by release() or when the arena is destroyed.
+ *
+ * Only the tag objects themselves are allocated from the arena. Memory that
+ * the tags allocate internally (e.g. the nodes of a tag_compound) still comes
+ * from the heap.
+ *
+ * All tags that were allocated from an arena must be destroyed before it is
+ * released. An arena must not be used by multiple threads at once.
+ *
+ * Example:
+ * @code
+ * nbt::tag_arena arena;
+ * for(auto& chunk: chunks)
+ * {
+ *     nbt::tag_arena::scope scope(arena);
+ *     auto comp = nbt::io::read_compound(chunk.stream);
+ *     process(*comp.second);
+ *     comp.second.reset();
+ *     arena.release();
+ * }
+ * @endcode
+ */
+class NBT_EXPORT tag_arena
+{
+public:
+    /**
+     * @brief Activates an arena on the current thread during its lifetime
+     *
+     * Scopes can be nested, the previously active arena (if any) is restored
+     * when the scope ends.
+     */
+    class NBT_EXPORT scope
+    {
+    public:
+        explicit scope(tag_arena& arena) noexcept;
+        ~scope() noexcept;
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        tag_arena* previous;
+    };
+
+    /**
+     * @param block_size the size of the first memory block in bytes.
+     * Further blocks are allocated with increasing size when needed.
+     */
+    explicit tag_arena(size_t block_size = 65536);
+    ~tag_arena() noexcept;
+
+    tag_arena(const tag_arena&) = delete;
+    tag_arena& operator=(const tag_arena&) = delete;
+
+    ///Returns the arena that is active on the current thread, or nullptr
+    static tag_arena* current() noexcept;
+
+    /**
+     * @brief Allocates memory from the arena
+     *
+     * The memory is suitably aligned for any tag.
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief Releases all memory allocated from the arena at once
+     *
+     * Only the largest block is kept for further allocations.
+     */
+    void release() noexcept;
+
+    ///Returns the number of bytes allocated from the arena since the last release
+    size_t bytes_used() const { return used; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t next_block_size;
+    size_t last_block_size = 0;
+    char* cur = nullptr;
+    char* end = nullptr;
+    size_t used = 0;
+
+    void add_block(size_t min_size);
+};
+
+}
+
+#endif // TAG_ARENA_H_INCLUDED
@@ -21,17 +21,41 @@
 #define TAG_COMPOUND_H_INCLUDED
 
 #include "crtp_tag.h"
+#include "endian_str.h"
+#include "tagfwd.h"
 #include "value_initializer.h"
+#ifdef NBT_FLAT_COMPOUND
+#include "flat_map.h"
+#else
 #include <map>
+#endif
 #include <string>
+#include <string_view>
 
 namespace nbt
 {
 
-///Tag that contains multiple unordered named tags of arbitrary types
+/**
+ * @brief Tag that contains multiple unordered named tags of arbitrary types
+ *
+ * By default, the tags are stored in a std::map. If the library is built with
+ * the NBT_FLAT_COMPOUND option, they are stored in a sorted vector instead
+ * (see detail::flat_map), which is faster for small compounds. In that case,
+ * adding or erasing tags invalidates all iterators and references to the
+ * contained values. The iteration order (sorted by key) is the same in both cases.
+ *
+ * A compound that has been read by a lazy io::stream_reader is decoded when
+ * it is first accessed, see io::stream_reader::set_lazy. Since this can also
+ * happen through const access, such a compound must not be accessed from
+ * several threads at once, even if none of them modifies it.
+ */
 class NBT_EXPORT tag_compound final : public detail::crtp_tag<tag_compound>
 {
-    typedef std::map<std::string, value> map_t_;
+#ifdef NBT_FLAT_COMPOUND
+    typedef detail::flat_map<std::string, value> map_t_;
+#else
+    typedef std::map<std::string, value, std::less<>> map_t_;
+#endif
 
 public:
     //Iterator types
@@ -54,8 +78,8 @@ public:
      * exception if it does not exist.
      * @throw std::out_of_range if given key does not exist
      */
-    value& at(const std::string& key);
-    const value& at(const std::string& key) const;
+    value& at(std::string_view key);
+    const value& at(std::string_view key) const;
 
     /**
      * @brief Accesses a tag by key
@@ -63,7 +87,7 @@ public:
      * Returns a value to the tag with the specified key. If it does not exist,
      * creates a new uninitialized entry under the key.
      */
-    value& operator[](const std::string& key) { return tags[key]; }
+    value& operator[](std::string_view key);
 
     /**
      * @brief Inserts or assigns a tag
@@ -98,37 +122,55 @@ public:
      * @brief Erases a tag from the compound
      * @return true if a tag was erased
      */
-    bool erase(const std::string& key);
+    bool erase(std::string_view key);
 
     ///Returns true if the given key exists in the compound
-    bool has_key(const std::string& key) const;
+    bool has_key(std::string_view key) const;
     ///Returns true if the given key exists and the tag has the given type
-    bool has_key(const std::string& key, tag_type type) const;
+    bool has_key(std::string_view key, tag_type type) const;
 
     ///Returns the number of tags in the compound
-    size_t size() const { return tags.size(); }
+    size_t size() const { load(); return tags.size(); }
+
+    /**
+     * @brief Returns the size of the payload if the compound has been read
+     * lazily and not decoded yet, otherwise 0
+     *
+     * Also returns 0 if writing the payload in the byte order @p e would
+     * produce a different number of bytes, i.e. if only one of them is
+     * endian::network.
+     */
+    size_t lazy_size(endian::endian e = endian::big) const;
 
     ///Erases all tags from the compound
-    void clear() { tags.clear(); }
+    void clear() { lazy.reset(); tags.clear(); }
 
     //Iterators
-    iterator begin() { return tags.begin(); }
-    iterator end()   { return tags.end(); }
-    const_iterator begin() const  { return tags.begin(); }
-    const_iterator end() const    { return tags.end(); }
-    const_iterator cbegin() const { return tags.cbegin(); }
-    const_iterator cend() const   { return tags.cend(); }
+    iterator begin() { load(); return tags.begin(); }
+    iterator end()   { load(); return tags.end(); }
+    const_iterator begin() const  { load(); return tags.begin(); }
+    const_iterator end() const    { load(); return tags.end(); }
+    const_iterator cbegin() const { load(); return tags.cbegin(); }
+    const_iterator cend() const   { load(); return tags.cend(); }
 
     void read_payload(io::stream_reader& reader) override;
     void write_payload(io::stream_writer& writer) const override;
 
     friend bool operator==(const tag_compound& lhs, const tag_compound& rhs)
-    { return lhs.tags == rhs.tags; }
+    { lhs.load(); rhs.load(); return lhs.tags == rhs.tags; }
     friend bool operator!=(const tag_compound& lhs, const tag_compound& rhs)
     { return !(lhs == rhs); }
 
 private:
-    map_t_ tags;
+    mutable map_t_ tags;
+    ///The undecoded payload if the compound has been read lazily
+    mutable std::shared_ptr<const detail::lazy_payload> lazy;
+
+    ///Decodes the lazily read payload, if there is one
+    void load() const { if(lazy) load_slow(); }
+    void load_slow() const;
+    ///Reads the entries of the compound, which must be empty
+    void read_entries(io::stream_reader& reader) const;
 };
 
 template<class T, class... Args>
@@ -21,9 +21,13 @@
 #define TAG_LIST_H_INCLUDED
 
 #include "crtp_tag.h"
+#include "endian_str.h"
 #include "tagfwd.h"
 #include "value_initializer.h"
+#include <atomic>
 #include <stdexcept>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 namespace nbt
@@ -39,6 +43,22 @@ namespace nbt
  * If the list is empty, the type can be undetermined, in which case el_type()
  * will return tag_type::Null. The type will then be set when the first tag
  * is added to the list.
+ *
+ * Lists of bytes, shorts, ints, longs, floats and doubles can keep their
+ * elements unboxed in a contiguous array instead of one tag per element.
+ * This is how they are read from streams and constructed from initializer
+ * lists of numbers. Non-const access as values, e.g. through operator[] or
+ * the iterators, boxes the elements, and the non-const primitives() unboxes
+ * them again.
+ *
+ * Const access never changes how the elements are stored. On an unboxed
+ * list, the const operator[], at() and iterators return boxed copies of the
+ * elements, which are made once on first use and kept until the list is
+ * modified. So a const list can be read from several threads at once, and
+ * references obtained from it stay valid until it is modified.
+ *
+ * A list that has been read by a lazy io::stream_reader is decoded when it
+ * is first accessed, see io::stream_reader::set_lazy.
  */
 class NBT_EXPORT tag_list final : public detail::crtp_tag<tag_list>
 {
@@ -89,11 +109,17 @@ public:
      */
     tag_list(std::initializer_list<value> init);
 
+    tag_list(const tag_list& other);
+    tag_list(tag_list&& other) noexcept;
+    tag_list& operator=(const tag_list& other);
+    tag_list& operator=(tag_list&& other) noexcept;
+
     /**
      * @brief Accesses a tag by index with bounds checking
      *
      * Returns a value to the tag at the specified index, or throws an
-     * exception if it is out of range.
+     * exception if it is out of range. The non-const version boxes the
+     * elements if they are unboxed, the const version returns a boxed copy.
      * @throw std::out_of_range if the index is out of range
      */
     value& at(size_t i);
@@ -103,10 +129,45 @@ public:
      * @brief Accesses a tag by index
      *
      * Returns a value to the tag at the specified index. No bounds checking
-     * is performed.
+     * is performed. Boxes the elements like at().
+     */
+    value& operator[](size_t i) { unpack(); return tags[i]; }
+    const value& operator[](size_t i) const { return boxed()[i]; }
+
+    /**
+     * @brief Returns the elements of a list of primitives as a vector
+     *
+     * T must be the value type of the content type, e.g. double for a list
+     * of tag_double. If the list is not unboxed yet, the non-const version
+     * moves its elements into the vector. This invalidates all references
+     * and iterators to the values of the list, and accessing the values
+     * again invalidates the vector.
+     *
+     * If the content type is undetermined, the non-const version sets it
+     * to the tag type for T. The const version returns the unboxed elements
+     * in place and doesn't change the list. Use visit_elements() to read
+     * lists that may be boxed.
+     * @throw std::bad_cast if the content type does not match T
+     * @throw std::logic_error from the const version if the list is boxed
+     * and not empty
      */
-    value& operator[](size_t i) { return tags[i]; }
-    const value& operator[](size_t i) const { return tags[i]; }
+    template<class T>
+    std::vector<T>& primitives();
+    template<class T>
+    const std::vector<T>& primitives() const;
+
+    /**
+     * @brief Calls @p f with the elements as they are stored, without boxing
+     * or unboxing them
+     *
+     * The argument is a const std::vector<T>& of the numbers if the elements
+     * are unboxed, otherwise the const std::vector<value>& of the tags, so
+     * @p f must accept both, e.g. as a generic lambda. Only decodes the list
+     * if it has been read lazily.
+     * @return the result of @p f, which must be the same type for all of them
+     */
+    template<class F>
+    decltype(auto) visit_elements(F&& f) const;
 
     /**
      * @brief Assigns a value at the given index
@@ -132,16 +193,26 @@ public:
     void emplace_back(Args&&... args);
 
     ///Removes the last element of the list
-    void pop_back() { tags.pop_back(); }
+    void pop_back();
 
     ///Returns the content type of the list, or tag_type::Null if undetermined
-    tag_type el_type() const { return el_type_; }
+    tag_type el_type() const { load(); return el_type_; }
 
     ///Returns the number of tags in the list
-    size_t size() const { return tags.size(); }
+    size_t size() const;
+
+    /**
+     * @brief Returns the size of the payload if the list has been read
+     * lazily and not decoded yet, otherwise 0
+     *
+     * Also returns 0 if writing the payload in the byte order @p e would
+     * produce a different number of bytes, i.e. if only one of them is
+     * endian::network.
+     */
+    size_t lazy_size(endian::endian e = endian::big) const;
 
     ///Erases all tags from the list. Preserves the content type.
-    void clear() { tags.clear(); }
+    void clear() { lazy.reset(); tags.clear(); packed = std::monostate(); cached = false; }
 
     /**
      * @brief Erases all tags from the list and changes the content type.
@@ -149,13 +220,13 @@ public:
      */
     void reset(tag_type type = tag_type::Null);
 
-    //Iterators
-    iterator begin() { return tags.begin(); }
-    iterator end()   { return tags.end(); }
-    const_iterator begin() const  { return tags.begin(); }
-    const_iterator end() const    { return tags.end(); }
-    const_iterator cbegin() const { return tags.cbegin(); }
-    const_iterator cend() const   { return tags.cend(); }
+    //Iterators. They box the elements like at().
+    iterator begin() { unpack(); return tags.begin(); }
+    iterator end()   { unpack(); return tags.end(); }
+    const_iterator begin() const  { return boxed().begin(); }
+    const_iterator end() const    { return boxed().end(); }
+    const_iterator cbegin() const { return boxed().cbegin(); }
+    const_iterator cend() const   { return boxed().cend(); }
 
     /**
      * @inheritdoc
@@ -179,8 +250,43 @@ public:
     friend NBT_EXPORT bool operator!=(const tag_list& lhs, const tag_list& rhs);
 
 private:
-    std::vector<value> tags;
-    tag_type el_type_;
+    typedef std::variant<std::monostate,
+        std::vector<int8_t>, std::vector<int16_t>, std::vector<int32_t>,
+        std::vector<int64_t>, std::vector<float>, std::vector<double>> packed_t_;
+
+    //The elements are either boxed in tags or, for lists of primitives,
+    //unboxed in packed. If they are unboxed, tags can hold boxed copies
+    //of them for const access, which is what cached says.
+    mutable std::vector<value> tags;
+    mutable packed_t_ packed;
+    mutable tag_type el_type_;
+    mutable std::atomic<bool> cached{false};
+    ///The undecoded payload if the list has been read lazily
+    mutable std::shared_ptr<const detail::lazy_payload> lazy;
+
+    bool is_packed() const { return packed.index() != 0; }
+
+    ///Returns the boxed elements, making boxed copies if they are unboxed
+    const std::vector<value>& boxed() const
+    {
+        load();
+        if(is_packed() && !cached.load(std::memory_order_acquire))
+            box_slow();
+        return tags;
+    }
+    void box_slow() const;
+    ///Discards the boxed copies, for changes to the unboxed elements
+    void uncache() { if(cached) { tags.clear(); cached = false; } }
+
+    ///Decodes the lazily read payload, if there is one
+    void load() const { if(lazy) load_slow(); }
+    void load_slow() const;
+    ///Reads the contents of the list, which must be empty
+    void read_contents(io::stream_reader& reader) const;
+
+    ///Boxes the elements into tags if they are unboxed
+    void unpack() { load(); if(is_packed()) unpack_slow(); }
+    void unpack_slow();
 
     /**
      * Internally used initialization function that initializes the list with
@@ -199,13 +305,27 @@ tag_list tag_list::of(std::initializer_list<T> il)
     return result;
 }
 
+template<class F>
+decltype(auto) tag_list::visit_elements(F&& f) const
+{
+    load();
+    return std::visit([this, &f](const auto& vec) -> decltype(auto) {
+        if constexpr(std::is_same<std::decay_t<decltype(vec)>, std::monostate>::value)
+            return f(static_cast<const std::vector<value>&>(tags));
+        else
+            return f(vec);
+    }, packed);
+}
+
 template<class T, class... Args>
 void tag_list::emplace_back(Args&&... args)
 {
+    load();
     if(el_type_ == tag_type::Null) //set content type if undetermined
         el_type_ = T::type;
     else if(el_type_ != T::type)
         throw std::invalid_argument("The tag type does not match the list's content type");
+    unpack();
     tags.emplace_back(make_unique<T>(std::forward<Args>(args)...));
 }
 
@@ -47,6 +47,11 @@ typedef tag_array<int64_t> tag_long_array;
 class tag_list;
 class tag_compound;
 
+namespace detail
+{
+    struct lazy_payload;
+}
+
 }
 
 #endif // TAGFWD_H_INCLUDED
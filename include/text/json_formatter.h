@@ -29,16 +29,76 @@ namespace nbt
 namespace text
 {
 
+///Output syntax of json_formatter
+enum class json_syntax
+{
+    ///JSON-like text with unquoted keys and type suffixes on numbers, meant to be read by humans
+    nbt,
+    ///Standard JSON according to RFC 8259, see json_types for how tags are represented
+    strict
+};
+
+///How json_formatter represents tags in strict JSON
+enum class json_types
+{
+    /**
+     * Tags become the corresponding JSON values: numbers, strings, arrays for
+     * lists and typed arrays, and objects for compounds. The tag types are
+     * lost, and non-finite floating point values become null.
+     */
+    plain,
+    /**
+     * Each tag becomes an object <tt>{"type": "int", "value": 42}</tt>, where
+     * the type is the name printed by operator<<(std::ostream&, tag_type).
+     * The value is a number, string, or array of numbers as for plain, an
+     * array of such objects for lists, and an object with such objects as
+     * members for compounds. Lists also have an "element_type" member unless
+     * their content type is undetermined. Non-finite floating point values
+     * are the strings "NaN", "Infinity" and "-Infinity".
+     *
+     * This preserves all information, so that the output can be converted
+     * back to the same tags.
+     */
+    typed
+};
+
+///Options for json_formatter
+struct json_options
+{
+    json_syntax syntax = json_syntax::nbt;
+    ///Only used for json_syntax::strict
+    json_types types = json_types::plain;
+    ///Whether to break lines and indent nested compounds and lists. Otherwise, no whitespace is written.
+    bool pretty = true;
+    ///Number of spaces per level of indentation
+    unsigned indent = 2;
+};
+
 /**
- * @brief Prints tags in a JSON-like syntax into a stream
+ * @brief Prints tags in a JSON-like syntax or as standard JSON into a stream
+ *
+ * The output is collected in an internal buffer and written to the stream
+ * in large blocks. Numbers are formatted independently of the stream's
+ * locale and flags, floating point values in the shortest form that reads
+ * back to the same value.
  *
- * @todo Make it configurable and able to produce actual standard-conformant JSON
+ * In strict mode, strings and keys are escaped as JSON requires, scanning
+ * for the characters to escape with SIMD instructions where available.
+ * The bytes of strings are otherwise written unchanged, so the output is
+ * only valid UTF-8 if the strings are.
  */
 class NBT_EXPORT json_formatter
 {
 public:
     json_formatter() {}
+    explicit json_formatter(const json_options& opts): opts(opts) {}
+
+    const json_options& get_options() const { return opts; }
+
     void print(std::ostream& os, const tag& t) const;
+
+private:
+    json_options opts;
 };
 
 }
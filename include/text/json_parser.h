@@ -0,0 +1,81 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef JSON_PARSER_H_INCLUDED
+#define JSON_PARSER_H_INCLUDED
+
+#include "tagfwd.h"
+#include "text/json_formatter.h"
+#include "text/parse_error.h"
+#include <memory>
+#include <string_view>
+#include "nbt_export.h"
+
+namespace nbt
+{
+namespace text
+{
+
+/**
+ * @brief Builds tags from JSON text
+ *
+ * With json_types::typed, the input has to follow the convention that
+ * json_formatter writes in that mode, so that formatted tags are read back
+ * unchanged. The members of the typed objects may be in any order.
+ *
+ * With json_types::plain, the tag types are inferred: objects become
+ * compounds, arrays lists, strings tag_string and booleans tag_byte.
+ * Integers become tag_int, or tag_long if they don't fit, and other
+ * numbers tag_double. The elements of an array have to be of the same kind,
+ * except that numbers are widened to the largest type among them. null
+ * is only allowed as member of an object and gives an empty value.
+ *
+ * The text is tokenized in a single pass directly from memory.
+ */
+class NBT_EXPORT json_parser
+{
+public:
+    ///Maximum nesting depth of compounds and lists
+    static constexpr unsigned max_depth = 512;
+
+    json_parser() {}
+    explicit json_parser(json_types types): types(types) {}
+
+    json_types get_types() const { return types; }
+
+    /**
+     * @brief Parses a single tag, which may be surrounded by whitespace
+     * @throw parse_error on failure
+     */
+    std::unique_ptr<tag> parse(std::string_view str) const;
+
+    /**
+     * @brief Parses a single tag, making sure that it is a compound
+     * @throw parse_error on failure, or if the tag is not a compound
+     */
+    std::unique_ptr<tag_compound> parse_compound(std::string_view str) const;
+
+private:
+    json_types types = json_types::plain;
+};
+
+}
+}
+
+#endif // JSON_PARSER_H_INCLUDED
@@ -0,0 +1,50 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PARSE_ERROR_H_INCLUDED
+#define PARSE_ERROR_H_INCLUDED
+
+#include <stdexcept>
+#include <string>
+#include "nbt_export.h"
+
+namespace nbt
+{
+namespace text
+{
+
+///Exception that gets thrown when parsing text fails
+class NBT_EXPORT parse_error : public std::runtime_error
+{
+public:
+    parse_error(const std::string& msg, size_t offset):
+        std::runtime_error(msg + " at offset " + std::to_string(offset)), offset_(offset)
+    {}
+
+    ///Returns the byte offset in the input at which the error was detected
+    size_t offset() const { return offset_; }
+
+private:
+    size_t offset_;
+};
+
+}
+}
+
+#endif // PARSE_ERROR_H_INCLUDED
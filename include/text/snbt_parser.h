@@ -0,0 +1,71 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SNBT_PARSER_H_INCLUDED
+#define SNBT_PARSER_H_INCLUDED
+
+#include "tagfwd.h"
+#include "text/parse_error.h"
+#include <memory>
+#include <string_view>
+#include "nbt_export.h"
+
+namespace nbt
+{
+namespace text
+{
+
+/**
+ * @brief Parses tags from SNBT, the text format of Minecraft commands
+ *
+ * Supports compounds with quoted or unquoted keys, lists, typed arrays
+ * (<tt>[B;1b,2b]</tt>, <tt>[I;1,2]</tt>, <tt>[L;1l,2l]</tt>), numbers with
+ * the suffixes @c b, @c s, @c l, @c f and @c d, @c true and @c false as
+ * bytes, and quoted or unquoted strings. Like Minecraft, an unquoted token
+ * that is not a valid number, e.g. because it is out of range, is a string.
+ * Elements of typed arrays may also be given without suffix.
+ *
+ * The input is parsed directly from memory, so it is best to pass each
+ * string as a whole rather than reading it from a stream.
+ */
+class NBT_EXPORT snbt_parser
+{
+public:
+    ///Maximum nesting depth of compounds and lists, as in Minecraft
+    static constexpr unsigned max_depth = 512;
+
+    snbt_parser() {}
+
+    /**
+     * @brief Parses a single tag, which may be surrounded by whitespace
+     * @throw parse_error on failure
+     */
+    std::unique_ptr<tag> parse(std::string_view str) const;
+
+    /**
+     * @brief Parses a single tag, making sure that it is a compound
+     * @throw parse_error on failure, or if the tag is not a compound
+     */
+    std::unique_ptr<tag_compound> parse_compound(std::string_view str) const;
+};
+
+}
+}
+
+#endif // SNBT_PARSER_H_INCLUDED
@@ -22,6 +22,7 @@
 
 #include "tag.h"
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 namespace nbt
@@ -153,8 +154,8 @@ public:
      * @throw std::out_of_range if given key does not exist
      * @sa tag_compound::at
      */
-    value& at(const std::string& key);
-    const value& at(const std::string& key) const;
+    value& at(std::string_view key);
+    const value& at(std::string_view key) const;
 
     /**
      * @brief In case of a tag_compound, accesses a tag by key
@@ -163,7 +164,7 @@ public:
      * @throw std::bad_cast if the tag type is not tag_compound
      * @sa tag_compound::operator[]
      */
-    value& operator[](const std::string& key);
+    value& operator[](std::string_view key);
     value& operator[](const char* key); //need this overload because of conflict with built-in operator[]
 
     /**
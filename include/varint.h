@@ -0,0 +1,144 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef VARINT_H_INCLUDED
+#define VARINT_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <type_traits>
+#include "nbt_export.h"
+
+/**
+ * @brief Reading and writing variable length integers
+ *
+ * Numbers are stored in groups of 7 bits, starting with the least
+ * significant group. The high bit of each byte is set if another byte
+ * follows. Signed numbers are zigzag encoded first, so that numbers with
+ * a small absolute value take few bytes. This is the encoding that the
+ * Bedrock edition network protocol uses for NBT, see endian::network.
+ */
+namespace varint
+{
+
+///True for the number types that endian::network stores as varints
+template<class T>
+inline constexpr bool is_encoded = std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value;
+
+///Maximum number of bytes of an encoded 32 bit number
+constexpr size_t max_size32 = 5;
+///Maximum number of bytes of an encoded 64 bit number
+constexpr size_t max_size64 = 10;
+
+///Maps signed to unsigned numbers, such that small absolute values become small numbers
+inline uint32_t zigzag_encode(int32_t x) { return (static_cast<uint32_t>(x) << 1) ^ static_cast<uint32_t>(x >> 31); }
+inline uint64_t zigzag_encode(int64_t x) { return (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63); }
+
+///Inverse of zigzag_encode
+inline int32_t zigzag_decode(uint32_t x) { return static_cast<int32_t>((x >> 1) ^ (0u - (x & 1))); }
+inline int64_t zigzag_decode(uint64_t x) { return static_cast<int64_t>((x >> 1) ^ (uint64_t(0) - (x & 1))); }
+
+///Returns the number of bytes of the encoded number
+inline size_t size(uint64_t x)
+{
+    size_t n = 1;
+    for(; x >= 0x80; x >>= 7)
+        ++n;
+    return n;
+}
+
+/**
+ * @brief Encodes a number into memory
+ *
+ * There must be room for max_size32 or max_size64 bytes at @c p.
+ * @return a pointer past the last written byte
+ */
+template<class U>
+char* encode(char* p, U x)
+{
+    for(; x >= 0x80; x >>= 7)
+        *p++ = static_cast<char>(x | 0x80);
+    *p++ = static_cast<char>(x);
+    return p;
+}
+
+///@cond
+namespace detail
+{
+    NBT_EXPORT const char* decode_slow(const char* p, const char* end, uint32_t& x);
+    NBT_EXPORT const char* decode_slow(const char* p, const char* end, uint64_t& x);
+}
+///@endcond
+
+/**
+ * @brief Decodes a number from the memory range [p, end)
+ *
+ * Encodings that are longer than the maximum size or have bits set that
+ * don't fit into the number are rejected.
+ * @return a pointer past the last read byte, or null if the encoding is
+ * invalid or runs past @c end
+ */
+template<class U>
+const char* decode(const char* p, const char* end, U& x)
+{
+    //Most numbers in NBT data are small
+    if(p != end && !(*p & 0x80))
+    {
+        x = static_cast<unsigned char>(*p);
+        return p + 1;
+    }
+    return detail::decode_slow(p, end, x);
+}
+
+/**
+ * @brief Decodes n zigzag encoded numbers from the memory range [p, end)
+ *
+ * Faster than calling decode for each element, in particular if many of
+ * the numbers fit into one byte.
+ * @return a pointer past the last read byte, or null if an encoding is
+ * invalid or runs past @c end
+ */
+NBT_EXPORT const char* decode_array(const char* p, const char* end, int32_t* arr, size_t n);
+NBT_EXPORT const char* decode_array(const char* p, const char* end, int64_t* arr, size_t n);
+
+/**
+ * @brief Zigzag encodes n numbers into memory
+ *
+ * There must be room for n times max_size32 or max_size64 bytes at @c dst.
+ * @return a pointer past the last written byte
+ */
+NBT_EXPORT char* encode_array(char* dst, const int32_t* arr, size_t n);
+NBT_EXPORT char* encode_array(char* dst, const int64_t* arr, size_t n);
+
+/**
+ * @brief Reads a number from the stream
+ *
+ * On failure or if the encoding is invalid, will set the failbit on the stream.
+ */
+NBT_EXPORT void read(std::istream& is, uint32_t& x);
+NBT_EXPORT void read(std::istream& is, uint64_t& x);
+
+///Writes a number to the stream
+NBT_EXPORT void write(std::ostream& os, uint32_t x);
+NBT_EXPORT void write(std::ostream& os, uint64_t x);
+
+}
+
+#endif // VARINT_H_INCLUDED
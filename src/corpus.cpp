@@ -0,0 +1,524 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "corpus.h"
+#include "nbt_tags.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace nbt
+{
+namespace corpus
+{
+
+namespace //anonymous
+{
+    const char* const terrain_blocks[] = {
+        "minecraft:stone", "minecraft:deepslate", "minecraft:dirt", "minecraft:grass_block",
+        "minecraft:andesite", "minecraft:diorite", "minecraft:granite", "minecraft:gravel",
+        "minecraft:sand", "minecraft:water", "minecraft:lava", "minecraft:coal_ore",
+        "minecraft:iron_ore", "minecraft:copper_ore", "minecraft:gold_ore", "minecraft:tuff",
+        "minecraft:short_grass", "minecraft:oak_leaves", "minecraft:cave_air", "minecraft:bedrock"
+    };
+    //Blocks with properties, given as name, property and its possible values
+    const char* const property_blocks[][3] = {
+        {"minecraft:oak_log", "axis", "x,y,z"},
+        {"minecraft:spruce_stairs", "facing", "north,south,east,west"},
+        {"minecraft:oak_slab", "type", "top,bottom,double"},
+        {"minecraft:wall_torch", "facing", "north,south,east,west"},
+        {"minecraft:kelp", "age", "0,5,10,15,20,25"},
+        {"minecraft:redstone_wire", "power", "0,3,7,15"}
+    };
+    const char* const biome_names[] = {
+        "minecraft:plains", "minecraft:forest", "minecraft:river", "minecraft:ocean",
+        "minecraft:dripstone_caves", "minecraft:lush_caves", "minecraft:deep_dark", "minecraft:taiga"
+    };
+    const char* const item_names[] = {
+        "minecraft:cobblestone", "minecraft:oak_planks", "minecraft:torch", "minecraft:bread",
+        "minecraft:iron_ingot", "minecraft:diamond_pickaxe", "minecraft:bow", "minecraft:arrow",
+        "minecraft:redstone", "minecraft:written_book", "minecraft:enchanted_book", "minecraft:iron_sword"
+    };
+    const char* const container_ids[] = {
+        "minecraft:chest", "minecraft:barrel", "minecraft:hopper", "minecraft:dispenser"
+    };
+    const char* const entity_ids[] = {
+        "minecraft:zombie", "minecraft:skeleton", "minecraft:cow", "minecraft:sheep",
+        "minecraft:item_frame", "minecraft:villager", "minecraft:bat", "minecraft:squid"
+    };
+    const char* const enchantments[] = {
+        "minecraft:unbreaking", "minecraft:efficiency", "minecraft:fortune", "minecraft:sharpness",
+        "minecraft:mending", "minecraft:protection"
+    };
+
+    template<class T, size_t N>
+    constexpr size_t count(T (&)[N]) { return N; }
+
+    ///Number of bits needed for the indices into a palette of size n
+    int index_bits(size_t n)
+    {
+        int bits = 0;
+        while((size_t(1) << bits) < n)
+            ++bits;
+        return bits;
+    }
+
+    /**
+     * Draws the random numbers. The distributions of the standard library
+     * are not used because their results differ between implementations.
+     */
+    class random_source
+    {
+    public:
+        template<class... Seeds>
+        explicit random_source(Seeds... seeds)
+        {
+            std::seed_seq seq{uint32_t(seeds)...};
+            rng.seed(seq);
+        }
+
+        ///Uniform integer in [0, n)
+        uint32_t below(uint32_t n) { return n == 0 ? 0 : rng() % n; }
+        ///Uniform integer in [lo, hi]
+        int between(int lo, int hi) { return lo + int(below(hi - lo + 1)); }
+        ///Uniform real number in [0, 1)
+        double real() { return rng() * (1.0 / 4294967296.0); }
+        bool chance(double p) { return real() < p; }
+        uint64_t bits64() { return uint64_t(rng()) << 32 | rng(); }
+
+        template<class T, size_t N>
+        T pick(T (&arr)[N]) { return arr[below(N)]; }
+
+        ///Poisson distributed count with the given mean
+        unsigned poisson(double mean)
+        {
+            unsigned k = 0;
+            //Knuth's method, in steps to avoid underflow of exp(-mean)
+            for(; mean > 0; mean -= 20)
+            {
+                double limit = std::exp(-std::min(mean, 20.0));
+                for(double p = real(); p > limit; p *= real())
+                    ++k;
+            }
+            return k;
+        }
+
+    private:
+        std::mt19937 rng;
+    };
+
+    class builder
+    {
+    public:
+        builder(const options& opt, random_source& rnd): opt(opt), rnd(rnd) {}
+
+        tag_compound block_state(unsigned i)
+        {
+            if(i < count(terrain_blocks))
+                return tag_compound{{"Name", terrain_blocks[i]}};
+            auto& b = property_blocks[(i - count(terrain_blocks)) % count(property_blocks)];
+            std::string values = b[2];
+            std::vector<std::string> choices;
+            for(size_t pos = 0, end; pos <= values.size(); pos = end + 1)
+            {
+                end = values.find(',', pos);
+                if(end == std::string::npos)
+                    end = values.size();
+                choices.push_back(values.substr(pos, end - pos));
+            }
+            return tag_compound{
+                {"Name", b[0]},
+                {"Properties", tag_compound{
+                    {b[1], choices[rnd.below(choices.size())]},
+                    {"waterlogged", rnd.chance(0.1) ? "true" : "false"}
+                }}
+            };
+        }
+
+        ///Packs random indices into longs the way chunk sections do since 1.16
+        tag_long_array packed(size_t entries, size_t palette, int min_bits)
+        {
+            int bits = std::max(index_bits(palette), min_bits);
+            size_t per_long = 64 / bits;
+            std::vector<int64_t> data((entries + per_long - 1) / per_long);
+            //Blocks come in runs, mostly of the first entries of the palette
+            uint64_t index = 0;
+            for(size_t i = 0; i < entries; ++i)
+            {
+                if(rnd.chance(0.15))
+                    index = rnd.chance(0.5) ? rnd.below(std::min<size_t>(palette, 3)) : rnd.below(palette);
+                data[i / per_long] |= int64_t(index << (i % per_long * bits));
+            }
+            return tag_long_array(std::move(data));
+        }
+
+        tag_compound section(int y, bool air)
+        {
+            tag_compound states;
+            tag_list palette;
+            if(air)
+                palette.emplace_back<tag_compound>(tag_compound{{"Name", "minecraft:air"}});
+            else
+            {
+                unsigned size = 1 + rnd.below(std::max(opt.max_palette, 1u));
+                //Vary the blocks a bit, but keep the common ones in front
+                unsigned offset = rnd.below(4);
+                for(unsigned i = 0; i < size; ++i)
+                    palette.emplace_back<tag_compound>(block_state(i == 0 ? 0 : i + offset));
+                if(size > 1)
+                    states.put("data", packed(4096, size, 4));
+            }
+            states.put("palette", std::move(palette));
+
+            tag_compound biomes;
+            unsigned biome_count = air ? 1 : 1 + rnd.below(std::max(opt.max_biomes, 1u));
+            tag_list biome_palette;
+            for(unsigned i = 0; i < biome_count; ++i)
+                biome_palette.emplace_back<tag_string>(biome_names[(i + y + 64) % count(biome_names)]);
+            biomes.put("palette", std::move(biome_palette));
+            if(biome_count > 1)
+                biomes.put("data", packed(64, biome_count, 1));
+
+            tag_compound sec{
+                {"Y", int8_t(y)},
+                {"block_states", std::move(states)},
+                {"biomes", std::move(biomes)}
+            };
+            if(!air)
+                sec.put("BlockLight", light(0, 0.05));
+            sec.put("SkyLight", air ? light(-1, 0) : light(0, 0.3));
+            return sec;
+        }
+
+        ///Light levels, which are mostly uniform with a few lit areas
+        tag_byte_array light(int8_t base, double lit)
+        {
+            std::vector<int8_t> data(2048, base);
+            for(size_t i = 0; i < data.size(); i += 8)
+                if(rnd.chance(lit))
+                    for(size_t j = i; j < i + 8; ++j)
+                        data[j] = int8_t(rnd.below(256));
+            return tag_byte_array(std::move(data));
+        }
+
+        tag_compound item(int slot, unsigned depth)
+        {
+            tag_compound it{
+                {"id", rnd.pick(item_names)},
+                {"Count", int8_t(1 + rnd.below(64))}
+            };
+            if(slot >= 0)
+                it.put("Slot", int8_t(slot));
+            if(!rnd.chance(opt.item_tag_chance))
+                return it;
+
+            if(depth < opt.max_item_depth && rnd.chance(opt.nested_container_chance))
+            {
+                it.put("id", "minecraft:shulker_box");
+                it.put("Count", int8_t(1));
+                it.put("tag", tag_compound{
+                    {"BlockEntityTag", tag_compound{
+                        {"id", "minecraft:shulker_box"},
+                        {"Items", items(27, depth + 1)}
+                    }}
+                });
+                return it;
+            }
+
+            tag_list enchants;
+            for(unsigned n = 1 + rnd.below(3); n > 0; --n)
+                enchants.emplace_back<tag_compound>(tag_compound{
+                    {"id", rnd.pick(enchantments)},
+                    {"lvl", int16_t(1 + rnd.below(5))}
+                });
+            tag_compound tag{
+                {"Damage", int32_t(rnd.below(1562))},
+                {"RepairCost", int32_t(rnd.below(40))},
+                {"Enchantments", std::move(enchants)}
+            };
+            if(rnd.chance(0.3))
+                tag.put("display", tag_compound{
+                    {"Name", "{\"text\":\"Item " + std::to_string(rnd.below(1000)) + "\",\"italic\":false}"},
+                    {"Lore", tag_list{"{\"text\":\"A generated item\"}", "{\"text\":\"with lore\"}"}}
+                });
+            it.put("tag", std::move(tag));
+            return it;
+        }
+
+        ///A container's items, in increasing slots
+        tag_list items(int slots, unsigned depth)
+        {
+            tag_list list;
+            double fill = std::min(opt.items_per_container / slots, 1.0);
+            for(int slot = 0; slot < slots; ++slot)
+                if(rnd.chance(fill))
+                    list.emplace_back<tag_compound>(item(slot, depth));
+            return list;
+        }
+
+        tag_compound block_entity(int cx, int cz, int min_y, int max_y)
+        {
+            tag_compound be{
+                {"x", int32_t(cx * 16 + rnd.below(16))},
+                {"y", int32_t(rnd.between(min_y, max_y))},
+                {"z", int32_t(cz * 16 + rnd.below(16))},
+                {"keepPacked", int8_t(0)}
+            };
+            if(rnd.chance(opt.containers))
+            {
+                be.put("id", rnd.pick(container_ids));
+                be.put("Items", items(27, 0));
+                if(rnd.chance(0.2))
+                    be.put("LootTable", "minecraft:chests/simple_dungeon");
+            }
+            else
+            {
+                auto text = [&] {
+                    return tag_compound{
+                        {"messages", tag_list{"{\"text\":\"Hello\"}", "\"\"", "\"\"", "\"\""}},
+                        {"color", "black"},
+                        {"has_glowing_text", int8_t(0)}
+                    };
+                };
+                be.put("id", "minecraft:sign");
+                be.put("front_text", text());
+                be.put("back_text", text());
+                be.put("is_waxed", int8_t(0));
+            }
+            return be;
+        }
+
+        tag_compound entity(int cx, int cz, int min_y, int max_y)
+        {
+            auto armor = [&] {
+                tag_list list;
+                for(int i = 0; i < 4; ++i)
+                    list.emplace_back<tag_compound>(rnd.chance(0.1) ? item(-1, 0) : tag_compound());
+                return list;
+            };
+            return tag_compound{
+                {"id", rnd.pick(entity_ids)},
+                {"Pos", tag_list{cx * 16 + rnd.real() * 16, rnd.between(min_y, max_y) + rnd.real(),
+                                 cz * 16 + rnd.real() * 16}},
+                {"Motion", tag_list{0.0, -0.0784000015258789, 0.0}},
+                {"Rotation", tag_list{float(rnd.real() * 360), 0.0f}},
+                {"Health", float(rnd.between(1, 20))},
+                {"Air", int16_t(300)},
+                {"Fire", int16_t(-1)},
+                {"FallDistance", 0.0f},
+                {"OnGround", int8_t(1)},
+                {"Invulnerable", int8_t(0)},
+                {"PortalCooldown", 0},
+                {"UUID", tag_int_array{int32_t(rnd.below(~0u)), int32_t(rnd.below(~0u)),
+                                       int32_t(rnd.below(~0u)), int32_t(rnd.below(~0u))}},
+                {"Attributes", tag_list::of<tag_compound>({
+                    {{"Name", "minecraft:generic.movement_speed"}, {"Base", 0.23}},
+                    {{"Name", "minecraft:generic.max_health"}, {"Base", 20.0}}
+                })},
+                {"ArmorItems", armor()},
+                {"HandItems", tag_list::of<tag_compound>({{}, {}})},
+                {"Brain", tag_compound{{"memories", tag_compound()}}}
+            };
+        }
+
+        tag_long_array heightmap(int max_height)
+        {
+            //256 entries with 9 bits each
+            std::vector<int64_t> data(37);
+            for(size_t i = 0; i < 256; ++i)
+                data[i / 7] |= int64_t(uint64_t(rnd.below(max_height + 1)) << (i % 7 * 9));
+            return tag_long_array(std::move(data));
+        }
+
+    private:
+        const options& opt;
+        random_source& rnd;
+    };
+
+    //Keep the streams of random numbers of the generator's functions apart
+    constexpr uint32_t chunk_stream = 0x43484e4b;
+    constexpr uint32_t level_stream = 0x4c45564c;
+    constexpr uint32_t item_stream = 0x4954454d;
+}
+
+generator::generator(const options& opt):
+    opt(opt)
+{}
+
+std::unique_ptr<tag_compound> generator::chunk(int x, int z) const
+{
+    random_source rnd(opt.seed, chunk_stream, x, z);
+    builder b(opt, rnd);
+
+    const int min_section = -4;
+    const int sections = opt.sections;
+    //The terrain fills about the lower two thirds, the rest is air
+    const int solid = std::max(1, sections * 2 / 3);
+    const int min_y = min_section * 16;
+    const int max_y = (min_section + solid) * 16 - 1;
+
+    tag_list section_list;
+    for(int i = 0; i < sections; ++i)
+        section_list.emplace_back<tag_compound>(b.section(min_section + i, i >= solid));
+
+    tag_list block_entities;
+    for(unsigned n = rnd.poisson(opt.block_entities); n > 0; --n)
+        block_entities.emplace_back<tag_compound>(b.block_entity(x, z, min_y, max_y));
+
+    tag_list entities;
+    for(unsigned n = rnd.poisson(opt.entities); n > 0; --n)
+        entities.emplace_back<tag_compound>(b.entity(x, z, min_y, max_y));
+
+    int height = solid * 16;
+    return std::unique_ptr<tag_compound>(new tag_compound{
+        {"DataVersion", 3700},
+        {"xPos", x},
+        {"yPos", min_section},
+        {"zPos", z},
+        {"Status", "minecraft:full"},
+        {"LastUpdate", int64_t(rnd.below(10000000))},
+        {"InhabitedTime", int64_t(rnd.below(100000))},
+        {"isLightOn", int8_t(1)},
+        {"sections", std::move(section_list)},
+        {"block_entities", std::move(block_entities)},
+        {"entities", std::move(entities)},
+        {"Heightmaps", tag_compound{
+            {"MOTION_BLOCKING", b.heightmap(height)},
+            {"MOTION_BLOCKING_NO_LEAVES", b.heightmap(height)},
+            {"OCEAN_FLOOR", b.heightmap(height)},
+            {"WORLD_SURFACE", b.heightmap(height)}
+        }},
+        {"structures", tag_compound{
+            {"References", tag_compound()},
+            {"starts", tag_compound()}
+        }},
+        {"block_ticks", tag_list()},
+        {"fluid_ticks", tag_list()},
+        {"PostProcessing", tag_list()}
+    });
+}
+
+std::unique_ptr<tag_compound> generator::level() const
+{
+    random_source rnd(opt.seed, level_stream);
+    builder b(opt, rnd);
+
+    static const char* const bool_rules[] = {
+        "announceAdvancements", "commandBlockOutput", "disableElytraMovementCheck", "disableRaids",
+        "doDaylightCycle", "doEntityDrops", "doFireTick", "doImmediateRespawn", "doInsomnia",
+        "doLimitedCrafting", "doMobLoot", "doMobSpawning", "doPatrolSpawning", "doTileDrops",
+        "doTraderSpawning", "doWeatherCycle", "drowningDamage", "fallDamage", "fireDamage",
+        "forgiveDeadPlayers", "freezeDamage", "keepInventory", "logAdminCommands",
+        "mobGriefing", "naturalRegeneration", "reducedDebugInfo", "sendCommandFeedback",
+        "showDeathMessages", "spectatorsGenerateChunks", "universalAnger"
+    };
+    tag_compound rules;
+    for(const char* rule: bool_rules)
+        rules.put(rule, rnd.chance(0.8) ? "true" : "false");
+    rules.put("maxEntityCramming", "24");
+    rules.put("randomTickSpeed", "3");
+    rules.put("spawnRadius", "10");
+
+    tag_list inventory;
+    for(int slot = 0; slot < 36; ++slot)
+        if(rnd.chance(0.6))
+            inventory.emplace_back<tag_compound>(b.item(slot, 0));
+
+    tag_compound player{
+        {"Pos", tag_list{rnd.real() * 1000, 70.0, rnd.real() * 1000}},
+        {"Motion", tag_list{0.0, 0.0, 0.0}},
+        {"Rotation", tag_list{float(rnd.real() * 360), 0.0f}},
+        {"Dimension", "minecraft:overworld"},
+        {"Health", 20.0f},
+        {"foodLevel", 20},
+        {"XpLevel", int32_t(rnd.below(50))},
+        {"XpP", float(rnd.real())},
+        {"playerGameType", 0},
+        {"SelectedItemSlot", 0},
+        {"Inventory", std::move(inventory)},
+        {"EnderItems", b.items(27, 0)},
+        {"abilities", tag_compound{
+            {"flying", int8_t(0)}, {"flySpeed", 0.05f}, {"instabuild", int8_t(0)},
+            {"invulnerable", int8_t(0)}, {"mayBuild", int8_t(1)}, {"mayfly", int8_t(0)},
+            {"walkSpeed", 0.1f}
+        }},
+        {"UUID", tag_int_array{int32_t(rnd.below(~0u)), int32_t(rnd.below(~0u)),
+                               int32_t(rnd.below(~0u)), int32_t(rnd.below(~0u))}}
+    };
+
+    tag_compound data{
+        {"version", 19133},
+        {"DataVersion", 3700},
+        {"LevelName", "Generated world " + std::to_string(opt.seed)},
+        {"GameType", 0},
+        {"Difficulty", int8_t(2)},
+        {"hardcore", int8_t(0)},
+        {"allowCommands", int8_t(0)},
+        {"initialized", int8_t(1)},
+        {"SpawnX", int32_t(rnd.between(-100, 100))},
+        {"SpawnY", 64},
+        {"SpawnZ", int32_t(rnd.between(-100, 100))},
+        {"SpawnAngle", 0.0f},
+        {"Time", int64_t(rnd.bits64() >> 40)},
+        {"DayTime", int64_t(rnd.below(24000))},
+        {"LastPlayed", int64_t(1700000000000 + (rnd.bits64() >> 32))},
+        {"raining", int8_t(0)},
+        {"rainTime", int32_t(rnd.below(100000))},
+        {"thundering", int8_t(0)},
+        {"thunderTime", int32_t(rnd.below(100000))},
+        {"GameRules", std::move(rules)},
+        {"WorldGenSettings", tag_compound{
+            {"seed", int64_t(rnd.bits64())},
+            {"generate_features", int8_t(1)},
+            {"bonus_chest", int8_t(0)},
+            {"dimensions", tag_compound{
+                {"minecraft:overworld", tag_compound{
+                    {"type", "minecraft:overworld"},
+                    {"generator", tag_compound{
+                        {"type", "minecraft:noise"},
+                        {"settings", "minecraft:overworld"},
+                        {"biome_source", tag_compound{
+                            {"type", "minecraft:multi_noise"},
+                            {"preset", "minecraft:overworld"}
+                        }}
+                    }}
+                }}
+            }}
+        }},
+        {"Version", tag_compound{
+            {"Id", 3700}, {"Name", "1.20.4"}, {"Series", "main"}, {"Snapshot", int8_t(0)}
+        }},
+        {"DataPacks", tag_compound{
+            {"Enabled", tag_list{"vanilla"}},
+            {"Disabled", tag_list::of<tag_string>({"bundle", "trade_rebalance"})}
+        }},
+        {"Player", std::move(player)}
+    };
+    return std::unique_ptr<tag_compound>(new tag_compound{{"Data", std::move(data)}});
+}
+
+std::unique_ptr<tag_compound> generator::item(uint32_t index) const
+{
+    random_source rnd(opt.seed, item_stream, index);
+    return std::unique_ptr<tag_compound>(new tag_compound(builder(opt, rnd).item(-1, 0)));
+}
+
+}
+}
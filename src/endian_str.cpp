@@ -18,10 +18,20 @@
  * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "endian_str.h"
+#include <algorithm>
 #include <climits>
 #include <cstring>
 #include <iostream>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NBT_ENDIAN_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 static_assert(CHAR_BIT == 8, "Assuming that a byte has 8 bits");
 static_assert(sizeof(float) == 4, "Assuming that a float is 4 byte long");
 static_assert(sizeof(double) == 8, "Assuming that a double is 8 byte long");
@@ -55,6 +65,158 @@ namespace //anonymous
         memcpy(&ret, &f, 8);
         return ret;
     }
+
+    bool native_is_little()
+    {
+        const uint16_t probe = 1;
+        unsigned char first;
+        memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    //Byte swapping kernels for arrays of 2, 4 and 8 byte numbers.
+    //The vectorized loops handle the bulk, the scalar loop the remainder.
+    void swap_array_16(unsigned char* p, size_t n)
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i mask = _mm256_setr_epi8(
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        for(; i + 16 <= n; i += 16)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i*>(p + 2*i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 2*i), _mm256_shuffle_epi8(v, mask));
+        }
+#elif defined(NBT_ENDIAN_SSE2)
+        for(; i + 8 <= n; i += 8)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i*>(p + 2*i));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 2*i), v);
+        }
+#elif defined(__ARM_NEON)
+        for(; i + 8 <= n; i += 8)
+            vst1q_u8(p + 2*i, vrev16q_u8(vld1q_u8(p + 2*i)));
+#endif
+        for(; i < n; ++i)
+            std::swap(p[2*i], p[2*i + 1]);
+    }
+
+    void swap_array_32(unsigned char* p, size_t n)
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i mask = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        for(; i + 8 <= n; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i*>(p + 4*i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 4*i), _mm256_shuffle_epi8(v, mask));
+        }
+#elif defined(NBT_ENDIAN_SSE2)
+        for(; i + 4 <= n; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i*>(p + 4*i));
+            //Swap the bytes within each 16 bit word, then swap the words
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 4*i), v);
+        }
+#elif defined(__ARM_NEON)
+        for(; i + 4 <= n; i += 4)
+            vst1q_u8(p + 4*i, vrev32q_u8(vld1q_u8(p + 4*i)));
+#endif
+        for(; i < n; ++i)
+        {
+            std::swap(p[4*i], p[4*i + 3]);
+            std::swap(p[4*i + 1], p[4*i + 2]);
+        }
+    }
+
+    void swap_array_64(unsigned char* p, size_t n)
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i mask = _mm256_setr_epi8(
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+        for(; i + 4 <= n; i += 4)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i*>(p + 8*i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 8*i), _mm256_shuffle_epi8(v, mask));
+        }
+#elif defined(NBT_ENDIAN_SSE2)
+        for(; i + 2 <= n; i += 2)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i*>(p + 8*i));
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 8*i), v);
+        }
+#elif defined(__ARM_NEON)
+        for(; i + 2 <= n; i += 2)
+            vst1q_u8(p + 8*i, vrev64q_u8(vld1q_u8(p + 8*i)));
+#endif
+        for(; i < n; ++i)
+        {
+            std::swap(p[8*i], p[8*i + 7]);
+            std::swap(p[8*i + 1], p[8*i + 6]);
+            std::swap(p[8*i + 2], p[8*i + 5]);
+            std::swap(p[8*i + 3], p[8*i + 4]);
+        }
+    }
+
+    ///Converts n numbers of the given size between the given and the native byte order in place
+    void convert_bytes(unsigned char* p, size_t size, size_t n, endian e)
+    {
+        if((e != big) == native_is_little())
+            return;
+        switch(size)
+        {
+        case 2: swap_array_16(p, n); break;
+        case 4: swap_array_32(p, n); break;
+        case 8: swap_array_64(p, n); break;
+        }
+    }
+
+    template<class T>
+    void convert_raw(T* arr, size_t n, endian e)
+    {
+        convert_bytes(reinterpret_cast<unsigned char*>(arr), sizeof(T), n, e);
+    }
+
+    template<class T>
+    void read_array_impl(std::istream& is, T* arr, size_t n, endian e)
+    {
+        is.read(reinterpret_cast<char*>(arr), n * sizeof(T));
+        convert_raw(arr, n, e);
+    }
+
+    template<class T>
+    void write_array_impl(std::ostream& os, const T* arr, size_t n, endian e)
+    {
+        //Convert block by block in a temporary buffer, as we can't modify the input
+        const size_t block_len = 4096 / sizeof(T);
+        T buf[block_len];
+        for(size_t i = 0; i < n; i += block_len)
+        {
+            size_t len = std::min(block_len, n - i);
+            memcpy(buf, arr + i, len * sizeof(T));
+            convert_raw(buf, len, e);
+            os.write(reinterpret_cast<const char*>(buf), len * sizeof(T));
+        }
+    }
+
+    template<class T>
+    void write_array_impl(char* dst, const T* arr, size_t n, endian e)
+    {
+        memcpy(dst, arr, n * sizeof(T));
+        convert_bytes(reinterpret_cast<unsigned char*>(dst), sizeof(T), n, e);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -281,4 +443,30 @@ void write_big(std::ostream& os, double x)
     write_big(os, pun_double_to_int(x));
 }
 
+//------------------------------------------------------------------------------
+
+void read_array(std::istream& is, int16_t* arr, size_t n, endian e) { read_array_impl(is, arr, n, e); }
+void read_array(std::istream& is, int32_t* arr, size_t n, endian e) { read_array_impl(is, arr, n, e); }
+void read_array(std::istream& is, int64_t* arr, size_t n, endian e) { read_array_impl(is, arr, n, e); }
+void read_array(std::istream& is, float*   arr, size_t n, endian e) { read_array_impl(is, arr, n, e); }
+void read_array(std::istream& is, double*  arr, size_t n, endian e) { read_array_impl(is, arr, n, e); }
+
+void write_array(std::ostream& os, const int16_t* arr, size_t n, endian e) { write_array_impl(os, arr, n, e); }
+void write_array(std::ostream& os, const int32_t* arr, size_t n, endian e) { write_array_impl(os, arr, n, e); }
+void write_array(std::ostream& os, const int64_t* arr, size_t n, endian e) { write_array_impl(os, arr, n, e); }
+void write_array(std::ostream& os, const float*   arr, size_t n, endian e) { write_array_impl(os, arr, n, e); }
+void write_array(std::ostream& os, const double*  arr, size_t n, endian e) { write_array_impl(os, arr, n, e); }
+
+void write_array(char* dst, const int16_t* arr, size_t n, endian e) { write_array_impl(dst, arr, n, e); }
+void write_array(char* dst, const int32_t* arr, size_t n, endian e) { write_array_impl(dst, arr, n, e); }
+void write_array(char* dst, const int64_t* arr, size_t n, endian e) { write_array_impl(dst, arr, n, e); }
+void write_array(char* dst, const float*   arr, size_t n, endian e) { write_array_impl(dst, arr, n, e); }
+void write_array(char* dst, const double*  arr, size_t n, endian e) { write_array_impl(dst, arr, n, e); }
+
+void convert_array(int16_t* arr, size_t n, endian e) { convert_raw(arr, n, e); }
+void convert_array(int32_t* arr, size_t n, endian e) { convert_raw(arr, n, e); }
+void convert_array(int64_t* arr, size_t n, endian e) { convert_raw(arr, n, e); }
+void convert_array(float*   arr, size_t n, endian e) { convert_raw(arr, n, e); }
+void convert_array(double*  arr, size_t n, endian e) { convert_raw(arr, n, e); }
+
 }
@@ -0,0 +1,217 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/codec.h"
+#include <istream>
+#include <iterator>
+#include <ostream>
+
+#ifdef NBT_HAVE_ZLIB
+#include "io/izlibstream.h"
+#include "io/ozlibstream.h"
+#include "io/zlib_buffer.h"
+#endif
+#ifdef NBT_HAVE_LZ4
+#include "io/lz4stream.h"
+#endif
+#ifdef NBT_HAVE_ZSTD
+#include "io/zstdstream.h"
+#endif
+
+namespace nbt
+{
+namespace io
+{
+
+namespace //anonymous
+{
+    class none_codec : public codec
+    {
+    public:
+        const char* name() const override { return "none"; }
+        compression scheme() const override { return compression::none; }
+
+        void compress(const char* data, size_t size, std::string& out, int) const override
+        {
+            out.assign(data, size);
+        }
+
+        void decompress(const char* data, size_t size, std::string& out, size_t) const override
+        {
+            out.assign(data, size);
+        }
+
+        std::unique_ptr<std::istream> open_istream(std::istream& is) const override
+        {
+            return std::make_unique<std::istream>(is.rdbuf());
+        }
+
+        std::unique_ptr<std::ostream> open_ostream(std::ostream& os, int) const override
+        {
+            return std::make_unique<std::ostream>(os.rdbuf());
+        }
+    };
+
+#ifdef NBT_HAVE_ZLIB
+    class zlib_codec : public codec
+    {
+    public:
+        explicit zlib_codec(bool gzip): gzip(gzip) {}
+
+        const char* name() const override { return gzip ? "gzip" : "zlib"; }
+        compression scheme() const override { return gzip ? compression::gzip : compression::zlib; }
+
+        void compress(const char* data, size_t size, std::string& out, int level) const override
+        {
+            zlib::compress(data, size, out, level, gzip);
+        }
+
+        //zlib::decompress detects the format, so either codec reads both
+        void decompress(const char* data, size_t size, std::string& out, size_t size_hint) const override
+        {
+            zlib::decompress(data, size, out, size_hint);
+        }
+
+        std::unique_ptr<std::istream> open_istream(std::istream& is) const override
+        {
+            return std::make_unique<zlib::izlibstream>(is);
+        }
+
+        std::unique_ptr<std::ostream> open_ostream(std::ostream& os, int level) const override
+        {
+            return std::make_unique<zlib::ozlibstream>(os, level, gzip);
+        }
+
+    private:
+        bool gzip;
+    };
+#endif
+
+#ifdef NBT_HAVE_LZ4
+    class lz4_codec : public codec
+    {
+    public:
+        const char* name() const override { return "lz4"; }
+        compression scheme() const override { return compression::lz4; }
+
+        void compress(const char* data, size_t size, std::string& out, int level) const override
+        {
+            lz4::compress(data, size, out, level);
+        }
+
+        void decompress(const char* data, size_t size, std::string& out, size_t size_hint) const override
+        {
+            lz4::decompress(data, size, out, size_hint);
+        }
+
+        std::unique_ptr<std::istream> open_istream(std::istream& is) const override
+        {
+            return std::make_unique<lz4::ilz4stream>(is);
+        }
+
+        std::unique_ptr<std::ostream> open_ostream(std::ostream& os, int level) const override
+        {
+            return std::make_unique<lz4::olz4stream>(os, level);
+        }
+    };
+#endif
+
+#ifdef NBT_HAVE_ZSTD
+    class zstd_codec : public codec
+    {
+    public:
+        const char* name() const override { return "zstd"; }
+        //Vanilla Minecraft has no compression type for zstd
+        compression scheme() const override { return compression::custom; }
+
+        void compress(const char* data, size_t size, std::string& out, int level) const override
+        {
+            zstd::compress(data, size, out, level);
+        }
+
+        void decompress(const char* data, size_t size, std::string& out, size_t size_hint) const override
+        {
+            zstd::decompress(data, size, out, size_hint);
+        }
+
+        std::unique_ptr<std::istream> open_istream(std::istream& is) const override
+        {
+            return std::make_unique<zstd::izstdstream>(is);
+        }
+
+        std::unique_ptr<std::ostream> open_ostream(std::ostream& os, int level) const override
+        {
+            return std::make_unique<zstd::ozstdstream>(os, level);
+        }
+    };
+#endif
+
+    const none_codec none_impl;
+#ifdef NBT_HAVE_ZLIB
+    const zlib_codec gzip_impl(true);
+    const zlib_codec zlib_impl(false);
+#endif
+#ifdef NBT_HAVE_LZ4
+    const lz4_codec lz4_impl;
+#endif
+#ifdef NBT_HAVE_ZSTD
+    const zstd_codec zstd_impl;
+#endif
+
+    const codec* const codecs[] = {
+        &none_impl,
+#ifdef NBT_HAVE_ZLIB
+        &gzip_impl,
+        &zlib_impl,
+#endif
+#ifdef NBT_HAVE_LZ4
+        &lz4_impl,
+#endif
+#ifdef NBT_HAVE_ZSTD
+        &zstd_impl,
+#endif
+    };
+}
+
+const codec* get_codec(compression scheme)
+{
+    //The custom scheme names its codec separately, so it never maps to one
+    if(scheme == compression::custom)
+        return nullptr;
+    for(const codec* c: codecs)
+        if(c->scheme() == scheme)
+            return c;
+    return nullptr;
+}
+
+const codec* find_codec(const std::string& name)
+{
+    for(const codec* c: codecs)
+        if(name == c->name())
+            return c;
+    return nullptr;
+}
+
+std::vector<const codec*> available_codecs()
+{
+    return std::vector<const codec*>(std::begin(codecs), std::end(codecs));
+}
+
+}
+}
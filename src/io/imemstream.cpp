@@ -0,0 +1,61 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/imemstream.h"
+
+namespace nbt
+{
+namespace io
+{
+
+imem_streambuf::imem_streambuf(const char* data, size_t size)
+{
+    //The buffer is never written to, so casting away const is fine
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+}
+
+imem_streambuf::pos_type imem_streambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if(!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+
+    off_type base;
+    switch(dir)
+    {
+    case std::ios_base::beg: base = 0; break;
+    case std::ios_base::cur: base = gptr() - eback(); break;
+    case std::ios_base::end: base = egptr() - eback(); break;
+    default: return pos_type(off_type(-1));
+    }
+
+    off_type pos = base + off;
+    if(pos < 0 || pos > egptr() - eback())
+        return pos_type(off_type(-1));
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+}
+
+imem_streambuf::pos_type imem_streambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+}
+}
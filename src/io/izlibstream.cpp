@@ -19,6 +19,7 @@
  */
 #include "io/izlibstream.h"
 #include "io/zlib_streambuf.h"
+#include "stats.h"
 
 namespace zlib
 {
@@ -97,7 +98,11 @@ inflate_streambuf::int_type inflate_streambuf::underflow()
         zstr.next_out = reinterpret_cast<Bytef*>(out.data());
         zstr.avail_out = out.size();
 
-        int ret = inflate(&zstr, Z_NO_FLUSH);
+        int ret;
+        {
+            nbt::stats::detail::inflate_timer timer;
+            ret = inflate(&zstr, Z_NO_FLUSH);
+        }
         have = out.size() - zstr.avail_out;
         switch(ret)
         {
@@ -0,0 +1,80 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/level_dat.h"
+#include "io/imemstream.h"
+#include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace nbt
+{
+namespace io
+{
+
+level_dat_header read_level_dat_header(std::istream& is)
+{
+    level_dat_header header;
+    endian::read_little(is, header.version);
+    endian::read_little(is, header.length);
+    if(!is)
+        throw input_error("Error reading level.dat header");
+    return header;
+}
+
+void write_level_dat_header(std::ostream& os, const level_dat_header& header)
+{
+    endian::write_little(os, header.version);
+    endian::write_little(os, header.length);
+}
+
+level_dat read_level_dat(std::istream& is)
+{
+    level_dat_header header = read_level_dat_header(is);
+
+    std::string buf;
+    detail::read_in_blocks(buf, header.length, is, [&is](char* dst, size_t len) { is.read(dst, len); });
+    if(!is)
+        throw input_error("Error reading level.dat");
+
+    imem_streambuf sbuf(buf.data(), buf.size());
+    std::istream mstr(&sbuf);
+    auto pair = stream_reader(mstr, endian::little).read_compound();
+    if(sbuf.remaining() != 0)
+        throw input_error("Length of the tag in level.dat does not match the header");
+    return {header.version, std::move(pair.first), std::move(pair.second)};
+}
+
+void write_level_dat(int32_t version, const std::string& key, const tag_compound& root, std::ostream& os)
+{
+    stream_writer writer(os, endian::little);
+    size_t length = writer.tag_size(key, root);
+    if(length > UINT32_MAX)
+    {
+        os.setstate(std::ios::failbit);
+        throw std::length_error("Tag is too large for level.dat");
+    }
+    write_level_dat_header(os, {version, static_cast<uint32_t>(length)});
+    writer.write_tag(key, root);
+}
+
+}
+}
@@ -0,0 +1,342 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/lz4stream.h"
+#include "endian_str.h"
+#include "stats.h"
+#include <algorithm>
+#include <cstring>
+#include <lz4.h>
+#include <lz4hc.h>
+
+namespace lz4
+{
+
+using nbt::io::codec_error;
+
+namespace //anonymous
+{
+    const char magic[] = {'L', 'Z', '4', 'B', 'l', 'o', 'c', 'k'};
+    constexpr size_t header_size = sizeof(magic) + 1 + 3 * 4;
+    constexpr int method_raw = 0x10;
+    constexpr int method_lz4 = 0x20;
+    constexpr int block_bits_base = 10;
+    constexpr uint32_t checksum_seed = 0x9747b28c;
+
+    ///The header of a block
+    struct block_header
+    {
+        int method;
+        size_t max_size;
+        size_t compressed_size;
+        size_t original_size;
+        uint32_t check;
+    };
+
+    inline uint32_t rotl(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+
+    inline uint32_t load32(const unsigned char* p)
+    {
+        return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    }
+
+    uint32_t xxh32(const char* data, size_t size, uint32_t seed)
+    {
+        constexpr uint32_t p1 = 2654435761u, p2 = 2246822519u, p3 = 3266489917u,
+                           p4 = 668265263u, p5 = 374761393u;
+        auto round = [](uint32_t acc, uint32_t input) { return rotl(acc + input * p2, 13) * p1; };
+
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* end = p + size;
+        uint32_t h;
+        if(size >= 16)
+        {
+            uint32_t v1 = seed + p1 + p2, v2 = seed + p2, v3 = seed, v4 = seed - p1;
+            for(; end - p >= 16; p += 16)
+            {
+                v1 = round(v1, load32(p));
+                v2 = round(v2, load32(p + 4));
+                v3 = round(v3, load32(p + 8));
+                v4 = round(v4, load32(p + 12));
+            }
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        }
+        else
+            h = seed + p5;
+
+        h += static_cast<uint32_t>(size);
+        for(; end - p >= 4; p += 4)
+            h = rotl(h + load32(p) * p3, 17) * p4;
+        for(; p < end; ++p)
+            h = rotl(h + *p * p5, 11) * p1;
+
+        h ^= h >> 15;
+        h *= p2;
+        h ^= h >> 13;
+        h *= p3;
+        h ^= h >> 16;
+        return h;
+    }
+
+    ///Returns the base two logarithm of the block size minus 10
+    int block_bits(size_t block_size)
+    {
+        for(int bits = 0; bits <= 15; ++bits)
+            if(block_size == size_t(1) << (block_bits_base + bits))
+                return bits;
+        throw codec_error("Invalid LZ4 block size " + std::to_string(block_size));
+    }
+
+    void check_level(int level)
+    {
+        if(level < -1 || level > LZ4HC_CLEVEL_MAX)
+            throw codec_error("Invalid LZ4 compression level " + std::to_string(level));
+    }
+
+    void write_header(char* dst, int token, size_t compressed, size_t original, uint32_t check)
+    {
+        std::memcpy(dst, magic, sizeof(magic));
+        dst[sizeof(magic)] = static_cast<char>(token);
+        endian::write_little(dst + sizeof(magic) + 1, static_cast<uint32_t>(compressed));
+        endian::write_little(dst + sizeof(magic) + 5, static_cast<uint32_t>(original));
+        endian::write_little(dst + sizeof(magic) + 9, check);
+    }
+
+    ///Returns the space that a block of the given size can take up at most
+    size_t block_bound(size_t size)
+    {
+        return header_size + LZ4_compressBound(static_cast<int>(size));
+    }
+
+    /**
+     * Writes a block to @c dst, which must have room for block_bound(size)
+     * bytes, and returns the number of bytes written.
+     */
+    size_t write_block(const char* src, size_t size, char* dst, int level, int bits)
+    {
+        int bound = LZ4_compressBound(static_cast<int>(size));
+        int n = level > 0
+            ? LZ4_compress_HC(src, dst + header_size, static_cast<int>(size), bound, level)
+            : LZ4_compress_default(src, dst + header_size, static_cast<int>(size), bound);
+        int method = method_lz4;
+        //Like lz4-java, store blocks that don't get smaller
+        if(n <= 0 || size_t(n) >= size)
+        {
+            std::memcpy(dst + header_size, src, size);
+            n = static_cast<int>(size);
+            method = method_raw;
+        }
+        write_header(dst, method | bits, n, size, checksum(src, size));
+        return header_size + n;
+    }
+
+    ///Parses and validates the header of a block
+    block_header read_header(const char* p)
+    {
+        if(std::memcmp(p, magic, sizeof(magic)) != 0)
+            throw codec_error("Invalid LZ4 block magic");
+        int token = static_cast<unsigned char>(p[sizeof(magic)]);
+        uint32_t compressed, original;
+        block_header h;
+        h.method = token & 0xf0;
+        h.max_size = size_t(1) << (block_bits_base + (token & 0x0f));
+        endian::read_little(p + sizeof(magic) + 1, compressed);
+        endian::read_little(p + sizeof(magic) + 5, original);
+        endian::read_little(p + sizeof(magic) + 9, h.check);
+        h.compressed_size = compressed;
+        h.original_size = original;
+
+        if((h.method != method_raw && h.method != method_lz4)
+            || h.original_size > h.max_size
+            || h.compressed_size > size_t(LZ4_compressBound(static_cast<int>(h.max_size)))
+            || (h.original_size == 0) != (h.compressed_size == 0)
+            || (h.method == method_raw && h.original_size != h.compressed_size))
+            throw codec_error("Invalid LZ4 block header");
+        return h;
+    }
+
+    ///Decompresses the data of a block into @c dst, which has room for h.original_size bytes
+    void read_block(const block_header& h, const char* src, char* dst)
+    {
+        nbt::stats::detail::inflate_timer timer;
+        if(h.method == method_raw)
+            std::memcpy(dst, src, h.original_size);
+        else
+        {
+            int n = LZ4_decompress_safe(src, dst, static_cast<int>(h.compressed_size),
+                                        static_cast<int>(h.original_size));
+            if(n < 0 || size_t(n) != h.original_size)
+                throw codec_error("Corrupt LZ4 block");
+        }
+        if(checksum(dst, h.original_size) != h.check)
+            throw codec_error("LZ4 block checksum mismatch");
+    }
+}
+
+uint32_t checksum(const char* data, size_t size)
+{
+    return xxh32(data, size, checksum_seed) & 0x0fffffff;
+}
+
+void compress(const char* data, size_t size, std::string& out, int level, size_t block_size)
+{
+    check_level(level);
+    int bits = block_bits(block_size);
+    size_t blocks = (size + block_size - 1) / block_size;
+    out.resize(blocks * block_bound(block_size) + header_size);
+
+    char* dst = &out[0];
+    for(size_t pos = 0; pos < size; pos += block_size)
+        dst += write_block(data + pos, std::min(block_size, size - pos), dst, level, bits);
+    write_header(dst, method_raw | bits, 0, 0, 0);
+    out.resize(dst + header_size - out.data());
+}
+
+void decompress(const char* data, size_t size, std::string& out, size_t size_hint)
+{
+    out.clear();
+    if(size_hint != 0)
+        out.reserve(size_hint);
+
+    for(size_t pos = 0;;)
+    {
+        if(size - pos < header_size)
+            throw codec_error("Unexpected end of LZ4 stream");
+        block_header h = read_header(data + pos);
+        pos += header_size;
+        if(h.original_size == 0)
+            return;
+        if(size - pos < h.compressed_size)
+            throw codec_error("Unexpected end of LZ4 stream");
+
+        size_t old_size = out.size();
+        out.resize(old_size + h.original_size);
+        read_block(h, data + pos, &out[old_size]);
+        pos += h.compressed_size;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+decompress_streambuf::int_type decompress_streambuf::underflow()
+{
+    if(gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    if(stream_end)
+        return traits_type::eof();
+
+    char header[header_size];
+    if(!is.read(header, header_size))
+        throw codec_error("Unexpected end of LZ4 stream");
+    block_header h = read_header(header);
+    if(h.original_size == 0)
+    {
+        stream_end = true;
+        return traits_type::eof();
+    }
+
+    in.resize(h.compressed_size);
+    if(!is.read(in.data(), in.size()))
+        throw codec_error("Unexpected end of LZ4 stream");
+    out.resize(h.original_size);
+    read_block(h, in.data(), out.data());
+
+    setg(out.data(), out.data(), out.data() + out.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+compress_streambuf::compress_streambuf(std::ostream& output, int level, size_t block_size):
+    os(output), level(level)
+{
+    check_level(level);
+    block_bits(block_size);
+    in.resize(block_size);
+    setp(in.data(), in.data() + in.size());
+}
+
+compress_streambuf::~compress_streambuf() noexcept
+{
+    try
+    {
+        close();
+    }
+    catch(...)
+    {
+        //ignore as we can't do anything about it
+    }
+}
+
+void compress_streambuf::write_block()
+{
+    size_t size = pptr() - pbase();
+    if(size > 0)
+    {
+        out.resize(block_bound(size));
+        size_t n = lz4::write_block(pbase(), size, &out[0], level, block_bits(in.size()));
+        if(!os.write(out.data(), n))
+            throw std::ios_base::failure("Could not write to the output stream");
+    }
+    setp(in.data(), in.data() + in.size());
+}
+
+void compress_streambuf::close()
+{
+    if(!is_open_)
+        return;
+    write_block();
+    char end_mark[header_size];
+    write_header(end_mark, method_raw | block_bits(in.size()), 0, 0, 0);
+    is_open_ = false;
+    if(!os.write(end_mark, header_size))
+        throw std::ios_base::failure("Could not write to the output stream");
+}
+
+compress_streambuf::int_type compress_streambuf::overflow(int_type ch)
+{
+    if(!is_open_)
+        return traits_type::eof();
+    write_block();
+    if(ch != traits_type::eof())
+    {
+        *pptr() = ch;
+        pbump(1);
+    }
+    return ch;
+}
+
+int compress_streambuf::sync()
+{
+    if(is_open_)
+        write_block();
+    return 0;
+}
+
+void olz4stream::close()
+{
+    try
+    {
+        buf.close();
+    }
+    catch(...)
+    {
+        setstate(badbit);
+    }
+}
+
+}
@@ -0,0 +1,110 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/omemstream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nbt
+{
+namespace io
+{
+
+omem_streambuf::omem_streambuf(size_t capacity):
+    storage(capacity, '\0'), fixed(false)
+{
+    setp(&storage[0], &storage[0] + storage.size());
+}
+
+omem_streambuf::omem_streambuf(char* data, size_t size):
+    fixed(true)
+{
+    setp(data, data + size);
+}
+
+std::string omem_streambuf::take()
+{
+    if(fixed)
+    {
+        std::string result = str();
+        clear();
+        return result;
+    }
+    storage.resize(size());
+    std::string result = std::move(storage);
+    storage.clear();
+    setp(nullptr, nullptr);
+    return result;
+}
+
+bool omem_streambuf::grow(size_t n)
+{
+    if(fixed)
+        return false;
+    size_t used = size();
+    size_t cap = std::max({used + n, 2 * storage.size(), size_t(256)});
+    storage.resize(cap);
+    setp(&storage[0], &storage[0] + cap);
+    advance(used);
+    return true;
+}
+
+void omem_streambuf::advance_large(size_t n)
+{
+    //pbump only takes an int
+    for(; n > INT_MAX; n -= INT_MAX)
+        pbump(INT_MAX);
+    pbump(static_cast<int>(n));
+}
+
+omem_streambuf::int_type omem_streambuf::overflow(int_type ch)
+{
+    if(traits_type::eq_int_type(ch, traits_type::eof()))
+        return traits_type::not_eof(ch);
+    char* p = reserve(1);
+    if(!p)
+        return traits_type::eof();
+    *p = traits_type::to_char_type(ch);
+    advance(1);
+    return ch;
+}
+
+std::streamsize omem_streambuf::xsputn(const char* s, std::streamsize n)
+{
+    size_t len = static_cast<size_t>(n);
+    if(!reserve(len))
+        len = epptr() - pptr(); //Write as much as fits into a fixed buffer
+    if(len != 0)
+    {
+        std::memcpy(pptr(), s, len);
+        advance(len);
+    }
+    return static_cast<std::streamsize>(len);
+}
+
+omem_streambuf::pos_type omem_streambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    //Only telling the position is supported
+    if(!(which & std::ios_base::out) || off != 0 || dir != std::ios_base::cur)
+        return pos_type(off_type(-1));
+    return pos_type(off_type(size()));
+}
+
+}
+}
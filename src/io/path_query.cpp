@@ -0,0 +1,275 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/path_query.h"
+#include "io/stream_reader.h"
+#include "nbt_tags.h"
+#include <algorithm>
+#include <istream>
+#include <stdexcept>
+
+namespace nbt
+{
+namespace io
+{
+
+path_query::path_query(std::initializer_list<std::string> paths):
+    path_query(std::vector<std::string>(paths))
+{}
+
+path_query::path_query(const std::vector<std::string>& paths)
+{
+    this->paths.reserve(paths.size());
+    for(const std::string& path: paths)
+        this->paths.push_back(parse(path));
+}
+
+std::vector<path_query::segment> path_query::parse(const std::string& path)
+{
+    auto fail = [&path](const char* what) {
+        throw std::invalid_argument("Invalid path \"" + path + "\": " + what);
+    };
+
+    std::vector<segment> segs;
+    size_t i = 0;
+    while(i < path.size())
+    {
+        segment seg;
+        if(path[i] == '[')
+        {
+            size_t end = path.find(']', i);
+            if(end == std::string::npos)
+                fail("missing ]");
+            std::string idx = path.substr(i + 1, end - i - 1);
+            if(idx == "*")
+                seg.kind = segment::any_index;
+            else
+            {
+                if(idx.empty() || idx.size() > 10
+                    || !std::all_of(idx.begin(), idx.end(), [](char c) { return c >= '0' && c <= '9'; }))
+                    fail("list index must be a number or *");
+                int64_t n = std::stoll(idx);
+                if(n > INT32_MAX)
+                    fail("list index out of range");
+                seg.kind = segment::index;
+                seg.idx = static_cast<int32_t>(n);
+            }
+            i = end + 1;
+        }
+        else
+        {
+            //Keys have to be at the start or after a dot
+            if(i > 0)
+            {
+                if(path[i] != '.')
+                    fail("expected . or [");
+                if(++i == path.size())
+                    fail("missing key after .");
+            }
+            if(path[i] == '"')
+            {
+                for(++i; i < path.size() && path[i] != '"'; ++i)
+                {
+                    if(path[i] == '\\' && ++i == path.size())
+                        break;
+                    seg.name += path[i];
+                }
+                if(i == path.size())
+                    fail("missing closing quote");
+                ++i;
+                seg.kind = segment::key;
+            }
+            else
+            {
+                size_t end = path.find_first_of(".[", i);
+                if(end == std::string::npos)
+                    end = path.size();
+                seg.name = path.substr(i, end - i);
+                if(seg.name.empty())
+                    fail("empty key");
+                seg.kind = (seg.name == "*") ? segment::any_key : segment::key;
+                i = end;
+            }
+        }
+        segs.push_back(std::move(seg));
+    }
+    if(segs.empty())
+        fail("path is empty");
+    return segs;
+}
+
+path_query::result_type path_query::run(std::istream& is, endian::endian e) const
+{
+    stream_reader reader(is, e);
+    return run(reader);
+}
+
+path_query::result_type path_query::run(stream_reader& reader) const
+{
+    tag_type type = reader.read_type();
+    reader.read_string();
+
+    result_type result(paths.size());
+    std::vector<state> states;
+    states.reserve(paths.size());
+    for(size_t i = 0; i < paths.size(); ++i)
+        states.push_back({i, 0});
+    walk_payload(reader, type, states, result);
+    return result;
+}
+
+template<class Pred>
+void path_query::advance(const std::vector<state>& states, Pred matches,
+                         std::vector<size_t>& ended, std::vector<state>& next) const
+{
+    for(const state& st: states)
+    {
+        if(!matches(paths[st.path][st.pos]))
+            continue;
+        if(st.pos + 1 == paths[st.path].size())
+            ended.push_back(st.path);
+        else
+            next.push_back({st.path, st.pos + 1});
+    }
+}
+
+void path_query::walk_payload(stream_reader& reader, tag_type type,
+                              const std::vector<state>& states, result_type& result) const
+{
+    //Only descend if one of the paths can continue with this type
+    bool wants_compound = false, wants_list = false;
+    for(const state& st: states)
+    {
+        auto kind = paths[st.path][st.pos].kind;
+        if(kind == segment::key || kind == segment::any_key)
+            wants_compound = true;
+        else
+            wants_list = true;
+    }
+
+    std::vector<size_t> ended;
+    std::vector<state> next;
+    if(type == tag_type::Compound && wants_compound)
+    {
+        tag_type tt;
+        while((tt = reader.read_type(true)) != tag_type::End)
+        {
+            std::string key = reader.read_string();
+            ended.clear();
+            next.clear();
+            advance(states, [&key](const segment& seg) {
+                return seg.kind == segment::any_key
+                    || (seg.kind == segment::key && seg.name == key);
+            }, ended, next);
+            walk_child(reader, tt, ended, next, result);
+        }
+    }
+    else if(type == tag_type::List && wants_list)
+    {
+        tag_type lt = reader.read_type(true);
+        int32_t length;
+        reader.read_num(length);
+        if(length < 0)
+            reader.get_istr().setstate(std::ios::failbit);
+        if(!reader.get_istr())
+            throw input_error("Error reading length of tag_list");
+        if(lt == tag_type::End)
+            return;
+
+        for(int32_t i = 0; i < length; ++i)
+        {
+            ended.clear();
+            next.clear();
+            advance(states, [i](const segment& seg) {
+                return seg.kind == segment::any_index
+                    || (seg.kind == segment::index && seg.idx == i);
+            }, ended, next);
+            walk_child(reader, lt, ended, next, result);
+        }
+    }
+    else
+        reader.skip_payload(type);
+}
+
+void path_query::walk_child(stream_reader& reader, tag_type type, const std::vector<size_t>& ended,
+                            const std::vector<state>& next, result_type& result) const
+{
+    if(ended.empty())
+    {
+        if(next.empty())
+            reader.skip_payload(type);
+        else
+            walk_payload(reader, type, next, result);
+    }
+    else
+    {
+        //The tag is needed anyway, so continue the other paths in memory
+        auto t = reader.read_payload(type);
+        if(!next.empty())
+            walk_tag(*t, next, result);
+        for(size_t k = 0; k + 1 < ended.size(); ++k)
+            result[ended[k]].emplace_back(t->clone());
+        result[ended.back()].emplace_back(std::move(t));
+    }
+}
+
+void path_query::walk_tag(const tag& t, const std::vector<state>& states, result_type& result) const
+{
+    std::vector<size_t> ended;
+    std::vector<state> next;
+    if(t.get_type() == tag_type::Compound)
+    {
+        for(const auto& entry: static_cast<const tag_compound&>(t))
+        {
+            ended.clear();
+            next.clear();
+            advance(states, [&entry](const segment& seg) {
+                return seg.kind == segment::any_key
+                    || (seg.kind == segment::key && seg.name == entry.first);
+            }, ended, next);
+            collect(entry.second.get(), ended, next, result);
+        }
+    }
+    else if(t.get_type() == tag_type::List)
+    {
+        const auto& list = static_cast<const tag_list&>(t);
+        for(size_t i = 0; i < list.size(); ++i)
+        {
+            ended.clear();
+            next.clear();
+            advance(states, [i](const segment& seg) {
+                return seg.kind == segment::any_index
+                    || (seg.kind == segment::index && static_cast<size_t>(seg.idx) == i);
+            }, ended, next);
+            collect(list[i].get(), ended, next, result);
+        }
+    }
+}
+
+void path_query::collect(const tag& t, const std::vector<size_t>& ended,
+                         const std::vector<state>& next, result_type& result) const
+{
+    if(!next.empty())
+        walk_tag(t, next, result);
+    for(size_t path: ended)
+        result[path].emplace_back(t.clone());
+}
+
+}
+}
@@ -0,0 +1,314 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/region_decoder.h"
+#include "io/imemstream.h"
+#include "io/stream_reader.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+namespace nbt
+{
+namespace io
+{
+
+namespace //anonymous
+{
+    struct task
+    {
+        size_t file;
+        ///Index of the chunk in the region, or -1 to open the region file
+        int index;
+        std::shared_ptr<const region_reader> region;
+    };
+
+    struct task_queue
+    {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    ///State shared by all workers during a run
+    class scheduler
+    {
+    public:
+        scheduler(const std::vector<std::string>& paths, unsigned threads, const region_decoder::callback& cb):
+            paths(paths), cb(cb), queues(threads)
+        {
+            for(size_t i = 0; i < paths.size(); ++i)
+                queues[i % threads].tasks.push_back({i, -1, nullptr});
+            pending = paths.size();
+            queued = paths.size();
+        }
+
+        void work(unsigned self);
+
+        ///Makes all workers return as soon as they have finished their current task
+        void stop() { stopped = true; wake_all(); }
+
+        ///Rethrows the first exception thrown by the callback
+        void finish()
+        {
+            if(cb_error)
+                std::rethrow_exception(cb_error);
+        }
+
+    private:
+        const std::vector<std::string>& paths;
+        const region_decoder::callback& cb;
+        std::vector<task_queue> queues;
+        ///Number of tasks that have been queued but not finished yet
+        std::atomic<size_t> pending{0};
+        ///Number of tasks that are in the queues, i.e. not taken by a worker yet
+        std::atomic<size_t> queued{0};
+        std::atomic<bool> stopped{false};
+        ///Idle workers wait here until there are tasks to take or the run is over
+        std::mutex idle_mutex;
+        std::condition_variable idle;
+        std::mutex error_mutex;
+        std::exception_ptr cb_error;
+
+        bool pop(unsigned self, task& t);
+        bool steal(unsigned self, task& t);
+        void execute(unsigned self, task& t, std::string& buf);
+        void deliver(region_decoder::chunk& c);
+        void wake_all();
+    };
+
+    bool scheduler::pop(unsigned self, task& t)
+    {
+        task_queue& q = queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if(q.tasks.empty())
+            return false;
+        t = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        --queued;
+        return true;
+    }
+
+    bool scheduler::steal(unsigned self, task& t)
+    {
+        for(size_t i = 1; i < queues.size(); ++i)
+        {
+            task_queue& q = queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if(!q.tasks.empty())
+            {
+                t = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                --queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void scheduler::work(unsigned self)
+    {
+        std::string buf;
+        task t;
+        while(!stopped)
+        {
+            if(pop(self, t) || steal(self, t))
+            {
+                execute(self, t, buf);
+                t.region.reset();
+                if(--pending == 0)
+                    wake_all();
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(idle_mutex);
+                idle.wait(lock, [this] { return stopped || pending == 0 || queued > 0; });
+                if(pending == 0)
+                    break;
+            }
+        }
+    }
+
+    void scheduler::wake_all()
+    {
+        //Taking the lock orders the change before the waiters' check of it
+        { std::lock_guard<std::mutex> lock(idle_mutex); }
+        idle.notify_all();
+    }
+
+    void scheduler::execute(unsigned self, task& t, std::string& buf)
+    {
+        region_decoder::chunk c;
+        c.file = paths[t.file];
+        if(t.index < 0)
+        {
+            try
+            {
+                auto region = std::make_shared<const region_reader>(c.file);
+                {
+                    task_queue& q = queues[self];
+                    std::lock_guard<std::mutex> lock(q.mutex);
+                    //Queue the chunks in reverse so that they get popped in order
+                    for(int i = region_reader::chunk_count - 1; i >= 0; --i)
+                    {
+                        if(region->has_chunk(i % region_reader::region_size, i / region_reader::region_size))
+                        {
+                            q.tasks.push_back({t.file, i, region});
+                            ++pending;
+                            ++queued;
+                        }
+                    }
+                }
+                wake_all();
+                return;
+            }
+            catch(...)
+            {
+                c.error = std::current_exception();
+            }
+        }
+        else
+        {
+            c.x = t.index % region_reader::region_size;
+            c.z = t.index / region_reader::region_size;
+            try
+            {
+                auto data = t.region->get_chunk(c.x, c.z);
+                c.timestamp = data.timestamp;
+                region_reader::decompress(data, buf);
+                imemstream is(buf);
+                c.data = stream_reader(is).read_compound().second;
+            }
+            catch(...)
+            {
+                c.error = std::current_exception();
+            }
+        }
+        deliver(c);
+    }
+
+    void scheduler::deliver(region_decoder::chunk& c)
+    {
+        try
+        {
+            cb(c);
+        }
+        catch(...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if(!cb_error)
+                    cb_error = std::current_exception();
+            }
+            stop();
+        }
+    }
+}
+
+region_decoder::region_decoder(unsigned threads):
+    num_threads(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{}
+
+void region_decoder::add_file(const std::string& path)
+{
+    paths.push_back(path);
+}
+
+void region_decoder::add_directory(const std::string& path)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::vector<std::string> found;
+    for(fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if(it->path().extension() == ".mca" && it->is_regular_file(ec))
+            found.push_back(it->path().string());
+    }
+    if(ec)
+        throw input_error("Cannot read directory " + path + ": " + ec.message());
+
+    //Directory order is unspecified, sort for reproducible results
+    std::sort(found.begin(), found.end());
+    paths.insert(paths.end(), found.begin(), found.end());
+}
+
+void region_decoder::run(const callback& cb) const
+{
+    unsigned threads = num_threads;
+    scheduler sched(paths, threads, cb);
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    try
+    {
+        for(unsigned i = 1; i < threads; ++i)
+            workers.emplace_back(&scheduler::work, &sched, i);
+    }
+    catch(...)
+    {
+        sched.stop();
+        for(auto& w: workers)
+            w.join();
+        throw;
+    }
+    //The calling thread takes part as the first worker
+    sched.work(0);
+    for(auto& w: workers)
+        w.join();
+    sched.finish();
+}
+
+std::vector<region_decoder::chunk> region_decoder::decode_all() const
+{
+    struct entry
+    {
+        size_t file;
+        int index;
+        chunk c;
+    };
+    std::vector<entry> entries;
+    std::mutex mutex;
+    std::unordered_map<std::string, size_t> file_pos;
+    for(size_t i = paths.size(); i-- > 0; )
+        file_pos[paths[i]] = i;
+
+    run([&](chunk& c) {
+        size_t file = file_pos.at(c.file);
+        int index = c.x < 0 ? -1 : c.x + c.z * region_reader::region_size;
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.push_back({file, index, std::move(c)});
+    });
+
+    std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) {
+        return a.file != b.file ? a.file < b.file : a.index < b.index;
+    });
+    std::vector<chunk> result;
+    result.reserve(entries.size());
+    for(auto& e: entries)
+        result.push_back(std::move(e.c));
+    return result;
+}
+
+}
+}
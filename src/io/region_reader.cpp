@@ -0,0 +1,254 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/region_reader.h"
+#include "io/imemstream.h"
+#include "io/stream_reader.h"
+#include "endian_str.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nbt
+{
+namespace io
+{
+
+///A read-only memory mapping of a whole file
+struct region_reader::mapping
+{
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE map = nullptr;
+#endif
+
+    explicit mapping(const std::string& path);
+    ~mapping();
+};
+
+#ifdef _WIN32
+
+region_reader::mapping::mapping(const std::string& path)
+{
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        throw input_error("Cannot open region file " + path);
+
+    LARGE_INTEGER fsize;
+    if(!GetFileSizeEx(file, &fsize))
+    {
+        CloseHandle(file);
+        throw input_error("Cannot determine size of region file " + path);
+    }
+    size = static_cast<size_t>(fsize.QuadPart);
+    if(size == 0)
+        return;
+
+    map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(map)
+        data = static_cast<const char*>(MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0));
+    if(!data)
+    {
+        if(map)
+            CloseHandle(map);
+        CloseHandle(file);
+        throw input_error("Cannot map region file " + path);
+    }
+}
+
+region_reader::mapping::~mapping()
+{
+    if(data)
+        UnmapViewOfFile(data);
+    if(map)
+        CloseHandle(map);
+    if(file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+}
+
+#else
+
+region_reader::mapping::mapping(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw input_error("Cannot open region file " + path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        throw input_error("Cannot determine size of region file " + path + ": " + std::strerror(err));
+    }
+    size = static_cast<size_t>(st.st_size);
+    if(size > 0)
+    {
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED)
+        {
+            int err = errno;
+            ::close(fd);
+            throw input_error("Cannot map region file " + path + ": " + std::strerror(err));
+        }
+        data = static_cast<const char*>(addr);
+    }
+    //The mapping stays valid after closing the file
+    ::close(fd);
+}
+
+region_reader::mapping::~mapping()
+{
+    if(data)
+        ::munmap(const_cast<char*>(data), size);
+}
+
+#endif
+
+region_reader::region_reader(const std::string& path):
+    map(new mapping(path)), data(map->data), size(map->size)
+{
+    check_header();
+}
+
+region_reader::region_reader(const char* data, size_t size):
+    data(data), size(size)
+{
+    check_header();
+}
+
+region_reader::region_reader(region_reader&&) noexcept = default;
+region_reader& region_reader::operator=(region_reader&&) noexcept = default;
+region_reader::~region_reader() noexcept = default;
+
+void region_reader::check_header() const
+{
+    //Empty files are valid, they just don't contain any chunks
+    if(size != 0 && size < 2 * sector_size)
+        throw input_error("Region file header is truncated");
+}
+
+bool region_reader::has_chunk(int x, int z) const
+{
+    if(size == 0)
+        return false;
+    int index = (x & (region_size - 1)) + (z & (region_size - 1)) * region_size;
+    uint32_t loc;
+    endian::read_big(data + 4 * index, loc);
+    return loc != 0;
+}
+
+region_reader::chunk_data region_reader::get_chunk(int x, int z) const
+{
+    chunk_data chunk;
+    if(!has_chunk(x, z))
+        return chunk;
+
+    int index = (x & (region_size - 1)) + (z & (region_size - 1)) * region_size;
+    uint32_t loc;
+    endian::read_big(data + 4 * index, loc);
+    endian::read_big(data + sector_size + 4 * index, chunk.timestamp);
+
+    //The location consists of a three byte sector offset and a one byte sector count
+    size_t offset = (loc >> 8) * sector_size;
+    size_t max_len = (loc & 0xff) * sector_size;
+    if(offset < 2 * sector_size || offset + 5 > size || max_len == 0)
+        throw input_error("Invalid location of chunk " + std::to_string(index) + " in region file");
+
+    //Be lenient with files that are not padded to whole sectors
+    max_len = std::min(max_len, size - offset);
+    uint32_t length;
+    endian::read_big(data + offset, length);
+    if(length == 0 || length > max_len - 4)
+        throw input_error("Invalid length of chunk " + std::to_string(index) + " in region file");
+
+    uint8_t scheme = static_cast<uint8_t>(data[offset + 4]);
+    chunk.scheme = static_cast<compression>(scheme & 0x7f);
+    if(scheme & 0x80)
+        chunk.external = true;
+    else
+    {
+        chunk.data = data + offset + 5;
+        chunk.size = length - 1;
+    }
+    return chunk;
+}
+
+void region_reader::decompress(const chunk_data& chunk, std::string& out)
+{
+    if(chunk.external)
+        throw input_error("Chunk is stored in an external file");
+
+    const char* data = chunk.data;
+    size_t size = chunk.size;
+    const codec* c;
+    if(chunk.scheme == compression::custom)
+    {
+        //The data start with the name of the codec
+        uint16_t len = 0;
+        if(size >= 2)
+            endian::read_big(data, len);
+        if(size < 2u + len)
+            throw input_error("Truncated name of custom chunk compression");
+        std::string name(data + 2, len);
+        data += 2 + len;
+        size -= 2 + len;
+        c = find_codec(name);
+        if(!c)
+            throw input_error("Unsupported custom chunk compression " + name);
+    }
+    else
+    {
+        c = get_codec(chunk.scheme);
+        if(!c)
+            throw input_error("Unsupported chunk compression scheme "
+                              + std::to_string(static_cast<int>(chunk.scheme)));
+    }
+    c->decompress(data, size, out);
+}
+
+std::unique_ptr<tag_compound> region_reader::read_chunk(int x, int z) const
+{
+    chunk_data chunk = get_chunk(x, z);
+    if(!chunk)
+        return nullptr;
+
+    std::string buf;
+    decompress(chunk, buf);
+    imemstream is(buf);
+    return stream_reader(is).read_compound().second;
+}
+
+}
+}
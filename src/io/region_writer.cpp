@@ -0,0 +1,301 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/region_writer.h"
+#include "io/omemstream.h"
+#include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include "endian_str.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <stdexcept>
+
+namespace nbt
+{
+namespace io
+{
+
+namespace //anonymous
+{
+    constexpr size_t sector_size = region_reader::sector_size;
+
+    void store_big(char* p, uint32_t x)
+    {
+        p[0] = static_cast<char>(x >> 24);
+        p[1] = static_cast<char>(x >> 16);
+        p[2] = static_cast<char>(x >> 8);
+        p[3] = static_cast<char>(x);
+    }
+
+    /**
+     * Returns the path of the file c.x.z.mcc next to the region file in which
+     * a chunk that is too large for the region is stored. x and z are the
+     * absolute chunk coordinates if the region file is named r.x.z.mca.
+     */
+    std::string external_path(const std::string& region_path, int x, int z)
+    {
+        namespace fs = std::filesystem;
+        const int region_size = region_reader::region_size;
+        fs::path path(region_path);
+        std::string name = path.filename().string();
+        int rx, rz, len = 0;
+        if(std::sscanf(name.c_str(), "r.%d.%d.mca%n", &rx, &rz, &len) == 2 && size_t(len) == name.size())
+        {
+            x = rx * region_size + (x & (region_size - 1));
+            z = rz * region_size + (z & (region_size - 1));
+        }
+        path.replace_filename("c." + std::to_string(x) + "." + std::to_string(z) + ".mcc");
+        return path.string();
+    }
+}
+
+region_writer::region_writer(const std::string& path):
+    path(path), locations(region_reader::chunk_count)
+{
+    //Create the file if it doesn't exist, without truncating it otherwise
+    std::ofstream(path, std::ios::app | std::ios::binary);
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+    file.seekg(0, std::ios::end);
+    size_t size = static_cast<size_t>(file.tellg());
+    if(size == 0)
+    {
+        const std::string header(2 * sector_size, '\0');
+        file.seekp(0);
+        file.write(header.data(), header.size());
+        size = header.size();
+    }
+    else if(size < 2 * sector_size)
+        throw input_error("Region file header is truncated");
+    else if(size % sector_size != 0)
+    {
+        //Pad the file to whole sectors so that every sector can be read in full
+        const std::string padding(sector_size - size % sector_size, '\0');
+        file.seekp(0, std::ios::end);
+        file.write(padding.data(), padding.size());
+        size += padding.size();
+    }
+    used.assign(size / sector_size, false);
+    used[0] = used[1] = true;
+
+    char header[sector_size];
+    file.seekg(0);
+    file.read(header, sector_size);
+    for(int i = 0; i < region_reader::chunk_count; ++i)
+    {
+        uint32_t loc;
+        endian::read_big(header + 4 * i, loc);
+        if(loc == 0)
+            continue;
+        size_t offset = loc >> 8;
+        size_t count = loc & 0xff;
+        if(offset < 2 || count == 0 || offset + count > used.size()
+           || std::find(used.begin() + offset, used.begin() + offset + count, true) != used.begin() + offset + count)
+            throw input_error("Invalid location of chunk " + std::to_string(i) + " in region file");
+        locations[i] = loc;
+        mark(loc, true);
+    }
+}
+
+int region_writer::chunk_index(int x, int z)
+{
+    return (x & (region_reader::region_size - 1)) + (z & (region_reader::region_size - 1)) * region_reader::region_size;
+}
+
+bool region_writer::has_chunk(int x, int z) const
+{
+    return locations[chunk_index(x, z)] != 0;
+}
+
+size_t region_writer::free_sectors() const
+{
+    return std::count(used.begin(), used.end(), false);
+}
+
+void region_writer::mark(uint32_t loc, bool value)
+{
+    size_t offset = loc >> 8;
+    std::fill(used.begin() + offset, used.begin() + offset + (loc & 0xff), value);
+}
+
+size_t region_writer::allocate(size_t count)
+{
+    //First fit; a free run at the end of the file may extend past it
+    size_t start = 2;
+    for(size_t i = 2; i < used.size() && i - start < count; ++i)
+    {
+        if(used[i])
+            start = i + 1;
+    }
+    if(start + count > used.size())
+        used.resize(start + count, false);
+    return start;
+}
+
+void region_writer::write_header_entry(int index, int32_t timestamp)
+{
+    file.seekp(4 * index);
+    endian::write_big(file, locations[index]);
+    file.seekp(sector_size + 4 * index);
+    endian::write_big(file, timestamp);
+}
+
+void region_writer::write_chunk(int x, int z, const tag_compound& data, compression scheme,
+                                int level, int32_t timestamp)
+{
+    const codec* c = get_codec(scheme);
+    if(!c)
+        throw std::invalid_argument("Unsupported chunk compression scheme "
+                                    + std::to_string(static_cast<int>(scheme)));
+    write_chunk(x, z, data, *c, level, timestamp);
+}
+
+void region_writer::write_chunk(int x, int z, const tag_compound& data, const codec& c,
+                                int level, int32_t timestamp)
+{
+    //Serialize into a buffer of the exact size, then compress it in one go
+    omemstream buf(3 + serialized_size(data));
+    stream_writer(buf).write_tag("", data);
+    compression scheme = c.scheme();
+    if(scheme == compression::none)
+    {
+        write_chunk_data(x, z, buf.data(), buf.size(), scheme, timestamp);
+        return;
+    }
+    std::string compressed;
+    c.compress(buf.data(), buf.size(), compressed, level);
+    if(scheme == compression::custom)
+    {
+        std::string name = c.name();
+        char len[2];
+        endian::write_big(len, static_cast<uint16_t>(name.size()));
+        compressed.insert(0, name).insert(0, len, 2);
+    }
+    write_chunk_data(x, z, compressed.data(), compressed.size(), scheme, timestamp);
+}
+
+void region_writer::write_chunk_data(int x, int z, const char* data, size_t size, compression scheme,
+                                     int32_t timestamp)
+{
+    size_t count = (size + 5 + sector_size - 1) / sector_size;
+    if(count > max_chunk_sectors)
+        throw std::length_error("Chunk is too large for the region file");
+    if(timestamp == -1)
+        timestamp = static_cast<int32_t>(std::time(nullptr));
+
+    int index = chunk_index(x, z);
+    uint32_t old = locations[index];
+    //Unless the new data refer to it as well, the old external file is orphaned by the new data
+    bool orphaned = old != 0 && is_external(old) && !(static_cast<uint8_t>(scheme) & 0x80);
+    size_t offset;
+    if(old != 0 && (old & 0xff) >= count)
+    {
+        //The chunk still fits, overwrite it and free the sectors it doesn't need anymore
+        offset = old >> 8;
+        std::fill(used.begin() + offset + count, used.begin() + offset + (old & 0xff), false);
+    }
+    else
+    {
+        //Allocate before freeing so that the old data stays intact until the header is updated
+        offset = allocate(count);
+        mark(old, false);
+    }
+    locations[index] = static_cast<uint32_t>(offset << 8 | count);
+    mark(locations[index], true);
+
+    //Write the whole sectors in one go, padded with zeros
+    std::string sectors(count * sector_size, '\0');
+    store_big(&sectors[0], static_cast<uint32_t>(size + 1));
+    sectors[4] = static_cast<char>(scheme);
+    std::copy(data, data + size, &sectors[5]);
+    file.seekp(offset * sector_size);
+    file.write(sectors.data(), sectors.size());
+
+    write_header_entry(index, timestamp);
+    if(orphaned)
+        std::filesystem::remove(external_path(path, x, z));
+}
+
+void region_writer::remove_chunk(int x, int z)
+{
+    int index = chunk_index(x, z);
+    if(locations[index] == 0)
+        return;
+    bool external = is_external(locations[index]);
+    mark(locations[index], false);
+    locations[index] = 0;
+    write_header_entry(index, 0);
+    if(external)
+        std::filesystem::remove(external_path(path, x, z));
+}
+
+bool region_writer::is_external(uint32_t loc)
+{
+    //The compression scheme follows the length in the chunk's first sector
+    char scheme;
+    file.seekg((loc >> 8) * sector_size + 4);
+    file.read(&scheme, 1);
+    return static_cast<uint8_t>(scheme) & 0x80;
+}
+
+void region_writer::compact()
+{
+    std::vector<int> order;
+    for(int i = 0; i < region_reader::chunk_count; ++i)
+        if(locations[i] != 0)
+            order.push_back(i);
+    std::sort(order.begin(), order.end(), [this](int a, int b) { return locations[a] < locations[b]; });
+
+    //Moving the chunks in file order never overwrites a chunk that is yet to be moved
+    size_t next = 2;
+    std::string buf;
+    for(int index: order)
+    {
+        size_t offset = locations[index] >> 8;
+        size_t count = locations[index] & 0xff;
+        if(offset != next)
+        {
+            buf.resize(count * sector_size);
+            file.seekg(offset * sector_size);
+            file.read(&buf[0], buf.size());
+            file.seekp(next * sector_size);
+            file.write(buf.data(), buf.size());
+            locations[index] = static_cast<uint32_t>(next << 8 | count);
+            file.seekp(4 * index);
+            endian::write_big(file, locations[index]);
+        }
+        next += count;
+    }
+    used.assign(next, true);
+
+    file.close();
+    std::filesystem::resize_file(path, next * sector_size);
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+}
+
+void region_writer::flush()
+{
+    file.flush();
+}
+
+}
+}
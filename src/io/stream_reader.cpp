@@ -19,14 +19,273 @@
  */
 #include "io/stream_reader.h"
 #include "make_unique.h"
+#include "primitive_detail.h"
 #include "tag_compound.h"
+#include <algorithm>
 #include <istream>
+#include <optional>
+#include <sstream>
+#include <type_traits>
 
 namespace nbt
 {
 namespace io
 {
 
+namespace //anonymous
+{
+    typedef stream_visitor::action action;
+
+    ///Maximum number of array or list elements that are read at once when parsing
+    const size_t chunk_len = 1024;
+
+    action parse_value(stream_reader& reader, tag_type type, stream_visitor& v);
+
+    ///Returns what the enclosing tag has to do after the visitor returned a for an event
+    action after_event(action a)
+    {
+        return a == action::skip ? action::proceed : a;
+    }
+
+    void check_read(stream_reader& reader, tag_type type)
+    {
+        if(!reader.get_istr())
+        {
+            std::ostringstream str;
+            str << "Error reading tag_" << type;
+            throw input_error(str.str());
+        }
+    }
+
+    template<class T>
+    void read_elements(stream_reader& reader, T* dst, size_t n)
+    {
+        if constexpr(std::is_same<T, int8_t>::value)
+            reader.read_raw(reinterpret_cast<char*>(dst), n);
+        else
+            reader.read_array(dst, n);
+    }
+
+    void skip_elements(stream_reader& reader, tag_type type, size_t n)
+    {
+        switch(type)
+        {
+        case tag_type::Null:   break;
+        case tag_type::Byte:   reader.skip_array<int8_t>(n); break;
+        case tag_type::Short:  reader.skip_array<int16_t>(n); break;
+        case tag_type::Int:    reader.skip_array<int32_t>(n); break;
+        case tag_type::Long:   reader.skip_array<int64_t>(n); break;
+        case tag_type::Float:  reader.skip_array<float>(n); break;
+        case tag_type::Double: reader.skip_array<double>(n); break;
+        default:
+            for(size_t i = 0; i < n; ++i)
+                reader.skip_payload(type);
+        }
+        check_read(reader, tag_type::List);
+    }
+
+    template<class T>
+    action parse_num(stream_reader& reader, stream_visitor& v)
+    {
+        T x;
+        reader.read_num(x);
+        check_read(reader, detail::get_primitive_type<T>::value);
+        return after_event(v.primitive(x));
+    }
+
+    int32_t read_length(stream_reader& reader, tag_type type)
+    {
+        int32_t length;
+        reader.read_num(length);
+        if(length < 0)
+            reader.get_istr().setstate(std::ios::failbit);
+        check_read(reader, type);
+        return length;
+    }
+
+    template<class T>
+    action parse_array(stream_reader& reader, tag_type type, stream_visitor& v)
+    {
+        int32_t length = read_length(reader, type);
+        action a = v.begin_array(type, length);
+        if(a != action::proceed)
+        {
+            if(a != action::stop)
+            {
+                reader.skip_array<T>(length);
+                check_read(reader, type);
+            }
+            return a == action::skip ? action::proceed : a;
+        }
+
+        T buf[chunk_len];
+        for(size_t left = length; left > 0; )
+        {
+            size_t n = std::min(left, chunk_len);
+            read_elements(reader, buf, n);
+            check_read(reader, type);
+            left -= n;
+
+            a = v.array_data(buf, n);
+            if(a == action::stop)
+                return a;
+            if(a == action::leave)
+            {
+                reader.skip_array<T>(left);
+                check_read(reader, type);
+                break;
+            }
+        }
+        return after_event(v.end_array());
+    }
+
+    ///Parses the elements of a list of primitives in chunks
+    template<class T>
+    action parse_elements(stream_reader& reader, tag_type type, size_t length, stream_visitor& v)
+    {
+        //The elements are one level below the list, without going through parse_value
+        std::optional<stats::detail::depth_guard> depth;
+        if(length > 0)
+            depth.emplace();
+        T buf[chunk_len];
+        for(size_t left = length; left > 0; )
+        {
+            size_t n = std::min(left, chunk_len);
+            read_elements(reader, buf, n);
+            check_read(reader, tag_type::List);
+            stats::detail::tag_read(type, n);
+            left -= n;
+
+            for(size_t i = 0; i < n; ++i)
+            {
+                action a = v.primitive(buf[i]);
+                if(a == action::stop)
+                    return a;
+                if(a == action::leave)
+                {
+                    skip_elements(reader, type, left);
+                    return action::proceed;
+                }
+            }
+        }
+        return action::proceed;
+    }
+
+    action parse_list(stream_reader& reader, stream_visitor& v)
+    {
+        tag_type lt = reader.read_type(true);
+        int32_t length = read_length(reader, tag_type::List);
+        if(lt == tag_type::End)
+        {
+            lt = tag_type::Null;
+            length = 0;
+        }
+
+        action a = v.begin_list(lt, length);
+        if(a != action::proceed)
+        {
+            if(a != action::stop)
+                skip_elements(reader, lt, length);
+            return a == action::skip ? action::proceed : a;
+        }
+
+        switch(lt)
+        {
+        case tag_type::Byte:   a = parse_elements<int8_t>(reader, lt, length, v); break;
+        case tag_type::Short:  a = parse_elements<int16_t>(reader, lt, length, v); break;
+        case tag_type::Int:    a = parse_elements<int32_t>(reader, lt, length, v); break;
+        case tag_type::Long:   a = parse_elements<int64_t>(reader, lt, length, v); break;
+        case tag_type::Float:  a = parse_elements<float>(reader, lt, length, v); break;
+        case tag_type::Double: a = parse_elements<double>(reader, lt, length, v); break;
+        default:
+            a = action::proceed;
+            for(int32_t i = 0; i < length; ++i)
+            {
+                action ea = parse_value(reader, lt, v);
+                if(ea == action::stop)
+                {
+                    a = ea;
+                    break;
+                }
+                if(ea == action::leave)
+                {
+                    skip_elements(reader, lt, length - i - 1);
+                    break;
+                }
+            }
+        }
+        if(a == action::stop)
+            return a;
+        return after_event(v.end_list());
+    }
+
+    action parse_compound(stream_reader& reader, stream_visitor& v)
+    {
+        action a = v.begin_compound();
+        if(a != action::proceed)
+        {
+            if(a != action::stop)
+                reader.skip_payload(tag_type::Compound);
+            return a == action::skip ? action::proceed : a;
+        }
+
+        tag_type tt;
+        while((tt = reader.read_type(true)) != tag_type::End)
+        {
+            std::string key;
+            try
+            {
+                key = reader.read_string();
+            }
+            catch(input_error& ex)
+            {
+                std::ostringstream str;
+                str << "Error reading key of tag_" << tt;
+                throw input_error(str.str());
+            }
+
+            a = v.key(key, tt);
+            if(a == action::proceed)
+                a = parse_value(reader, tt, v);
+            else if(a != action::stop)
+                reader.skip_payload(tt);
+
+            if(a == action::stop)
+                return a;
+            if(a == action::leave)
+            {
+                reader.skip_payload(tag_type::Compound);
+                break;
+            }
+        }
+        return after_event(v.end_compound());
+    }
+
+    action parse_value(stream_reader& reader, tag_type type, stream_visitor& v)
+    {
+        stats::detail::tag_read(type);
+        stats::detail::depth_guard depth;
+        switch(type)
+        {
+        case tag_type::Byte:       return parse_num<int8_t>(reader, v);
+        case tag_type::Short:      return parse_num<int16_t>(reader, v);
+        case tag_type::Int:        return parse_num<int32_t>(reader, v);
+        case tag_type::Long:       return parse_num<int64_t>(reader, v);
+        case tag_type::Float:      return parse_num<float>(reader, v);
+        case tag_type::Double:     return parse_num<double>(reader, v);
+        case tag_type::String:     return after_event(v.string(reader.read_string()));
+        case tag_type::Byte_Array: return parse_array<int8_t>(reader, type, v);
+        case tag_type::Int_Array:  return parse_array<int32_t>(reader, type, v);
+        case tag_type::Long_Array: return parse_array<int64_t>(reader, type, v);
+        case tag_type::List:       return parse_list(reader, v);
+        case tag_type::Compound:   return parse_compound(reader, v);
+        default:
+            reader.get_istr().setstate(std::ios::failbit);
+            throw input_error("Invalid tag type");
+        }
+    }
+}
+
 std::pair<std::string, std::unique_ptr<tag_compound>> read_compound(std::istream& is, endian::endian e)
 {
     return stream_reader(is, e).read_compound();
@@ -38,7 +297,7 @@ std::pair<std::string, std::unique_ptr<tag>> read_tag(std::istream& is, endian::
 }
 
 stream_reader::stream_reader(std::istream& is, endian::endian e) noexcept:
-    is(is), endian(e)
+    is(is), mem_buf(dynamic_cast<imem_streambuf*>(is.rdbuf())), endian(e)
 {}
 
 std::istream& stream_reader::get_istr() const
@@ -53,12 +312,15 @@ endian::endian stream_reader::get_endian() const
 
 std::pair<std::string, std::unique_ptr<tag_compound>> stream_reader::read_compound()
 {
+    stats::detail::parse_timer timer;
     if(read_type() != tag_type::Compound)
     {
         is.setstate(std::ios::failbit);
         throw input_error("Tag is not a compound");
     }
     std::string key = read_string();
+    stats::detail::tag_read(tag_type::Compound);
+    stats::detail::depth_guard depth;
     auto comp = make_unique<tag_compound>();
     comp->read_payload(*this);
     return {std::move(key), std::move(comp)};
@@ -66,22 +328,211 @@ std::pair<std::string, std::unique_ptr<tag_compound>> stream_reader::read_compou
 
 std::pair<std::string, std::unique_ptr<tag>> stream_reader::read_tag()
 {
+    stats::detail::parse_timer timer;
     tag_type type = read_type();
     std::string key = read_string();
-    std::unique_ptr<tag> t = read_payload(type);
+    stats::detail::tag_read(type);
+    stats::detail::depth_guard depth;
+    std::unique_ptr<tag> t = tag::create(type);
+    t->read_payload(*this);
     return {std::move(key), std::move(t)};
 }
 
 std::unique_ptr<tag> stream_reader::read_payload(tag_type type)
 {
+    struct nesting_guard
+    {
+        unsigned& n;
+        explicit nesting_guard(unsigned& n): n(n) { ++n; }
+        ~nesting_guard() { --n; }
+    } guard(nesting);
+    stats::detail::parse_timer timer;
+    stats::detail::tag_read(type);
+    stats::detail::depth_guard depth;
+
     std::unique_ptr<tag> t = tag::create(type);
     t->read_payload(*this);
     return t;
 }
 
+void stream_reader::skip_payload(tag_type type)
+{
+    switch(type)
+    {
+    case tag_type::Byte:   skip_array<int8_t>(1); break;
+    case tag_type::Short:  skip_array<int16_t>(1); break;
+    case tag_type::Int:    skip_array<int32_t>(1); break;
+    case tag_type::Long:   skip_array<int64_t>(1); break;
+    case tag_type::Float:  skip_array<float>(1); break;
+    case tag_type::Double: skip_array<double>(1); break;
+
+    case tag_type::String:
+        {
+            size_t len = read_string_length();
+            if(is)
+                skip_raw(len);
+            if(!is)
+                throw input_error("Error reading string");
+        }
+        break;
+
+    case tag_type::Byte_Array:
+    case tag_type::Int_Array:
+    case tag_type::Long_Array:
+        {
+            int32_t len;
+            read_num(len);
+            if(len < 0)
+                is.setstate(std::ios::failbit);
+            if(is)
+            {
+                if(type == tag_type::Byte_Array)
+                    skip_array<int8_t>(len);
+                else if(type == tag_type::Int_Array)
+                    skip_array<int32_t>(len);
+                else
+                    skip_array<int64_t>(len);
+            }
+            if(!is)
+                throw input_error("Error reading array tag");
+        }
+        break;
+
+    case tag_type::List:
+        {
+            tag_type lt = read_type(true);
+            int32_t len;
+            read_num(len);
+            if(len < 0)
+                is.setstate(std::ios::failbit);
+            if(!is)
+                throw input_error("Error reading length of tag_list");
+            if(lt == tag_type::End)
+                break;
+
+            switch(lt)
+            {
+            case tag_type::Byte:   skip_array<int8_t>(len); break;
+            case tag_type::Short:  skip_array<int16_t>(len); break;
+            case tag_type::Int:    skip_array<int32_t>(len); break;
+            case tag_type::Long:   skip_array<int64_t>(len); break;
+            case tag_type::Float:  skip_array<float>(len); break;
+            case tag_type::Double: skip_array<double>(len); break;
+            default:
+                for(int32_t i = 0; i < len; ++i)
+                    skip_payload(lt);
+            }
+            if(!is)
+                throw input_error("Error reading contents of tag_list");
+        }
+        break;
+
+    case tag_type::Compound:
+        {
+            tag_type tt;
+            while((tt = read_type(true)) != tag_type::End)
+            {
+                size_t len = read_string_length();
+                if(is)
+                    skip_raw(len);
+                if(!is)
+                {
+                    std::ostringstream str;
+                    str << "Error reading key of tag_" << tt;
+                    throw input_error(str.str());
+                }
+                skip_payload(tt);
+            }
+        }
+        break;
+
+    default:
+        is.setstate(std::ios::failbit);
+        throw input_error("Invalid tag type");
+    }
+    if(!is)
+        throw input_error("Error skipping tag payload");
+}
+
+bool stream_reader::parse(stream_visitor& visitor)
+{
+    stats::detail::parse_timer timer;
+    tag_type type = read_type();
+    std::string name = read_string();
+    action a = visitor.key(name, type);
+    if(a == action::stop)
+        return false;
+    if(a != action::proceed)
+    {
+        skip_payload(type);
+        return true;
+    }
+    return parse_value(*this, type, visitor) != action::stop;
+}
+
+bool stream_reader::parse_payload(tag_type type, stream_visitor& visitor)
+{
+    stats::detail::parse_timer timer;
+    return parse_value(*this, type, visitor) != action::stop;
+}
+
+std::shared_ptr<const detail::lazy_payload> stream_reader::record_payload(tag_type type)
+{
+    if(!lazy_ || nesting == 0 || !mem_buf || is.rdbuf() != mem_buf || !is.good())
+        return nullptr;
+
+    const char* start = mem_buf->cur();
+    skip_payload(type);
+    size_t size = mem_buf->cur() - start;
+
+    auto payload = std::make_shared<detail::lazy_payload>();
+    if(lazy_buf && start >= lazy_buf->data()
+        && start + size <= lazy_buf->data() + lazy_buf->size())
+    {
+        payload->buf = lazy_buf;
+        payload->offset = start - lazy_buf->data();
+    }
+    else
+    {
+        payload->buf = std::make_shared<const std::string>(start, size);
+        payload->offset = 0;
+    }
+    payload->size = size;
+    payload->endian = endian;
+    return payload;
+}
+
+void stream_reader::skip_raw(size_t n)
+{
+    stats::detail::bytes_read(n);
+    if(mem_available(n))
+        mem_buf->advance(n);
+    else
+    {
+        //ignore takes a signed count, so skip large amounts in steps
+        const size_t step = 1 << 30;
+        while(n > 0 && is)
+        {
+            size_t len = std::min(n, step);
+            is.ignore(len);
+            if(static_cast<size_t>(is.gcount()) != len)
+                is.setstate(std::ios::failbit);
+            n -= len;
+        }
+    }
+}
+
 tag_type stream_reader::read_type(bool allow_end)
 {
-    int type = is.get();
+    stats::detail::bytes_read(1);
+    int type;
+    if(mem_available(1))
+    {
+        type = static_cast<unsigned char>(*mem_buf->cur());
+        mem_buf->advance(1);
+    }
+    else
+        type = is.get();
     if(!is)
         throw input_error("Error reading tag type");
     if(!is_valid_type(type, allow_end))
@@ -94,17 +545,35 @@ tag_type stream_reader::read_type(bool allow_end)
 
 std::string stream_reader::read_string()
 {
-    uint16_t len;
-    read_num(len);
+    size_t len = read_string_length();
     if(!is)
         throw input_error("Error reading string");
 
     std::string ret(len, '\0');
-    is.read(&ret[0], len); //C++11 allows us to do this
+    read_raw(&ret[0], len); //C++11 allows us to do this
     if(!is)
         throw input_error("Error reading string");
     return ret;
 }
 
+size_t stream_reader::read_string_length()
+{
+    if(endian != endian::network)
+    {
+        uint16_t len;
+        read_num(len);
+        return len;
+    }
+    uint32_t len;
+    if(!read_varint(len))
+        return 0;
+    if(len > UINT16_MAX)
+    {
+        is.setstate(std::ios::failbit);
+        return 0;
+    }
+    return len;
+}
+
 }
 }
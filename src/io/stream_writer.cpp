@@ -18,6 +18,8 @@
  * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "io/stream_writer.h"
+#include "nbt_tags.h"
+#include "nbt_visitor.h"
 #include <sstream>
 
 namespace nbt
@@ -25,11 +27,129 @@ namespace nbt
 namespace io
 {
 
+namespace //anonymous
+{
+    ///Returns the size of a payload if it is the same for all tags of the type, otherwise 0
+    size_t fixed_size(tag_type type, endian::endian e)
+    {
+        switch(type)
+        {
+        case tag_type::Byte:   return 1;
+        case tag_type::Short:  return 2;
+        case tag_type::Int:    return e == endian::network ? 0 : 4;
+        case tag_type::Long:   return e == endian::network ? 0 : 8;
+        case tag_type::Float:  return 4;
+        case tag_type::Double: return 8;
+        default:               return 0;
+        }
+    }
+
+    ///Adds up the sizes of the payloads it visits
+    class size_visitor : public const_nbt_visitor
+    {
+    public:
+        size_t size = 0;
+
+        explicit size_visitor(endian::endian e): e(e) {}
+
+        void visit(const tag_byte&) override   { size += 1; }
+        void visit(const tag_short&) override  { size += 2; }
+        void visit(const tag_int& i) override  { size += num_size(i.get()); }
+        void visit(const tag_long& l) override { size += num_size(l.get()); }
+        void visit(const tag_float&) override  { size += 4; }
+        void visit(const tag_double&) override { size += 8; }
+        void visit(const tag_byte_array& arr) override { size += length_size(arr.size()) + arr.size(); }
+        void visit(const tag_int_array& arr) override  { size += length_size(arr.size()) + nums_size(arr.get()); }
+        void visit(const tag_long_array& arr) override { size += length_size(arr.size()) + nums_size(arr.get()); }
+        void visit(const tag_string& str) override { size += string_size(str.get()); }
+
+        void visit(const tag_list& list) override
+        {
+            //Lazy payloads are written as they were read
+            if(size_t lazy = list.lazy_size(e))
+            {
+                size += lazy;
+                return;
+            }
+            size += 1 + length_size(list.size()); //Content type and length
+            if(size_t fixed = fixed_size(list.el_type(), e))
+                size += fixed * list.size();
+            else //Without boxing or unboxing, which would invalidate references into the list
+                list.visit_elements([this](const auto& elements) { add_elements(elements); });
+        }
+
+        void visit(const tag_compound& comp) override
+        {
+            if(size_t lazy = comp.lazy_size(e))
+            {
+                size += lazy;
+                return;
+            }
+            for(const auto& entry: comp)
+            {
+                size += 1 + string_size(entry.first); //Type and name
+                entry.second.get().accept(*this);
+            }
+            size += 1; //End tag
+        }
+
+    private:
+        const endian::endian e;
+
+        template<class T>
+        size_t num_size(T x) const
+        { return e == endian::network ? varint::size(varint::zigzag_encode(x)) : sizeof(T); }
+
+        template<class T>
+        size_t nums_size(const std::vector<T>& vec) const
+        {
+            if constexpr(varint::is_encoded<T>)
+            {
+                if(e == endian::network)
+                {
+                    size_t n = 0;
+                    for(T x: vec)
+                        n += varint::size(varint::zigzag_encode(x));
+                    return n;
+                }
+            }
+            return sizeof(T) * vec.size();
+        }
+
+        void add_elements(const std::vector<value>& tags)
+        {
+            for(const value& val: tags)
+                val.get().accept(*this);
+        }
+
+        template<class T>
+        void add_elements(const std::vector<T>& vec)
+        { size += nums_size(vec); }
+
+        size_t length_size(size_t len) const
+        { return num_size(static_cast<int32_t>(len)); }
+
+        size_t string_size(const std::string& str) const
+        { return (e == endian::network ? varint::size(str.size()) : 2) + str.size(); }
+    };
+}
+
+size_t serialized_size(const tag& t, endian::endian e)
+{
+    size_visitor visitor(e);
+    t.accept(visitor);
+    return visitor.size;
+}
+
 void write_tag(const std::string& key, const tag& t, std::ostream& os, endian::endian e)
 {
     stream_writer(os, e).write_tag(key, t);
 }
 
+stream_writer::stream_writer(std::ostream& os, endian::endian e) noexcept:
+    os(os), mem_buf(dynamic_cast<omem_streambuf*>(os.rdbuf())), endian(e)
+{}
+
 void stream_writer::write_tag(const std::string& key, const tag& t)
 {
     write_type(t.get_type());
@@ -46,7 +166,22 @@ void stream_writer::write_string(const std::string& str)
         sstr << "String is too long for NBT (" << str.size() << " > " << max_string_len << ")";
         throw std::length_error(sstr.str());
     }
+    if(endian == endian::network)
+    {
+        write_varint(static_cast<uint32_t>(str.size()));
+        write_raw(str.data(), str.size());
+        return;
+    }
+    if(char* p = mem_reserve(2 + str.size()))
+    {
+        endian::write(p, static_cast<uint16_t>(str.size()), endian);
+        std::memcpy(p + 2, str.data(), str.size());
+        mem_buf->advance(2 + str.size());
+        stats::detail::bytes_written(2 + str.size());
+        return;
+    }
     write_num(static_cast<uint16_t>(str.size()));
+    stats::detail::bytes_written(str.size());
     os.write(str.data(), str.size());
 }
 
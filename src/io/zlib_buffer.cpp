@@ -0,0 +1,244 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/zlib_buffer.h"
+#include "io/imemstream.h"
+#include "io/omemstream.h"
+#include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include "stats.h"
+#include <algorithm>
+#include <climits>
+#include <new>
+
+namespace zlib
+{
+
+namespace //anonymous
+{
+    bool is_gzip(const char* data, size_t size)
+    {
+        return size >= 2 && static_cast<unsigned char>(data[0]) == 0x1f
+                         && static_cast<unsigned char>(data[1]) == 0x8b;
+    }
+
+    ///Returns a guess for the size of the decompressed data
+    size_t initial_size(const char* data, size_t size, const std::string& out, size_t size_hint)
+    {
+        if(size_hint == 0 && is_gzip(data, size) && size >= 18)
+        {
+            //The gzip trailer ends with the size modulo 2^32 in little endian
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(data + size - 4);
+            size_hint = size_t(p[0]) | size_t(p[1]) << 8 | size_t(p[2]) << 16 | size_t(p[3]) << 24;
+            //Don't trust it beyond the maximum compression ratio of deflate
+            size_hint = std::min(size_hint, 1032 * size);
+        }
+        if(size_hint != 0)
+            return std::max<size_t>(size_hint, 1);
+        //NBT data usually compresses to a fifth or less
+        return std::max<size_t>({out.capacity(), 4 * size, 4096});
+    }
+}
+
+//------------------------------------------------------------------------------
+
+struct deflater::state
+{
+    z_stream zstr;
+    ///Buffer for serializing tags
+    nbt::io::omemstream buf;
+
+    state(int level, bool gzip)
+    {
+        zstr.zalloc = Z_NULL;
+        zstr.zfree = Z_NULL;
+        zstr.opaque = Z_NULL;
+        int ret = deflateInit2(&zstr, level, Z_DEFLATED, 15 + (gzip ? 16 : 0), 8, Z_DEFAULT_STRATEGY);
+        if(ret != Z_OK)
+            throw zlib_error(zstr.msg, ret);
+    }
+
+    ~state()
+    {
+        deflateEnd(&zstr);
+    }
+};
+
+deflater::deflater(int level, bool gzip):
+    level_(level == Z_DEFAULT_COMPRESSION ? 6 : level), gzip_(gzip)
+{
+    if(level_ < 0 || level_ > 9)
+        throw zlib_error("Invalid compression level", Z_STREAM_ERROR);
+    st.reset(new state(level_, gzip_));
+}
+
+deflater::deflater(deflater&&) noexcept = default;
+deflater& deflater::operator=(deflater&&) noexcept = default;
+deflater::~deflater() noexcept = default;
+
+void deflater::compress(const char* data, size_t size, std::string& out)
+{
+    z_stream& zstr = st->zstr;
+    int ret = deflateReset(&zstr);
+    if(ret != Z_OK)
+        throw zlib_error(zstr.msg, ret);
+
+    //With an output buffer of deflateBound bytes, a single call suffices for inputs below 4 GiB
+    out.resize(deflateBound(&zstr, static_cast<uLong>(size)));
+    zstr.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    size_t in_left = size;
+    size_t have = 0;
+    do
+    {
+        zstr.avail_in = static_cast<uInt>(std::min<size_t>(in_left, UINT_MAX));
+        in_left -= zstr.avail_in;
+        if(have == out.size())
+            out.resize(2 * out.size());
+        zstr.next_out = reinterpret_cast<Bytef*>(&out[have]);
+        zstr.avail_out = static_cast<uInt>(std::min<size_t>(out.size() - have, UINT_MAX));
+        ret = deflate(&zstr, in_left == 0 ? Z_FINISH : Z_NO_FLUSH);
+        have = reinterpret_cast<char*>(zstr.next_out) - out.data();
+        in_left += zstr.avail_in;
+    } while(ret == Z_OK || ret == Z_BUF_ERROR);
+
+    if(ret != Z_STREAM_END)
+        throw zlib_error(zstr.msg, ret);
+    out.resize(have);
+}
+
+void deflater::compress_tag(const std::string& key, const nbt::tag& t, std::string& out, endian::endian e)
+{
+    nbt::io::omemstream& buf = st->buf;
+    buf.reset();
+    nbt::io::stream_writer(buf, e).write_tag(key, t);
+    compress(buf.data(), buf.size(), out);
+}
+
+//------------------------------------------------------------------------------
+
+struct inflater::state
+{
+    z_stream zstr;
+    ///Buffer for decompressing tags
+    std::string buf;
+
+    state()
+    {
+        zstr.zalloc = Z_NULL;
+        zstr.zfree = Z_NULL;
+        zstr.opaque = Z_NULL;
+        zstr.next_in = Z_NULL;
+        zstr.avail_in = 0;
+        //Autodetect between zlib and gzip
+        int ret = inflateInit2(&zstr, 32 + 15);
+        if(ret != Z_OK)
+            throw zlib_error(zstr.msg, ret);
+    }
+
+    ~state()
+    {
+        inflateEnd(&zstr);
+    }
+};
+
+inflater::inflater():
+    st(new state)
+{}
+
+inflater::inflater(inflater&&) noexcept = default;
+inflater& inflater::operator=(inflater&&) noexcept = default;
+inflater::~inflater() noexcept = default;
+
+void inflater::decompress(const char* data, size_t size, std::string& out, size_t size_hint)
+{
+    nbt::stats::detail::inflate_timer timer;
+    out.resize(initial_size(data, size, out, size_hint));
+
+    z_stream& zstr = st->zstr;
+    int ret = inflateReset(&zstr);
+    if(ret != Z_OK)
+        throw zlib_error(zstr.msg, ret);
+
+    zstr.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zstr.avail_in = 0;
+    size_t in_left = size;
+    size_t have = 0;
+    do
+    {
+        if(zstr.avail_in == 0)
+        {
+            zstr.avail_in = static_cast<uInt>(std::min<size_t>(in_left, UINT_MAX));
+            in_left -= zstr.avail_in;
+        }
+        if(have == out.size())
+            out.resize(2 * out.size());
+        zstr.next_out = reinterpret_cast<Bytef*>(&out[have]);
+        zstr.avail_out = static_cast<uInt>(std::min<size_t>(out.size() - have, UINT_MAX));
+        ret = inflate(&zstr, Z_NO_FLUSH);
+        have = reinterpret_cast<char*>(zstr.next_out) - out.data();
+        if(ret == Z_OK && zstr.avail_in == 0 && in_left == 0 && zstr.avail_out != 0)
+            ret = Z_BUF_ERROR; //Input ended before the end of the compressed data
+    } while(ret == Z_OK);
+
+    switch(ret)
+    {
+    case Z_STREAM_END:
+        out.resize(have);
+        return;
+    case Z_MEM_ERROR:
+        throw std::bad_alloc();
+    case Z_BUF_ERROR:
+        throw zlib_error("Unexpected end of stream", Z_DATA_ERROR);
+    default:
+        throw zlib_error(zstr.msg, ret);
+    }
+}
+
+std::pair<std::string, std::unique_ptr<nbt::tag_compound>>
+inflater::read_compound(const char* data, size_t size, endian::endian e)
+{
+    decompress(data, size, st->buf);
+    nbt::io::imemstream is(st->buf);
+    return nbt::io::read_compound(is, e);
+}
+
+//------------------------------------------------------------------------------
+
+void compress(const char* data, size_t size, std::string& out, int level, bool gzip)
+{
+    if(level == Z_DEFAULT_COMPRESSION)
+        level = 6;
+    if(level < 0 || level > 9)
+        throw zlib_error("Invalid compression level", Z_STREAM_ERROR);
+
+    //One deflater per level and format, created on first use
+    thread_local std::unique_ptr<deflater> deflaters[10][2];
+    auto& d = deflaters[level][gzip];
+    if(!d)
+        d.reset(new deflater(level, gzip));
+    d->compress(data, size, out);
+}
+
+void decompress(const char* data, size_t size, std::string& out, size_t size_hint)
+{
+    thread_local inflater inf;
+    inf.decompress(data, size, out, size_hint);
+}
+
+}
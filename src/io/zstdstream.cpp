@@ -0,0 +1,279 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/zstdstream.h"
+#include "stats.h"
+#include <algorithm>
+#include <new>
+#include <zstd.h>
+
+namespace zstd
+{
+
+using nbt::io::codec_error;
+
+namespace //anonymous
+{
+    ///Throws codec_error if @c ret is a zstd error code
+    size_t check(size_t ret)
+    {
+        if(ZSTD_isError(ret))
+            throw codec_error(std::string("zstd: ") + ZSTD_getErrorName(ret));
+        return ret;
+    }
+
+    void set_level(ZSTD_CCtx* cctx, int level)
+    {
+        if(level == -1)
+            level = ZSTD_CLEVEL_DEFAULT;
+        if(level < 1 || level > ZSTD_maxCLevel())
+            throw codec_error("Invalid zstd compression level " + std::to_string(level));
+        check(ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level));
+    }
+
+    ///Owns a context that is reused for all calls on the same thread
+    template<class Ctx, Ctx* (*create)(), size_t (*free_ctx)(Ctx*)>
+    class context
+    {
+    public:
+        Ctx* get()
+        {
+            if(!ctx && !(ctx = create()))
+                throw std::bad_alloc();
+            return ctx;
+        }
+        ~context() { free_ctx(ctx); }
+
+    private:
+        Ctx* ctx = nullptr;
+    };
+
+    thread_local context<ZSTD_CCtx, ZSTD_createCCtx, ZSTD_freeCCtx> compress_context;
+    thread_local context<ZSTD_DCtx, ZSTD_createDCtx, ZSTD_freeDCtx> decompress_context;
+
+    /**
+     * Decompresses the frames without knowing the size of their content,
+     * growing the output as needed
+     */
+    void decompress_stream(ZSTD_DCtx* dctx, const char* data, size_t size, std::string& out, size_t size_hint)
+    {
+        out.resize(std::max<size_t>({size_hint, 4 * size, 4096}));
+        ZSTD_inBuffer input = {data, size, 0};
+        size_t have = 0;
+        size_t ret;
+        do
+        {
+            if(have == out.size())
+                out.resize(2 * out.size());
+            ZSTD_outBuffer output = {&out[0], out.size(), have};
+            ret = check(ZSTD_decompressStream(dctx, &output, &input));
+            have = output.pos;
+            //No progress means that the input is truncated
+            if(ret != 0 && input.pos == input.size && have < out.size())
+                throw codec_error("Unexpected end of zstd stream");
+        } while(ret != 0 || input.pos < input.size);
+        out.resize(have);
+    }
+}
+
+void compress(const char* data, size_t size, std::string& out, int level)
+{
+    ZSTD_CCtx* cctx = compress_context.get();
+    check(ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters));
+    set_level(cctx, level);
+    out.resize(ZSTD_compressBound(size));
+    out.resize(check(ZSTD_compress2(cctx, &out[0], out.size(), data, size)));
+}
+
+void decompress(const char* data, size_t size, std::string& out, size_t size_hint)
+{
+    nbt::stats::detail::inflate_timer timer;
+    ZSTD_DCtx* dctx = decompress_context.get();
+    check(ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only));
+
+    unsigned long long content_size = ZSTD_getFrameContentSize(data, size);
+    if(content_size == ZSTD_CONTENTSIZE_ERROR)
+        throw codec_error("Invalid zstd frame");
+    //Only trust the stored size for a single frame and within reason, so
+    //that corrupt data can't make us allocate huge amounts of memory
+    if(content_size != ZSTD_CONTENTSIZE_UNKNOWN
+        && ZSTD_findFrameCompressedSize(data, size) == size
+        && content_size / 32768 <= size)
+    {
+        out.resize(content_size);
+        size_t n = check(ZSTD_decompressDCtx(dctx, &out[0], out.size(), data, size));
+        if(n != content_size)
+            throw codec_error("Corrupt zstd frame");
+    }
+    else
+        decompress_stream(dctx, data, size, out, size_hint);
+}
+
+//------------------------------------------------------------------------------
+
+decompress_streambuf::decompress_streambuf(std::istream& input, size_t bufsize):
+    is(input), dctx(ZSTD_createDCtx()), in(bufsize), out(bufsize)
+{
+    if(!dctx)
+        throw std::bad_alloc();
+    char* end = out.data() + out.size();
+    setg(end, end, end);
+}
+
+decompress_streambuf::~decompress_streambuf() noexcept
+{
+    ZSTD_freeDCtx(dctx);
+}
+
+decompress_streambuf::int_type decompress_streambuf::underflow()
+{
+    if(gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    if(frame_end)
+        return traits_type::eof();
+
+    ZSTD_outBuffer output = {out.data(), out.size(), 0};
+    do
+    {
+        //Only read if zstd has no more output pending from the last input
+        if(in_pos == in_end && output.pos == 0 && !output_pending)
+        {
+            is.read(in.data(), in.size());
+            if(is.bad())
+                throw std::ios_base::failure("Input stream is bad");
+            in_pos = 0;
+            in_end = is.gcount();
+            if(in_end == 0)
+                throw codec_error("Unexpected end of zstd stream");
+        }
+
+        ZSTD_inBuffer input = {in.data(), in_end, in_pos};
+        size_t ret;
+        {
+            nbt::stats::detail::inflate_timer timer;
+            ret = check(ZSTD_decompressStream(dctx, &output, &input));
+        }
+        in_pos = input.pos;
+        output_pending = output.pos == output.size;
+        if(ret == 0)
+        {
+            frame_end = true;
+            //In case we consumed too much, we have to rewind the input stream
+            is.clear();
+            is.seekg(-static_cast<std::streamoff>(in_end - in_pos), std::ios_base::cur);
+            if(output.pos == 0)
+                return traits_type::eof();
+        }
+    } while(output.pos == 0);
+
+    setg(out.data(), out.data(), out.data() + output.pos);
+    return traits_type::to_int_type(*gptr());
+}
+
+compress_streambuf::compress_streambuf(std::ostream& output, int level, size_t bufsize):
+    os(output), cctx(ZSTD_createCCtx()), in(bufsize), out(std::max(bufsize, ZSTD_CStreamOutSize()))
+{
+    if(!cctx)
+        throw std::bad_alloc();
+    try
+    {
+        set_level(cctx, level);
+    }
+    catch(...)
+    {
+        ZSTD_freeCCtx(cctx);
+        throw;
+    }
+    setp(in.data(), in.data() + in.size());
+}
+
+compress_streambuf::~compress_streambuf() noexcept
+{
+    try
+    {
+        close();
+    }
+    catch(...)
+    {
+        //ignore as we can't do anything about it
+    }
+    ZSTD_freeCCtx(cctx);
+}
+
+void compress_streambuf::compress_chunk(int mode)
+{
+    ZSTD_inBuffer input = {pbase(), size_t(pptr() - pbase()), 0};
+    bool done;
+    do
+    {
+        ZSTD_outBuffer output = {out.data(), out.size(), 0};
+        size_t ret = ZSTD_compressStream2(cctx, &output, &input, static_cast<ZSTD_EndDirective>(mode));
+        if(ZSTD_isError(ret))
+        {
+            os.setstate(std::ios_base::failbit);
+            check(ret);
+        }
+        if(!os.write(out.data(), output.pos))
+            throw std::ios_base::failure("Could not write to the output stream");
+        done = mode == ZSTD_e_continue ? input.pos == input.size : ret == 0;
+    } while(!done);
+    setp(in.data(), in.data() + in.size());
+}
+
+void compress_streambuf::close()
+{
+    if(!is_open_)
+        return;
+    is_open_ = false;
+    compress_chunk(ZSTD_e_end);
+}
+
+compress_streambuf::int_type compress_streambuf::overflow(int_type ch)
+{
+    if(!is_open_)
+        return traits_type::eof();
+    compress_chunk(ZSTD_e_continue);
+    if(ch != traits_type::eof())
+    {
+        *pptr() = ch;
+        pbump(1);
+    }
+    return ch;
+}
+
+int compress_streambuf::sync()
+{
+    if(is_open_)
+        compress_chunk(ZSTD_e_continue);
+    return 0;
+}
+
+void ozstdstream::close()
+{
+    try
+    {
+        buf.close();
+    }
+    catch(...)
+    {
+        setstate(badbit);
+    }
+}
+
+}
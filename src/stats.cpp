@@ -0,0 +1,243 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "stats.h"
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+#ifdef NBT_ENABLE_STATS
+#include <algorithm>
+#include "tag.h"
+#endif
+
+namespace nbt
+{
+namespace stats
+{
+
+uint64_t snapshot::total_tags_read() const
+{
+    return std::accumulate(tags_read.begin(), tags_read.end(), uint64_t(0));
+}
+
+uint64_t snapshot::total_tags_written() const
+{
+    return std::accumulate(tags_written.begin(), tags_written.end(), uint64_t(0));
+}
+
+#ifdef NBT_ENABLE_STATS
+
+namespace //anonymous
+{
+    typedef std::atomic<uint64_t> counter;
+
+    /**
+     * The counters of one thread. Only the owning thread increments them,
+     * but snapshots read them and reset() clears them from other threads.
+     * The increments are relaxed read-modify-write operations so that they
+     * can't overwrite a concurrent reset(). They stay cheap because the
+     * cache line normally belongs to the owning thread.
+     */
+    struct counters
+    {
+        counter tags_read[13]{};
+        counter tags_written[13]{};
+        counter bytes_read{0};
+        counter bytes_written{0};
+        counter tags_created{0};
+        std::atomic<unsigned> max_depth{0};
+        counter inflate_ns{0};
+        counter parse_ns{0};
+        ///Number of active parse_timers, only accessed by the owner
+        unsigned parse_timers = 0;
+        ///Current nesting depth, only accessed by the owner
+        unsigned depth = 0;
+
+        void add_to(snapshot& s) const
+        {
+            for(int i = 0; i < 13; ++i)
+            {
+                s.tags_read[i] += tags_read[i].load(std::memory_order_relaxed);
+                s.tags_written[i] += tags_written[i].load(std::memory_order_relaxed);
+            }
+            s.bytes_read += bytes_read.load(std::memory_order_relaxed);
+            s.bytes_written += bytes_written.load(std::memory_order_relaxed);
+            s.tags_created += tags_created.load(std::memory_order_relaxed);
+            s.max_depth = std::max(s.max_depth, max_depth.load(std::memory_order_relaxed));
+            s.inflate_time += std::chrono::nanoseconds(inflate_ns.load(std::memory_order_relaxed));
+            s.parse_time += std::chrono::nanoseconds(parse_ns.load(std::memory_order_relaxed));
+        }
+
+        void clear()
+        {
+            for(int i = 0; i < 13; ++i)
+            {
+                tags_read[i].store(0, std::memory_order_relaxed);
+                tags_written[i].store(0, std::memory_order_relaxed);
+            }
+            for(counter* c: {&bytes_read, &bytes_written, &tags_created, &inflate_ns, &parse_ns})
+                c->store(0, std::memory_order_relaxed);
+            max_depth.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    ///The counters of all running threads and the sum of those of finished threads
+    struct registry
+    {
+        std::mutex mutex;
+        std::vector<const counters*> threads;
+        snapshot finished;
+    };
+
+    registry& get_registry()
+    {
+        //Never destroyed, as threads may still finish during static destruction
+        static registry* reg = new registry;
+        return *reg;
+    }
+
+    struct thread_counters
+    {
+        counters c;
+
+        thread_counters()
+        {
+            registry& reg = get_registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.threads.push_back(&c);
+        }
+
+        ~thread_counters()
+        {
+            registry& reg = get_registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            c.add_to(reg.finished);
+            reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), &c));
+        }
+    };
+
+    counters& local()
+    {
+        thread_local thread_counters tc;
+        return tc.c;
+    }
+
+    inline void add(counter& c, uint64_t n)
+    {
+        c.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    inline size_t index(tag_type type)
+    {
+        return static_cast<size_t>(type) < 13 ? static_cast<size_t>(type) : 0;
+    }
+}
+
+snapshot get_snapshot()
+{
+    registry& reg = get_registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    snapshot s = reg.finished;
+    for(const counters* c: reg.threads)
+        c->add_to(s);
+    return s;
+}
+
+void reset()
+{
+    registry& reg = get_registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.finished = snapshot();
+    for(const counters* c: reg.threads)
+        const_cast<counters*>(c)->clear();
+}
+
+namespace detail
+{
+
+void tag_read(tag_type type, uint64_t n) { add(local().tags_read[index(type)], n); }
+void tag_written(tag_type type, uint64_t n) { add(local().tags_written[index(type)], n); }
+void bytes_read(uint64_t n) { add(local().bytes_read, n); }
+void bytes_written(uint64_t n) { add(local().bytes_written, n); }
+void tag_created() { add(local().tags_created, 1); }
+
+depth_guard::depth_guard()
+{
+    counters& c = local();
+    if(++c.depth > c.max_depth.load(std::memory_order_relaxed))
+        c.max_depth.store(c.depth, std::memory_order_relaxed);
+}
+
+depth_guard::~depth_guard()
+{
+    --local().depth;
+}
+
+inflate_timer::inflate_timer():
+    start(std::chrono::steady_clock::now())
+{}
+
+inflate_timer::~inflate_timer()
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    add(local().inflate_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+parse_timer::parse_timer():
+    outermost(local().parse_timers++ == 0)
+{
+    if(outermost)
+    {
+        inflate_start = local().inflate_ns.load(std::memory_order_relaxed);
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+parse_timer::~parse_timer()
+{
+    counters& c = local();
+    --c.parse_timers;
+    if(!outermost)
+        return;
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    //reset() may have cleared the inflate time in between
+    uint64_t inflated = c.inflate_ns.load(std::memory_order_relaxed);
+    inflated = inflated >= inflate_start ? inflated - inflate_start : 0;
+    add(c.parse_ns, uint64_t(elapsed) - std::min<uint64_t>(inflated, elapsed));
+}
+
+}
+
+#else
+
+snapshot get_snapshot()
+{
+    return snapshot();
+}
+
+void reset()
+{}
+
+#endif
+
+}
+}
@@ -19,7 +19,10 @@
  */
 #include "tag.h"
 #include "nbt_tags.h"
+#include "tag_arena.h"
+#include "stats.h"
 #include "text/json_formatter.h"
+#include <cstring>
 #include <limits>
 #include <ostream>
 #include <stdexcept>
@@ -31,6 +34,23 @@ namespace nbt
 static_assert(std::numeric_limits<float>::is_iec559 && std::numeric_limits<double>::is_iec559,
     "The floating point values for NBT must conform to IEC 559/IEEE 754");
 
+namespace //anonymous
+{
+    /* Each allocation of a tag is preceded by a header that tells whether the
+    memory comes from an arena. It has the same size as the arena's alignment,
+    so the tag itself stays aligned. */
+    typedef uint64_t alloc_header;
+
+    template<class... Tags> struct check_align;
+    template<> struct check_align<> : std::true_type {};
+    template<class T, class... Tags> struct check_align<T, Tags...>
+    : std::integral_constant<bool, alignof(T) <= alignof(alloc_header) && check_align<Tags...>::value> {};
+
+    static_assert(check_align<tag_byte, tag_short, tag_int, tag_long, tag_float, tag_double, tag_byte_array,
+            tag_string, tag_list, tag_compound, tag_int_array, tag_long_array>::value,
+        "The allocation header must not break the alignment of the tags");
+}
+
 bool is_valid_type(int type, bool allow_end)
 {
     return (allow_end ? 0 : 1) <= type && type <= 12;
@@ -43,6 +63,7 @@ std::unique_ptr<tag> tag::clone() &&
 
 std::unique_ptr<tag> tag::create(tag_type type)
 {
+    stats::detail::tag_created();
     switch(type)
     {
     case tag_type::Byte:        return make_unique<tag_byte>();
@@ -62,6 +83,27 @@ std::unique_ptr<tag> tag::create(tag_type type)
     }
 }
 
+void* tag::operator new(std::size_t size)
+{
+    tag_arena* arena = tag_arena::current();
+    size += sizeof(alloc_header);
+    char* mem = static_cast<char*>(arena ? arena->allocate(size) : ::operator new(size));
+    alloc_header from_arena = arena ? 1 : 0;
+    std::memcpy(mem, &from_arena, sizeof(alloc_header));
+    return mem + sizeof(alloc_header);
+}
+
+void tag::operator delete(void* ptr) noexcept
+{
+    if(!ptr)
+        return;
+    char* mem = static_cast<char*>(ptr) - sizeof(alloc_header);
+    alloc_header from_arena;
+    std::memcpy(&from_arena, mem, sizeof(alloc_header));
+    if(!from_arena) //Arena memory gets released by the arena itself
+        ::operator delete(mem);
+}
+
 bool operator==(const tag& lhs, const tag& rhs)
 {
     if(typeid(lhs) != typeid(rhs))
@@ -0,0 +1,93 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tag_arena.h"
+#include <algorithm>
+
+namespace nbt
+{
+
+namespace //anonymous
+{
+    thread_local tag_arena* current_arena = nullptr;
+
+    ///Alignment of all allocations from the arena
+    const size_t arena_align = 8;
+}
+
+tag_arena::scope::scope(tag_arena& arena) noexcept:
+    previous(current_arena)
+{
+    current_arena = &arena;
+}
+
+tag_arena::scope::~scope() noexcept
+{
+    current_arena = previous;
+}
+
+tag_arena::tag_arena(size_t block_size):
+    next_block_size(std::max(block_size, arena_align))
+{}
+
+tag_arena::~tag_arena() noexcept
+{}
+
+tag_arena* tag_arena::current() noexcept
+{
+    return current_arena;
+}
+
+void* tag_arena::allocate(size_t size)
+{
+    size = (size + arena_align - 1) & ~(arena_align - 1);
+    if(static_cast<size_t>(end - cur) < size)
+        add_block(size);
+    void* ret = cur;
+    cur += size;
+    used += size;
+    return ret;
+}
+
+void tag_arena::release() noexcept
+{
+    if(blocks.empty())
+        return;
+    //The last block is always the largest one
+    if(blocks.size() > 1)
+    {
+        std::swap(blocks.front(), blocks.back());
+        blocks.resize(1);
+    }
+    cur = blocks.front().get();
+    end = cur + last_block_size;
+    used = 0;
+}
+
+void tag_arena::add_block(size_t min_size)
+{
+    size_t size = std::max(next_block_size, min_size);
+    blocks.emplace_back(new char[size]);
+    cur = blocks.back().get();
+    end = cur + size;
+    last_block_size = size;
+    next_block_size = size * 2;
+}
+
+}
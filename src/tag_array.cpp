@@ -38,7 +38,7 @@ void tag_array<int8_t>::read_payload(io::stream_reader& reader)
         throw io::input_error("Error reading length of tag_byte_array");
 
     data.resize(length);
-    reader.get_istr().read(reinterpret_cast<char*>(data.data()), length);
+    reader.read_raw(reinterpret_cast<char*>(data.data()), length);
     if(!reader.get_istr())
         throw io::input_error("Error reading contents of tag_byte_array");
 }
@@ -53,14 +53,9 @@ void tag_array<T>::read_payload(io::stream_reader& reader)
     if(!reader.get_istr())
         throw io::input_error("Error reading length of array tag");
 
-    data.clear();
-    data.reserve(length);
-    for(int32_t i = 0; i < length; ++i)
-    {
-        T val;
-        reader.read_num(val);
-        data.push_back(val);
-    }
+    detail::read_in_blocks(data, static_cast<size_t>(length), reader.get_istr(), [&reader](T* dst, size_t len) {
+        reader.read_array(dst, len);
+    });
     if(!reader.get_istr())
         throw io::input_error("Error reading contents of array tag");
 }
@@ -75,7 +70,7 @@ void tag_array<int8_t>::write_payload(io::stream_writer& writer) const
         throw std::length_error("Byte array is too large for NBT");
     }
     writer.write_num(static_cast<int32_t>(size()));
-    writer.get_ostr().write(reinterpret_cast<const char*>(data.data()), data.size());
+    writer.write_raw(reinterpret_cast<const char*>(data.data()), data.size());
 }
 
 template<typename T>
@@ -87,8 +82,7 @@ void tag_array<T>::write_payload(io::stream_writer& writer) const
         throw std::length_error("Array is too large for NBT");
     }
     writer.write_num(static_cast<int32_t>(size()));
-    for(T i: data)
-        writer.write_num(i);
+    writer.write_array(data.data(), data.size());
 }
 
 }
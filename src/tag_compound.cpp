@@ -22,6 +22,7 @@
 #include "io/stream_writer.h"
 #include <istream>
 #include <sstream>
+#include <stdexcept>
 
 namespace nbt
 {
@@ -32,18 +33,36 @@ tag_compound::tag_compound(std::initializer_list<std::pair<std::string, value_in
         tags.emplace(std::move(pair.first), std::move(pair.second));
 }
 
-value& tag_compound::at(const std::string& key)
+value& tag_compound::at(std::string_view key)
 {
-    return tags.at(key);
+    load();
+    auto it = tags.find(key);
+    if(it == tags.end())
+        throw std::out_of_range("tag_compound::at: key not found");
+    return it->second;
 }
 
-const value& tag_compound::at(const std::string& key) const
+const value& tag_compound::at(std::string_view key) const
 {
-    return tags.at(key);
+    load();
+    auto it = tags.find(key);
+    if(it == tags.end())
+        throw std::out_of_range("tag_compound::at: key not found");
+    return it->second;
+}
+
+value& tag_compound::operator[](std::string_view key)
+{
+    load();
+    auto it = tags.find(key);
+    if(it == tags.end())
+        it = tags.emplace(std::string(key), value()).first;
+    return it->second;
 }
 
 std::pair<tag_compound::iterator, bool> tag_compound::put(const std::string& key, value_initializer&& val)
 {
+    load();
     auto it = tags.find(key);
     if(it != tags.end())
     {
@@ -58,21 +77,29 @@ std::pair<tag_compound::iterator, bool> tag_compound::put(const std::string& key
 
 std::pair<tag_compound::iterator, bool> tag_compound::insert(const std::string& key, value_initializer&& val)
 {
+    load();
     return tags.emplace(key, std::move(val));
 }
 
-bool tag_compound::erase(const std::string& key)
+bool tag_compound::erase(std::string_view key)
 {
-    return tags.erase(key) != 0;
+    load();
+    auto it = tags.find(key);
+    if(it == tags.end())
+        return false;
+    tags.erase(it);
+    return true;
 }
 
-bool tag_compound::has_key(const std::string& key) const
+bool tag_compound::has_key(std::string_view key) const
 {
+    load();
     return tags.find(key) != tags.end();
 }
 
-bool tag_compound::has_key(const std::string& key, tag_type type) const
+bool tag_compound::has_key(std::string_view key, tag_type type) const
 {
+    load();
     auto it = tags.find(key);
     return it != tags.end() && it->second.get_type() == type;
 }
@@ -80,6 +107,34 @@ bool tag_compound::has_key(const std::string& key, tag_type type) const
 void tag_compound::read_payload(io::stream_reader& reader)
 {
     clear();
+    lazy = reader.record_payload(type);
+    if(!lazy)
+        read_entries(reader);
+}
+
+size_t tag_compound::lazy_size(endian::endian e) const
+{
+    if(!lazy || (lazy->endian == endian::network) != (e == endian::network))
+        return 0;
+    return lazy->size;
+}
+
+void tag_compound::load_slow() const
+{
+    auto payload = std::move(lazy);
+    lazy.reset();
+    io::stream_reader::read_recorded(*payload, [this](io::stream_reader& reader) {
+        read_entries(reader);
+    });
+}
+
+void tag_compound::read_entries(io::stream_reader& reader) const
+{
+#ifdef NBT_FLAT_COMPOUND
+    //Sorting once at the end is cheaper than inserting in order
+    std::vector<map_t_::value_type> entries;
+    entries.reserve(8);
+#endif
     tag_type tt;
     while((tt = reader.read_type(true)) != tag_type::End)
     {
@@ -95,12 +150,26 @@ void tag_compound::read_payload(io::stream_reader& reader)
             throw io::input_error(str.str());
         }
         auto tptr = reader.read_payload(tt);
+#ifdef NBT_FLAT_COMPOUND
+        entries.emplace_back(std::move(key), value(std::move(tptr)));
+#else
         tags.emplace(std::move(key), value(std::move(tptr)));
+#endif
     }
+#ifdef NBT_FLAT_COMPOUND
+    tags.assign(std::move(entries));
+#endif
 }
 
 void tag_compound::write_payload(io::stream_writer& writer) const
 {
+    if(lazy && lazy->endian == writer.get_endian())
+    {
+        //The recorded payload can be copied as it is
+        writer.write_raw(lazy->buf->data() + lazy->offset, lazy->size);
+        return;
+    }
+    load();
     for(const auto& pair: tags)
         writer.write_tag(pair.first, pair.second);
     writer.write_type(tag_type::End);
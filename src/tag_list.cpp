@@ -21,17 +21,112 @@
 #include "nbt_tags.h"
 #include "io/stream_reader.h"
 #include "io/stream_writer.h"
+#include <cstddef>
+#include <cstdint>
 #include <istream>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <typeinfo>
 
 namespace nbt
 {
 
-tag_list::tag_list(std::initializer_list<int8_t>         il) { init<tag_byte>(il); }
-tag_list::tag_list(std::initializer_list<int16_t>        il) { init<tag_short>(il); }
-tag_list::tag_list(std::initializer_list<int32_t>        il) { init<tag_int>(il); }
-tag_list::tag_list(std::initializer_list<int64_t>        il) { init<tag_long>(il); }
-tag_list::tag_list(std::initializer_list<float>          il) { init<tag_float>(il); }
-tag_list::tag_list(std::initializer_list<double>         il) { init<tag_double>(il); }
+namespace //anonymous
+{
+    ///Value type of the vector for the given alternative of tag_list::packed_t_
+    template<class V>
+    using element_of = typename V::value_type;
+
+    template<class V>
+    using is_vector = std::integral_constant<bool, !std::is_same<V, std::monostate>::value>;
+
+    void read_elements(io::stream_reader& reader, int8_t* dst, size_t n)
+    {
+        reader.read_raw(reinterpret_cast<char*>(dst), n);
+    }
+
+    template<class T>
+    void read_elements(io::stream_reader& reader, T* dst, size_t n)
+    {
+        reader.read_array(dst, n);
+    }
+
+    void write_elements(io::stream_writer& writer, const int8_t* src, size_t n)
+    {
+        writer.write_raw(reinterpret_cast<const char*>(src), n);
+    }
+
+    template<class T>
+    void write_elements(io::stream_writer& writer, const T* src, size_t n)
+    {
+        writer.write_array(src, n);
+    }
+
+    template<class T>
+    std::vector<T> read_packed(io::stream_reader& reader, size_t length)
+    {
+        //The elements don't go through stream_reader::read_payload
+        stats::detail::tag_read(tag_primitive<T>::type, length);
+        std::optional<stats::detail::depth_guard> depth;
+        if(length > 0)
+            depth.emplace();
+
+        std::vector<T> vec;
+        detail::read_in_blocks(vec, length, reader.get_istr(), [&reader](T* dst, size_t len) {
+            read_elements(reader, dst, len);
+        });
+        if(!reader.get_istr())
+            throw io::input_error("Error reading contents of tag_list");
+        return vec;
+    }
+
+    ///Returns the unboxed elements of a tag_list::packed_t_ boxed into values
+    template<class Variant>
+    std::vector<value> box_elements(const Variant& packed)
+    {
+        std::vector<value> tags;
+        std::visit([&tags](const auto& vec) {
+            typedef std::decay_t<decltype(vec)> V;
+            if constexpr(is_vector<V>::value)
+            {
+                tags.reserve(vec.size());
+                for(auto x: vec)
+                    tags.emplace_back(make_unique<tag_primitive<element_of<V>>>(x));
+            }
+        }, packed);
+        return tags;
+    }
+
+    ///Guards the boxing of unboxed elements on const access. Shared between lists to keep them small.
+    std::mutex& box_mutex(const void* list)
+    {
+        static std::mutex mutexes[32];
+        return mutexes[(reinterpret_cast<uintptr_t>(list) / alignof(std::max_align_t)) % 32];
+    }
+
+    ///Compares unboxed elements with boxed ones
+    template<class T>
+    bool equal_elements(const std::vector<T>& vec, const std::vector<value>& tags)
+    {
+        if(vec.size() != tags.size())
+            return false;
+        for(size_t i = 0; i < vec.size(); ++i)
+        {
+            if(tags[i].get_type() != tag_primitive<T>::type
+                || static_cast<const tag_primitive<T>&>(tags[i].get()).get() != vec[i])
+                return false;
+        }
+        return true;
+    }
+}
+
+tag_list::tag_list(std::initializer_list<int8_t>  il): packed(std::vector<int8_t>(il)),  el_type_(tag_type::Byte) {}
+tag_list::tag_list(std::initializer_list<int16_t> il): packed(std::vector<int16_t>(il)), el_type_(tag_type::Short) {}
+tag_list::tag_list(std::initializer_list<int32_t> il): packed(std::vector<int32_t>(il)), el_type_(tag_type::Int) {}
+tag_list::tag_list(std::initializer_list<int64_t> il): packed(std::vector<int64_t>(il)), el_type_(tag_type::Long) {}
+tag_list::tag_list(std::initializer_list<float>   il): packed(std::vector<float>(il)),   el_type_(tag_type::Float) {}
+tag_list::tag_list(std::initializer_list<double>  il): packed(std::vector<double>(il)),  el_type_(tag_type::Double) {}
 tag_list::tag_list(std::initializer_list<std::string>    il) { init<tag_string>(il); }
 tag_list::tag_list(std::initializer_list<tag_byte_array> il) { init<tag_byte_array>(il); }
 tag_list::tag_list(std::initializer_list<tag_list>       il) { init<tag_list>(il); }
@@ -55,32 +150,189 @@ tag_list::tag_list(std::initializer_list<value> init)
     }
 }
 
+tag_list::tag_list(const tag_list& other):
+    packed(other.packed), el_type_(other.el_type_), lazy(other.lazy)
+{
+    //The boxed copies of unboxed elements are not copied, another thread may be making them
+    if(!is_packed())
+        tags = other.tags;
+}
+
+tag_list::tag_list(tag_list&& other) noexcept:
+    tags(std::move(other.tags)), packed(std::move(other.packed)), el_type_(other.el_type_),
+    cached(other.cached.load(std::memory_order_relaxed)), lazy(std::move(other.lazy))
+{}
+
+tag_list& tag_list::operator=(const tag_list& other)
+{
+    if(this != &other)
+        *this = tag_list(other);
+    return *this;
+}
+
+tag_list& tag_list::operator=(tag_list&& other) noexcept
+{
+    tags = std::move(other.tags);
+    packed = std::move(other.packed);
+    el_type_ = other.el_type_;
+    cached = other.cached.load(std::memory_order_relaxed);
+    lazy = std::move(other.lazy);
+    return *this;
+}
+
 value& tag_list::at(size_t i)
 {
+    unpack();
     return tags.at(i);
 }
 
 const value& tag_list::at(size_t i) const
 {
-    return tags.at(i);
+    return boxed().at(i);
 }
 
+template<class T>
+std::vector<T>& tag_list::primitives()
+{
+    load();
+    constexpr tag_type type = tag_primitive<T>::type;
+    if(el_type_ == tag_type::Null)
+        el_type_ = type;
+    else if(el_type_ != type)
+        throw std::bad_cast();
+
+    if(!is_packed())
+    {
+        std::vector<T> vec;
+        vec.reserve(tags.size());
+        for(const value& val: tags)
+        {
+            if(val.get_type() != type)
+                throw std::logic_error("The tags in the list do not all match the content type");
+            vec.push_back(static_cast<const tag_primitive<T>&>(val.get()).get());
+        }
+        packed = std::move(vec);
+        tags.clear();
+    }
+    else
+        uncache(); //The elements can be changed through the vector
+    return std::get<std::vector<T>>(packed);
+}
+
+template<class T>
+const std::vector<T>& tag_list::primitives() const
+{
+    load();
+    static const std::vector<T> empty;
+    if(el_type_ == tag_type::Null)
+        return empty;
+    if(el_type_ != tag_primitive<T>::type)
+        throw std::bad_cast();
+    if(is_packed())
+        return std::get<std::vector<T>>(packed);
+    if(tags.empty())
+        return empty;
+    throw std::logic_error("The elements of the list are boxed");
+}
+
+template NBT_EXPORT std::vector<int8_t>&  tag_list::primitives<int8_t>();
+template NBT_EXPORT std::vector<int16_t>& tag_list::primitives<int16_t>();
+template NBT_EXPORT std::vector<int32_t>& tag_list::primitives<int32_t>();
+template NBT_EXPORT std::vector<int64_t>& tag_list::primitives<int64_t>();
+template NBT_EXPORT std::vector<float>&   tag_list::primitives<float>();
+template NBT_EXPORT std::vector<double>&  tag_list::primitives<double>();
+template NBT_EXPORT const std::vector<int8_t>&  tag_list::primitives<int8_t>() const;
+template NBT_EXPORT const std::vector<int16_t>& tag_list::primitives<int16_t>() const;
+template NBT_EXPORT const std::vector<int32_t>& tag_list::primitives<int32_t>() const;
+template NBT_EXPORT const std::vector<int64_t>& tag_list::primitives<int64_t>() const;
+template NBT_EXPORT const std::vector<float>&   tag_list::primitives<float>() const;
+template NBT_EXPORT const std::vector<double>&  tag_list::primitives<double>() const;
+
 void tag_list::set(size_t i, value&& val)
 {
+    load();
     if(val.get_type() != el_type_)
         throw std::invalid_argument("The tag type does not match the list's content type");
+    unpack();
     tags.at(i) = std::move(val);
 }
 
 void tag_list::push_back(value_initializer&& val)
 {
+    load();
     if(!val) //don't allow null values
         throw std::invalid_argument("The value must not be null");
     if(el_type_ == tag_type::Null) //set content type if undetermined
         el_type_ = val.get_type();
     else if(el_type_ != val.get_type())
         throw std::invalid_argument("The tag type does not match the list's content type");
-    tags.push_back(std::move(val));
+
+    if(is_packed())
+    {
+        uncache();
+        std::visit([&val](auto& vec) {
+            typedef std::decay_t<decltype(vec)> V;
+            if constexpr(is_vector<V>::value)
+                vec.push_back(static_cast<const tag_primitive<element_of<V>>&>(val.get()).get());
+        }, packed);
+    }
+    else
+        tags.push_back(std::move(val));
+}
+
+void tag_list::pop_back()
+{
+    load();
+    if(is_packed())
+    {
+        uncache();
+        std::visit([](auto& vec) {
+            if constexpr(is_vector<std::decay_t<decltype(vec)>>::value)
+                vec.pop_back();
+        }, packed);
+    }
+    else
+        tags.pop_back();
+}
+
+size_t tag_list::size() const
+{
+    load();
+    if(is_packed())
+    {
+        return std::visit([](const auto& vec) -> size_t {
+            if constexpr(is_vector<std::decay_t<decltype(vec)>>::value)
+                return vec.size();
+            else
+                return 0;
+        }, packed);
+    }
+    return tags.size();
+}
+
+size_t tag_list::lazy_size(endian::endian e) const
+{
+    if(!lazy || (lazy->endian == endian::network) != (e == endian::network))
+        return 0;
+    return lazy->size;
+}
+
+void tag_list::unpack_slow()
+{
+    //Boxed copies made by const access become the elements, so references to them stay valid
+    if(!cached)
+        tags = box_elements(packed);
+    packed = std::monostate();
+    cached = false;
+}
+
+void tag_list::box_slow() const
+{
+    std::lock_guard<std::mutex> lock(box_mutex(this));
+    if(cached.load(std::memory_order_relaxed))
+        return;
+    tags = box_elements(packed);
+    cached.store(true, std::memory_order_release);
 }
 
 void tag_list::reset(tag_type type)
@@ -90,6 +342,23 @@ void tag_list::reset(tag_type type)
 }
 
 void tag_list::read_payload(io::stream_reader& reader)
+{
+    clear();
+    lazy = reader.record_payload(type);
+    if(!lazy)
+        read_contents(reader);
+}
+
+void tag_list::load_slow() const
+{
+    auto payload = std::move(lazy);
+    lazy.reset();
+    io::stream_reader::read_recorded(*payload, [this](io::stream_reader& reader) {
+        read_contents(reader);
+    });
+}
+
+void tag_list::read_contents(io::stream_reader& reader) const
 {
     tag_type lt = reader.read_type(true);
 
@@ -102,21 +371,37 @@ void tag_list::read_payload(io::stream_reader& reader)
 
     if(lt != tag_type::End)
     {
-        reset(lt);
-        tags.reserve(length);
-
-        for(int32_t i = 0; i < length; ++i)
-            tags.emplace_back(reader.read_payload(lt));
+        el_type_ = lt;
+        switch(lt)
+        {
+        case tag_type::Byte:   packed = read_packed<int8_t>(reader, length); break;
+        case tag_type::Short:  packed = read_packed<int16_t>(reader, length); break;
+        case tag_type::Int:    packed = read_packed<int32_t>(reader, length); break;
+        case tag_type::Long:   packed = read_packed<int64_t>(reader, length); break;
+        case tag_type::Float:  packed = read_packed<float>(reader, length); break;
+        case tag_type::Double: packed = read_packed<double>(reader, length); break;
+        default:
+            tags.reserve(length);
+            for(int32_t i = 0; i < length; ++i)
+                tags.emplace_back(reader.read_payload(lt));
+        }
     }
     else
     {
         //In case of tag_end, ignore the length and leave the type undetermined
-        reset(tag_type::Null);
+        el_type_ = tag_type::Null;
     }
 }
 
 void tag_list::write_payload(io::stream_writer& writer) const
 {
+    if(lazy && lazy->endian == writer.get_endian())
+    {
+        //The recorded payload can be copied as it is
+        writer.write_raw(lazy->buf->data() + lazy->offset, lazy->size);
+        return;
+    }
+    load();
     if(size() > io::stream_writer::max_array_len)
     {
         writer.get_ostr().setstate(std::ios::failbit);
@@ -126,6 +411,15 @@ void tag_list::write_payload(io::stream_writer& writer) const
                       ? el_type_
                       : tag_type::End);
     writer.write_num(static_cast<int32_t>(size()));
+    if(is_packed())
+    {
+        stats::detail::tag_written(el_type_, size());
+        std::visit([&writer](const auto& vec) {
+            if constexpr(is_vector<std::decay_t<decltype(vec)>>::value)
+                write_elements(writer, vec.data(), vec.size());
+        }, packed);
+        return;
+    }
     for(const auto& val: tags)
     {
         //check if the value is of the correct type
@@ -140,7 +434,23 @@ void tag_list::write_payload(io::stream_writer& writer) const
 
 bool operator==(const tag_list& lhs, const tag_list& rhs)
 {
-    return lhs.el_type_ == rhs.el_type_ && lhs.tags == rhs.tags;
+    lhs.load();
+    rhs.load();
+    if(lhs.el_type_ != rhs.el_type_)
+        return false;
+    if(lhs.is_packed() && rhs.is_packed())
+        return lhs.packed == rhs.packed;
+    if(!lhs.is_packed() && !rhs.is_packed())
+        return lhs.tags == rhs.tags;
+
+    const tag_list& pl = lhs.is_packed() ? lhs : rhs;
+    const tag_list& bl = lhs.is_packed() ? rhs : lhs;
+    return std::visit([&bl](const auto& vec) {
+        if constexpr(is_vector<std::decay_t<decltype(vec)>>::value)
+            return equal_elements(vec, bl.tags);
+        else
+            return false;
+    }, pl.packed);
 }
 
 bool operator!=(const tag_list& lhs, const tag_list& rhs)
@@ -20,9 +20,20 @@
 #include "text/json_formatter.h"
 #include "nbt_tags.h"
 #include "nbt_visitor.h"
+#include <algorithm>
+#include <charconv>
 #include <cmath>
-#include <iomanip>
-#include <limits>
+#include <cstring>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NBT_JSON_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace nbt
 {
@@ -31,176 +42,593 @@ namespace text
 
 namespace //anonymous
 {
-    ///Helper class which uses the Visitor pattern to pretty-print tags
-    class json_fmt_visitor : public const_nbt_visitor
+    ///Returns true if the character has to be escaped in a JSON string
+    bool needs_escape(unsigned char c)
+    {
+        return c < 0x20 || c == '"' || c == '\\';
+    }
+
+    /**
+     * Returns a pointer to the first character in [p, end) that has to be
+     * escaped, or end. The vectorized loops skip blocks without such
+     * characters, the scalar loop finds the exact position.
+     */
+    const char* find_escape(const char* p, const char* end)
+    {
+#if defined(__AVX2__)
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i max_ctrl = _mm256_set1_epi8(0x1F);
+        for(; end - p >= 32; p += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+                _mm256_cmpeq_epi8(_mm256_min_epu8(v, max_ctrl), v)); //v <= 0x1F as unsigned
+            if(_mm256_movemask_epi8(m) != 0)
+                break;
+        }
+#elif defined(NBT_JSON_SSE2)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i max_ctrl = _mm_set1_epi8(0x1F);
+        for(; end - p >= 16; p += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                _mm_cmpeq_epi8(_mm_min_epu8(v, max_ctrl), v)); //v <= 0x1F as unsigned
+            if(_mm_movemask_epi8(m) != 0)
+                break;
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t quote = vdupq_n_u8('"');
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        const uint8x16_t max_ctrl = vdupq_n_u8(0x1F);
+        for(; end - p >= 16; p += 16)
+        {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+            uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                    vcleq_u8(v, max_ctrl));
+            uint64x2_t m64 = vreinterpretq_u64_u8(m);
+            if((vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1)) != 0)
+                break;
+        }
+#endif
+        for(; p != end; ++p)
+            if(needs_escape(*p))
+                return p;
+        return end;
+    }
+
+    ///Returns the name of the tag type as printed by operator<<
+    std::string_view type_name(tag_type type)
+    {
+        switch(type)
+        {
+        case tag_type::End:         return "end";
+        case tag_type::Byte:        return "byte";
+        case tag_type::Short:       return "short";
+        case tag_type::Int:         return "int";
+        case tag_type::Long:        return "long";
+        case tag_type::Float:       return "float";
+        case tag_type::Double:      return "double";
+        case tag_type::Byte_Array:  return "byte_array";
+        case tag_type::String:      return "string";
+        case tag_type::List:        return "list";
+        case tag_type::Compound:    return "compound";
+        case tag_type::Int_Array:   return "int_array";
+        case tag_type::Long_Array:  return "long_array";
+        case tag_type::Null:        return "null";
+        default:                    return "invalid";
+        }
+    }
+
+    /**
+     * @brief Collects output in a fixed buffer and writes it to the stream in blocks
+     *
+     * Numbers are converted with std::to_chars, which is independent of the
+     * stream's locale and flags, and gives the shortest representation of
+     * floating point values that reads back exactly.
+     */
+    class output_buffer
     {
     public:
-        json_fmt_visitor(std::ostream& os, const json_formatter&):
+        explicit output_buffer(std::ostream& os):
             os(os)
         {}
 
-        void visit(const tag_byte& b) override
-        { os << static_cast<int>(b.get()) << "b"; } //We don't want to print a character
+        output_buffer(const output_buffer&) = delete;
+        output_buffer& operator=(const output_buffer&) = delete;
 
-        void visit(const tag_short& s) override
-        { os << s.get() << "s"; }
+        void put(char c)
+        {
+            if(pos == capacity)
+                flush();
+            buf[pos++] = c;
+        }
 
-        void visit(const tag_int& i) override
-        { os << i.get(); }
+        void write(const char* str, size_t n)
+        {
+            if(n > capacity - pos)
+            {
+                flush();
+                if(n > capacity)
+                {
+                    os.write(str, n);
+                    return;
+                }
+            }
+            std::memcpy(buf + pos, str, n);
+            pos += n;
+        }
 
-        void visit(const tag_long& l) override
-        { os << l.get() << "l"; }
+        void write(std::string_view str)
+        { write(str.data(), str.size()); }
 
-        void visit(const tag_float& f) override
+        ///Writes n copies of the character
+        void fill(char c, size_t n)
         {
-            write_float(f.get());
-            os << "f";
+            while(n > 0)
+            {
+                if(pos == capacity)
+                    flush();
+                size_t len = std::min(n, capacity - pos);
+                std::memset(buf + pos, c, len);
+                pos += len;
+                n -= len;
+            }
         }
 
-        void visit(const tag_double& d) override
+        ///Writes the string in quotes, escaping characters as JSON requires
+        void write_quoted(std::string_view str)
         {
-            write_float(d.get());
-            os << "d";
+            put('"');
+            const char* p = str.data();
+            const char* end = p + str.size();
+            while(true)
+            {
+                const char* esc = find_escape(p, end);
+                write(p, esc - p);
+                if(esc == end)
+                    break;
+                write_escape(*esc);
+                p = esc + 1;
+            }
+            put('"');
         }
 
-        void visit(const tag_byte_array& ba) override
-        { os << "[" << ba.size() << " bytes]"; }
+        template<class T>
+        void write_int(T val)
+        {
+            char* p = reserve(max_number_len);
+            pos = std::to_chars(p, p + max_number_len, val).ptr - buf;
+        }
 
-        void visit(const tag_string& s) override
-        { os << '"' << s.get() << '"'; } //TODO: escape special characters
+        ///Writes a finite floating point value in the shortest form that reads back exactly
+        template<class T>
+        void write_float(T val)
+        {
+            char* p = reserve(max_number_len);
+            pos = std::to_chars(p, p + max_number_len, val).ptr - buf;
+        }
 
-        void visit(const tag_list& l) override
+        void flush()
+        {
+            os.write(buf, pos);
+            pos = 0;
+        }
+
+    private:
+        static constexpr size_t capacity = 16384;
+        ///Longest output of to_chars for integers and shortest floating point values
+        static constexpr size_t max_number_len = 32;
+
+        std::ostream& os;
+        size_t pos = 0;
+        char buf[capacity];
+
+        char* reserve(size_t n)
+        {
+            if(n > capacity - pos)
+                flush();
+            return buf + pos;
+        }
+
+        void write_escape(char c)
+        {
+            switch(c)
+            {
+            case '"':  write("\\\""); break;
+            case '\\': write("\\\\"); break;
+            case '\b': write("\\b"); break;
+            case '\f': write("\\f"); break;
+            case '\n': write("\\n"); break;
+            case '\r': write("\\r"); break;
+            case '\t': write("\\t"); break;
+            default:
+                {
+                    static const char hex[] = "0123456789abcdef";
+                    const char esc[] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF]};
+                    write(esc, sizeof(esc));
+                }
+            }
+        }
+    };
+
+    ///Layout shared by the visitors
+    class formatting_visitor : public const_nbt_visitor
+    {
+    protected:
+        formatting_visitor(output_buffer& out, const json_options& opts):
+            out(out), opts(opts)
+        {}
+
+        output_buffer& out;
+        const json_options& opts;
+        unsigned indent_lvl = 0;
+
+        ///Starts a new line at the current indentation when pretty printing
+        void new_line()
+        {
+            if(opts.pretty)
+            {
+                out.put('\n');
+                out.fill(' ', size_t(opts.indent) * indent_lvl);
+            }
+        }
+
+        ///Separates elements that are on the same line
+        void element_sep()
+        { out.write(opts.pretty ? ", " : ","); }
+
+        ///Separates keys from values
+        void key_sep()
+        { out.write(opts.pretty ? ": " : ":"); }
+
+        template<class T>
+        void write_numbers(const std::vector<T>& vec, char suffix = 0)
+        {
+            out.put('[');
+            for(size_t i = 0; i < vec.size(); ++i)
+            {
+                if(i != 0)
+                    element_sep();
+                out.write_int(vec[i]);
+                if(suffix)
+                    out.put(suffix);
+            }
+            out.put(']');
+        }
+
+        void write_list(const tag_list& l)
         {
             //Wrap lines for lists of lists or compounds.
             //Lists of other types can usually be on one line without problem.
             const bool break_lines = l.size() > 0 &&
                 (l.el_type() == tag_type::List || l.el_type() == tag_type::Compound);
 
-            os << "[";
+            out.put('[');
             if(break_lines)
-            {
-                os << "\n";
                 ++indent_lvl;
-                for(unsigned int i = 0; i < l.size(); ++i)
+            //Unboxed elements are written as they are, so formatting doesn't modify the list
+            l.visit_elements([this, break_lines](const auto& elements) {
+                for(size_t i = 0; i < elements.size(); ++i)
                 {
-                    indent();
-                    if(l[i])
-                        l[i].get().accept(*this);
-                    else
-                        write_null();
-                    if(i != l.size()-1)
-                        os << ",";
-                    os << "\n";
+                    if(break_lines)
+                        new_line();
+                    else if(i != 0)
+                        element_sep();
+                    write_element(elements[i]);
+                    if(break_lines && i != elements.size()-1)
+                        out.put(',');
                 }
-                --indent_lvl;
-                indent();
-            }
-            else
+            });
+            if(break_lines)
             {
-                for(unsigned int i = 0; i < l.size(); ++i)
-                {
-                    if(l[i])
-                        l[i].get().accept(*this);
-                    else
-                        write_null();
-                    if(i != l.size()-1)
-                        os << ", ";
-                }
+                --indent_lvl;
+                new_line();
             }
-            os << "]";
+            out.put(']');
         }
 
-        void visit(const tag_compound& c) override
+        template<class F>
+        void write_compound(const tag_compound& c, F write_key)
         {
             if(c.size() == 0) //No line breaks inside empty compounds please
             {
-                os << "{}";
+                out.write("{}");
                 return;
             }
 
-            os << "{\n";
+            out.put('{');
             ++indent_lvl;
-            unsigned int i = 0;
+            size_t i = 0;
             for(const auto& kv: c)
             {
-                indent();
-                os << kv.first << ": ";
-                if(kv.second)
-                    kv.second.get().accept(*this);
-                else
-                    write_null();
+                new_line();
+                write_key(kv.first);
+                key_sep();
+                write_value(kv.second);
                 if(i != c.size()-1)
-                    os << ",";
-                os << "\n";
+                    out.put(',');
                 ++i;
             }
             --indent_lvl;
-            indent();
-            os << "}";
+            new_line();
+            out.put('}');
         }
 
-        void visit(const tag_int_array& ia) override
+        void write_value(const value& val)
         {
-            os << "[";
-            for(unsigned int i = 0; i < ia.size(); ++i)
-            {
-                os << ia[i];
-                if(i != ia.size()-1)
-                    os << ", ";
-            }
-            os << "]";
+            if(val)
+                val.get().accept(*this);
+            else
+                out.write("null");
         }
 
-        void visit(const tag_long_array& la) override
+        void write_element(const value& val)
+        { write_value(val); }
+
+        template<class T>
+        void write_element(T x)
+        { tag_primitive<T>(x).accept(*this); }
+    };
+
+    ///Helper class which uses the Visitor pattern to pretty-print tags in the JSON-like syntax
+    class json_fmt_visitor : public formatting_visitor
+    {
+    public:
+        json_fmt_visitor(output_buffer& out, const json_options& opts):
+            formatting_visitor(out, opts)
+        {}
+
+        void visit(const tag_byte& b) override
         {
-            os << "[";
-            for(unsigned int i = 0; i < la.size(); ++i)
-            {
-                os << la[i] << "l";
-                if(i != la.size()-1)
-                    os << ", ";
-            }
-            os << "]";
+            out.write_int(static_cast<int>(b.get())); //We don't want to print a character
+            out.put('b');
         }
 
-    private:
-        const std::string indent_str = "  ";
+        void visit(const tag_short& s) override
+        {
+            out.write_int(s.get());
+            out.put('s');
+        }
 
-        std::ostream& os;
-        int indent_lvl = 0;
+        void visit(const tag_int& i) override
+        { out.write_int(i.get()); }
 
-        void indent()
+        void visit(const tag_long& l) override
+        {
+            out.write_int(l.get());
+            out.put('l');
+        }
+
+        void visit(const tag_float& f) override
+        {
+            write_float(f.get());
+            out.put('f');
+        }
+
+        void visit(const tag_double& d) override
+        {
+            write_float(d.get());
+            out.put('d');
+        }
+
+        void visit(const tag_byte_array& ba) override
         {
-            for(int i = 0; i < indent_lvl; ++i)
-                os << indent_str;
+            out.put('[');
+            out.write_int(ba.size());
+            out.write(" bytes]");
         }
 
+        void visit(const tag_string& s) override
+        {
+            out.put('"');
+            out.write(s.get()); //TODO: escape special characters
+            out.put('"');
+        }
+
+        void visit(const tag_list& l) override
+        { write_list(l); }
+
+        void visit(const tag_compound& c) override
+        { write_compound(c, [this](const std::string& key) { out.write(key); }); }
+
+        void visit(const tag_int_array& ia) override
+        { write_numbers(ia.get()); }
+
+        void visit(const tag_long_array& la) override
+        { write_numbers(la.get(), 'l'); }
+
+    private:
         template<class T>
-        void write_float(T val, int precision = std::numeric_limits<T>::max_digits10)
+        void write_float(T val)
         {
             if(std::isfinite(val))
-                os << std::setprecision(precision) << val;
+                out.write_float(val);
             else if(std::isinf(val))
             {
                 if(std::signbit(val))
-                    os << "-";
-                os << "Infinity";
+                    out.put('-');
+                out.write("Infinity");
             }
             else
-                os << "NaN";
+                out.write("NaN");
+        }
+    };
+
+    ///Writes tags as standard JSON
+    class strict_json_visitor : public formatting_visitor
+    {
+    public:
+        strict_json_visitor(output_buffer& out, const json_options& opts):
+            formatting_visitor(out, opts), typed(opts.types == json_types::typed)
+        {}
+
+        void visit(const tag_byte& b) override
+        {
+            begin(b);
+            out.write_int(static_cast<int>(b.get()));
+            end();
         }
 
-        void write_null()
+        void visit(const tag_short& s) override
+        {
+            begin(s);
+            out.write_int(s.get());
+            end();
+        }
+
+        void visit(const tag_int& i) override
         {
-            os << "null";
+            begin(i);
+            out.write_int(i.get());
+            end();
+        }
+
+        void visit(const tag_long& l) override
+        {
+            begin(l);
+            out.write_int(l.get());
+            end();
+        }
+
+        void visit(const tag_float& f) override
+        {
+            begin(f);
+            write_float(f.get());
+            end();
+        }
+
+        void visit(const tag_double& d) override
+        {
+            begin(d);
+            write_float(d.get());
+            end();
+        }
+
+        void visit(const tag_byte_array& ba) override
+        {
+            begin(ba);
+            write_numbers(ba.get());
+            end();
+        }
+
+        void visit(const tag_string& s) override
+        {
+            begin(s);
+            out.write_quoted(s.get());
+            end();
+        }
+
+        void visit(const tag_list& l) override
+        {
+            if(typed)
+            {
+                write_type(tag_type::List);
+                if(l.el_type() != tag_type::Null)
+                {
+                    element_sep();
+                    out.write("\"element_type\"");
+                    key_sep();
+                    out.put('"');
+                    out.write(type_name(l.el_type()));
+                    out.put('"');
+                }
+                write_value_key();
+            }
+            write_list(l);
+            end();
+        }
+
+        void visit(const tag_compound& c) override
+        {
+            begin(c);
+            write_compound(c, [this](const std::string& key) { out.write_quoted(key); });
+            end();
+        }
+
+        void visit(const tag_int_array& ia) override
+        {
+            begin(ia);
+            write_numbers(ia.get());
+            end();
+        }
+
+        void visit(const tag_long_array& la) override
+        {
+            begin(la);
+            write_numbers(la.get());
+            end();
+        }
+
+    private:
+        const bool typed;
+
+        ///Opens the object around a typed value
+        void begin(const tag& t)
+        {
+            if(typed)
+            {
+                write_type(t.get_type());
+                write_value_key();
+            }
+        }
+
+        void write_type(tag_type type)
+        {
+            out.write("{\"type\"");
+            key_sep();
+            out.put('"');
+            out.write(type_name(type));
+            out.put('"');
+        }
+
+        void write_value_key()
+        {
+            element_sep();
+            out.write("\"value\"");
+            key_sep();
+        }
+
+        ///Closes the object around a typed value
+        void end()
+        {
+            if(typed)
+                out.put('}');
+        }
+
+        template<class T>
+        void write_float(T val)
+        {
+            if(std::isfinite(val))
+                out.write_float(val);
+            else if(!typed)
+                out.write("null"); //JSON has no infinities or NaN
+            else if(std::isinf(val))
+                out.write(std::signbit(val) ? "\"-Infinity\"" : "\"Infinity\"");
+            else
+                out.write("\"NaN\"");
         }
     };
 }
 
 void json_formatter::print(std::ostream& os, const tag& t) const
 {
-    json_fmt_visitor v(os, *this);
-    t.accept(v);
+    output_buffer out(os);
+    if(opts.syntax == json_syntax::strict)
+    {
+        strict_json_visitor v(out, opts);
+        t.accept(v);
+    }
+    else
+    {
+        json_fmt_visitor v(out, opts);
+        t.accept(v);
+    }
+    out.flush();
 }
 
 }
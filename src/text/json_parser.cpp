@@ -0,0 +1,631 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "text/json_parser.h"
+#include "nbt_tags.h"
+#include "parse_util.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+namespace nbt
+{
+namespace text
+{
+
+namespace //anonymous
+{
+    using detail::is_digit;
+    using detail::type_name;
+    using detail::append_utf8;
+
+    bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    ///Returns the tag type with the name printed by operator<<, or tag_type::Null
+    tag_type type_from_name(std::string_view name)
+    {
+        static const std::string_view names[] = {
+            "end", "byte", "short", "int", "long", "float", "double",
+            "byte_array", "string", "list", "compound", "int_array", "long_array"
+        };
+        for(int i = 1; i < 13; ++i)
+            if(name == names[i])
+                return static_cast<tag_type>(i);
+        return tag_type::Null;
+    }
+
+    ///The text of a JSON number
+    struct number
+    {
+        const char* begin;
+        const char* end;
+        ///Whether it has neither fraction nor exponent
+        bool integer;
+    };
+
+    ///Parses the number as T, returns false if it is out of range or not an integer
+    template<class T>
+    bool to_integer(const number& num, T& out)
+    {
+        if(!num.integer)
+            return false;
+        auto res = std::from_chars(num.begin, num.end, out);
+        return res.ec == std::errc();
+    }
+
+    template<class T>
+    T to_floating(const number& num)
+    {
+        return detail::parse_floating<T>(num.begin, num.end);
+    }
+
+    ///Single pass parser over a buffer
+    class parser
+    {
+    public:
+        parser(std::string_view str, json_types types):
+            begin(str.data()), p(begin), end(begin + str.size()), typed(types == json_types::typed)
+        {}
+
+        std::unique_ptr<tag> parse_root()
+        {
+            skip_space();
+            const char* start = p;
+            std::unique_ptr<tag> t = typed ? read_typed() : read_plain();
+            if(!t)
+                fail("Expected a tag", start);
+            skip_space();
+            if(p != end)
+                fail("Unexpected trailing data");
+            return t;
+        }
+
+        std::unique_ptr<tag_compound> parse_root_compound()
+        {
+            skip_space();
+            const char* start = p;
+            std::unique_ptr<tag> t = parse_root();
+            if(t->get_type() != tag_type::Compound)
+                fail("Expected a compound", start);
+            return std::unique_ptr<tag_compound>(static_cast<tag_compound*>(t.release()));
+        }
+
+    private:
+        const char* const begin;
+        const char* p;
+        const char* const end;
+        const bool typed;
+        unsigned depth = 0;
+
+        [[noreturn]] void fail(const std::string& msg) const
+        {
+            fail(msg, p);
+        }
+
+        [[noreturn]] void fail(const std::string& msg, const char* at) const
+        {
+            throw parse_error(msg, at - begin);
+        }
+
+        void skip_space()
+        {
+            while(p != end && is_space(*p))
+                ++p;
+        }
+
+        ///Skips whitespace and returns the next character, failing at the end of the input
+        char peek()
+        {
+            skip_space();
+            if(p == end)
+                fail("Unexpected end of input");
+            return *p;
+        }
+
+        void expect(char c)
+        {
+            if(peek() != c)
+                fail(std::string("Expected '") + c + "'");
+            ++p;
+        }
+
+        ///Skips a comma if there is one, otherwise expects the closing bracket
+        bool next_element(char close)
+        {
+            char c = peek();
+            if(c == ',')
+            {
+                ++p;
+                return true;
+            }
+            if(c != close)
+                fail(std::string("Expected ',' or '") + close + "'");
+            return false;
+        }
+
+        ///Consumes the opening bracket and returns false if the object or array is empty
+        bool open(char close)
+        {
+            //Typed tags are nested two levels deep, in their object and its value
+            if(++depth > (typed ? 2 : 1) * json_parser::max_depth)
+                fail("Tags are nested too deeply");
+            ++p;
+            if(peek() == close)
+            {
+                ++p;
+                --depth;
+                return false;
+            }
+            return true;
+        }
+
+        void close(char c)
+        {
+            expect(c);
+            --depth;
+        }
+
+        void read_literal(std::string_view lit)
+        {
+            if(size_t(end - p) < lit.size() || std::string_view(p, lit.size()) != lit)
+                fail("Invalid literal");
+            p += lit.size();
+        }
+
+        number read_number()
+        {
+            number num{p, nullptr, true};
+            const char* q = p;
+            if(q != end && *q == '-')
+                ++q;
+            if(q == end || !is_digit(*q))
+                fail("Invalid number");
+            if(*q == '0')
+                ++q;
+            else
+                while(q != end && is_digit(*q))
+                    ++q;
+            if(q != end && *q == '.')
+            {
+                num.integer = false;
+                ++q;
+                if(q == end || !is_digit(*q))
+                    fail("Invalid number", q);
+                while(q != end && is_digit(*q))
+                    ++q;
+            }
+            if(q != end && (*q == 'e' || *q == 'E'))
+            {
+                num.integer = false;
+                ++q;
+                if(q != end && (*q == '+' || *q == '-'))
+                    ++q;
+                if(q == end || !is_digit(*q))
+                    fail("Invalid number", q);
+                while(q != end && is_digit(*q))
+                    ++q;
+            }
+            num.end = p = q;
+            return num;
+        }
+
+        std::string read_string()
+        {
+            if(peek() != '"')
+                fail("Expected string");
+            const char* start = p++;
+            std::string str;
+            while(true)
+            {
+                const char* run = p;
+                while(p != end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20)
+                    ++p;
+                str.append(run, p);
+                if(p == end)
+                    fail("Unterminated string", start);
+                if(*p == '"')
+                    break;
+                if(*p != '\\')
+                    fail("Unescaped control character in string");
+
+                const char* esc = p++;
+                if(p == end)
+                    fail("Unterminated string", start);
+                switch(*p++)
+                {
+                case '"':  str += '"'; break;
+                case '\\': str += '\\'; break;
+                case '/':  str += '/'; break;
+                case 'b':  str += '\b'; break;
+                case 'f':  str += '\f'; break;
+                case 'n':  str += '\n'; break;
+                case 'r':  str += '\r'; break;
+                case 't':  str += '\t'; break;
+                case 'u':
+                    {
+                        uint32_t cp = read_hex4(esc);
+                        //Combine surrogate pairs
+                        if(cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+                        {
+                            const char* save = p;
+                            p += 2;
+                            uint32_t low = read_hex4(save);
+                            if(low >= 0xDC00 && low < 0xE000)
+                                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            else
+                                p = save;
+                        }
+                        append_utf8(str, cp);
+                    }
+                    break;
+                default:
+                    fail("Invalid escape sequence", esc);
+                }
+            }
+            ++p;
+            return str;
+        }
+
+        uint32_t read_hex4(const char* esc)
+        {
+            uint32_t cp;
+            auto res = std::from_chars(p, std::min(p + 4, end), cp, 16);
+            if(res.ec != std::errc() || res.ptr != p + 4)
+                fail("Invalid escape sequence", esc);
+            p += 4;
+            return cp;
+        }
+
+        ///Validates and skips any value
+        void skip_value()
+        {
+            switch(peek())
+            {
+            case '{':
+                if(open('}'))
+                {
+                    do
+                    {
+                        read_string();
+                        expect(':');
+                        skip_value();
+                    } while(next_element('}'));
+                    close('}');
+                }
+                break;
+            case '[':
+                if(open(']'))
+                {
+                    do
+                        skip_value();
+                    while(next_element(']'));
+                    close(']');
+                }
+                break;
+            case '"': read_string(); break;
+            case 't': read_literal("true"); break;
+            case 'f': read_literal("false"); break;
+            case 'n': read_literal("null"); break;
+            default:  read_number();
+            }
+        }
+
+        //Plain JSON
+
+        ///Returns null for a JSON null
+        std::unique_ptr<tag> read_plain()
+        {
+            switch(peek())
+            {
+            case '{':  return read_plain_object();
+            case '[':  return read_plain_array();
+            case '"':  return std::make_unique<tag_string>(read_string());
+            case 't':  read_literal("true"); return std::make_unique<tag_byte>(1);
+            case 'f':  read_literal("false"); return std::make_unique<tag_byte>(0);
+            case 'n':  read_literal("null"); return nullptr;
+            default:
+                {
+                    number num = read_number();
+                    int64_t i;
+                    if(to_integer(num, i))
+                    {
+                        if(i >= std::numeric_limits<int32_t>::min() && i <= std::numeric_limits<int32_t>::max())
+                            return std::make_unique<tag_int>(static_cast<int32_t>(i));
+                        return std::make_unique<tag_long>(i);
+                    }
+                    return std::make_unique<tag_double>(to_floating<double>(num));
+                }
+            }
+        }
+
+        std::unique_ptr<tag> read_plain_object()
+        {
+            auto comp = std::make_unique<tag_compound>();
+            if(!open('}'))
+                return comp;
+            do
+            {
+                std::string key = read_string();
+                expect(':');
+                comp->put(key, read_plain());
+            } while(next_element('}'));
+            close('}');
+            return comp;
+        }
+
+        std::unique_ptr<tag> read_plain_array()
+        {
+            auto list = std::make_unique<tag_list>();
+            if(!open(']'))
+                return list;
+
+            //Numbers are collected unboxed and widened as needed
+            std::vector<int64_t> ints;
+            std::vector<double> doubles;
+            bool numbers = false;
+            do
+            {
+                char c = peek();
+                const char* start = p;
+                if(c == '-' || is_digit(c))
+                {
+                    if(list->size() > 0)
+                        fail("Can't insert a number into list of " + type_name(list->el_type()), start);
+                    numbers = true;
+                    number num = read_number();
+                    int64_t i;
+                    if(doubles.empty() && to_integer(num, i))
+                        ints.push_back(i);
+                    else
+                    {
+                        if(doubles.empty())
+                            doubles.assign(ints.begin(), ints.end());
+                        doubles.push_back(to_floating<double>(num));
+                    }
+                }
+                else
+                {
+                    std::unique_ptr<tag> t = read_plain();
+                    if(!t)
+                        fail("null is not allowed in arrays", start);
+                    if(numbers || (list->size() > 0 && list->el_type() != t->get_type()))
+                        fail("Can't insert " + type_name(t->get_type()) + " into list of "
+                            + (numbers ? std::string("numbers") : type_name(list->el_type())), start);
+                    list->push_back(std::move(t));
+                }
+            } while(next_element(']'));
+            close(']');
+
+            if(!doubles.empty())
+                list->primitives<double>() = std::move(doubles);
+            else if(numbers)
+            {
+                bool fits_int = std::all_of(ints.begin(), ints.end(), [](int64_t i) {
+                    return i >= std::numeric_limits<int32_t>::min() && i <= std::numeric_limits<int32_t>::max();
+                });
+                if(fits_int)
+                    list->primitives<int32_t>().assign(ints.begin(), ints.end());
+                else
+                    list->primitives<int64_t>() = std::move(ints);
+            }
+            return list;
+        }
+
+        //Typed JSON
+
+        tag_type read_type_name()
+        {
+            skip_space();
+            const char* start = p;
+            tag_type type = type_from_name(read_string());
+            if(type == tag_type::Null)
+                fail("Invalid tag type", start);
+            return type;
+        }
+
+        ///Reads an object {"type": ..., "value": ...}
+        std::unique_ptr<tag> read_typed()
+        {
+            if(peek() != '{')
+                fail("Expected '{'");
+            const char* start = p;
+            if(!open('}'))
+                fail("Missing type", start);
+
+            tag_type type = tag_type::Null;
+            tag_type el_type = tag_type::Null;
+            const char* value_pos = nullptr;
+            std::unique_ptr<tag> result;
+            do
+            {
+                skip_space();
+                const char* key_pos = p;
+                std::string key = read_string();
+                expect(':');
+                if(key == "type" && type == tag_type::Null)
+                    type = read_type_name();
+                else if(key == "element_type" && el_type == tag_type::Null)
+                    el_type = read_type_name();
+                else if(key == "value" && !value_pos)
+                {
+                    skip_space();
+                    value_pos = p;
+                    //If the type comes later, parse the value again when it's known
+                    if(type != tag_type::Null)
+                        result = read_typed_value(type);
+                    else
+                        skip_value();
+                }
+                else
+                    fail("Unexpected key \"" + key + "\"", key_pos);
+            } while(next_element('}'));
+            close('}');
+
+            if(type == tag_type::Null)
+                fail("Missing type", start);
+            if(!value_pos)
+                fail("Missing value", start);
+            if(!result)
+            {
+                const char* after = p;
+                p = value_pos;
+                result = read_typed_value(type);
+                p = after;
+            }
+            if(el_type != tag_type::Null)
+            {
+                if(type != tag_type::List)
+                    fail("element_type is only allowed for lists", start);
+                tag_list& list = static_cast<tag_list&>(*result);
+                if(list.size() == 0)
+                    list.reset(el_type);
+                else if(list.el_type() != el_type)
+                    fail("The elements do not match the element_type", start);
+            }
+            return result;
+        }
+
+        template<class T>
+        T read_integer()
+        {
+            skip_space();
+            const char* start = p;
+            number num = read_number();
+            T val;
+            if(!to_integer(num, val))
+                fail("Expected an integer in the range of " + type_name(tag_primitive<T>::type), start);
+            return val;
+        }
+
+        template<class T>
+        T read_floating()
+        {
+            if(peek() == '"')
+            {
+                const char* start = p;
+                std::string str = read_string();
+                if(str == "NaN")
+                    return std::numeric_limits<T>::quiet_NaN();
+                if(str == "Infinity")
+                    return std::numeric_limits<T>::infinity();
+                if(str == "-Infinity")
+                    return -std::numeric_limits<T>::infinity();
+                fail("Expected a number", start);
+            }
+            return to_floating<T>(read_number());
+        }
+
+        template<class T>
+        std::unique_ptr<tag> read_typed_array()
+        {
+            std::vector<T> vec;
+            if(peek() != '[')
+                fail("Expected '['");
+            if(open(']'))
+            {
+                do
+                    vec.push_back(read_integer<T>());
+                while(next_element(']'));
+                close(']');
+            }
+            return std::make_unique<tag_array<T>>(std::move(vec));
+        }
+
+        std::unique_ptr<tag> read_typed_value(tag_type type)
+        {
+            switch(type)
+            {
+            case tag_type::Byte:       return std::make_unique<tag_byte>(read_integer<int8_t>());
+            case tag_type::Short:      return std::make_unique<tag_short>(read_integer<int16_t>());
+            case tag_type::Int:        return std::make_unique<tag_int>(read_integer<int32_t>());
+            case tag_type::Long:       return std::make_unique<tag_long>(read_integer<int64_t>());
+            case tag_type::Float:      return std::make_unique<tag_float>(read_floating<float>());
+            case tag_type::Double:     return std::make_unique<tag_double>(read_floating<double>());
+            case tag_type::String:     return std::make_unique<tag_string>(read_string());
+            case tag_type::Byte_Array: return read_typed_array<int8_t>();
+            case tag_type::Int_Array:  return read_typed_array<int32_t>();
+            case tag_type::Long_Array: return read_typed_array<int64_t>();
+
+            case tag_type::List:
+                {
+                    auto list = std::make_unique<tag_list>();
+                    if(peek() != '[')
+                        fail("Expected '['");
+                    if(!open(']'))
+                        return list;
+                    do
+                    {
+                        skip_space();
+                        const char* start = p;
+                        std::unique_ptr<tag> t = read_typed();
+                        if(list->size() > 0 && list->el_type() != t->get_type())
+                            fail("Can't insert " + type_name(t->get_type()) + " into list of "
+                                + type_name(list->el_type()), start);
+                        list->push_back(std::move(t));
+                    } while(next_element(']'));
+                    close(']');
+                    return list;
+                }
+
+            case tag_type::Compound:
+                {
+                    auto comp = std::make_unique<tag_compound>();
+                    if(peek() != '{')
+                        fail("Expected '{'");
+                    if(!open('}'))
+                        return comp;
+                    do
+                    {
+                        std::string key = read_string();
+                        expect(':');
+                        if(peek() == 'n')
+                        {
+                            read_literal("null");
+                            comp->put(key, nullptr);
+                        }
+                        else
+                            comp->put(key, read_typed());
+                    } while(next_element('}'));
+                    close('}');
+                    return comp;
+                }
+
+            default:
+                fail("Invalid tag type");
+            }
+        }
+    };
+}
+
+std::unique_ptr<tag> json_parser::parse(std::string_view str) const
+{
+    return parser(str, types).parse_root();
+}
+
+std::unique_ptr<tag_compound> json_parser::parse_compound(std::string_view str) const
+{
+    return parser(str, types).parse_root_compound();
+}
+
+}
+}
@@ -0,0 +1,141 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PARSE_UTIL_H_INCLUDED
+#define PARSE_UTIL_H_INCLUDED
+
+#include "tag.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace nbt
+{
+namespace text
+{
+///Helpers shared by the text parsers
+namespace detail
+{
+
+inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+///Returns the name of the type for error messages, e.g. tag_int
+inline std::string type_name(tag_type type)
+{
+    std::ostringstream str;
+    str << "tag_" << type;
+    return str.str();
+}
+
+inline void append_utf8(std::string& str, uint32_t cp)
+{
+    if(cp < 0x80)
+        str += static_cast<char>(cp);
+    else if(cp < 0x800)
+    {
+        str += static_cast<char>(0xC0 | (cp >> 6));
+        str += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if(cp < 0x10000)
+    {
+        str += static_cast<char>(0xE0 | (cp >> 12));
+        str += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        str += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        str += static_cast<char>(0xF0 | (cp >> 18));
+        str += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        str += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        str += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+/**
+ * Returns the decimal exponent of the first significant digit of the
+ * number [s, e), e.g. 2 for 123.4 and -2 for 0.01e0. The number must have
+ * a nonzero digit. Saturates instead of overflowing for huge exponents.
+ */
+inline long decimal_exponent(const char* s, const char* e)
+{
+    if(s != e && (*s == '-' || *s == '+'))
+        ++s;
+    long int_digits = 0; //Digits before the point, starting at the first nonzero one
+    long frac_zeros = 0; //Zeros after the point before the first nonzero digit
+    bool point = false;
+    bool significant = false;
+    for(; s != e && *s != 'e' && *s != 'E'; ++s)
+    {
+        if(*s == '.')
+            point = true;
+        else if(*s != '0' || significant)
+        {
+            significant = true;
+            if(!point)
+                ++int_digits;
+        }
+        else if(point)
+            ++frac_zeros;
+    }
+    const long limit = 1000000;
+    long exp = 0;
+    if(s != e)
+    {
+        ++s;
+        bool negative = s != e && *s == '-';
+        if(s != e && (*s == '-' || *s == '+'))
+            ++s;
+        for(; s != e && is_digit(*s); ++s)
+            exp = std::min(10 * exp + (*s - '0'), limit);
+        if(negative)
+            exp = -exp;
+    }
+    return exp + (int_digits > 0 ? int_digits - 1 : -frac_zeros - 1);
+}
+
+/**
+ * Parses the decimal number [s, e), which may start with a minus sign.
+ * Numbers that are out of range overflow to infinity and underflow to zero.
+ * Unlike strtod, this does not depend on the locale.
+ */
+template<class T>
+T parse_floating(const char* s, const char* e)
+{
+    T val;
+    auto res = std::from_chars(s, e, val);
+    if(res.ec == std::errc::result_out_of_range)
+    {
+        //Only huge or tiny magnitudes are out of range, so the sign of the exponent tells which
+        val = decimal_exponent(s, e) > 0 ? std::numeric_limits<T>::infinity() : T(0);
+        return *s == '-' ? -val : val;
+    }
+    return val;
+}
+
+}
+}
+}
+
+#endif // PARSE_UTIL_H_INCLUDED
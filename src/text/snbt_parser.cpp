@@ -0,0 +1,506 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "text/snbt_parser.h"
+#include "nbt_tags.h"
+#include "parse_util.h"
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace nbt
+{
+namespace text
+{
+
+namespace //anonymous
+{
+    using detail::is_digit;
+    using detail::type_name;
+    using detail::append_utf8;
+
+    bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    ///Returns true if the character may appear in unquoted strings and numbers
+    bool is_unquoted(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+            || c == '_' || c == '-' || c == '.' || c == '+';
+    }
+
+    ///Returns true if [s, e) is an integer without leading zeros: [-+]?(0|[1-9][0-9]*)
+    bool match_integer(const char* s, const char* e)
+    {
+        if(s != e && (*s == '-' || *s == '+'))
+            ++s;
+        if(s == e || (*s == '0' && e - s > 1))
+            return false;
+        for(; s != e; ++s)
+            if(!is_digit(*s))
+                return false;
+        return true;
+    }
+
+    /**
+     * Returns true if [s, e) is a decimal number: [-+]?([0-9]+[.]?|[0-9]*[.][0-9]+)(e[-+]?[0-9]+)?
+     * If need_point is true, the part before the exponent must contain a point.
+     */
+    bool match_decimal(const char* s, const char* e, bool need_point)
+    {
+        if(s != e && (*s == '-' || *s == '+'))
+            ++s;
+        const char* int_start = s;
+        while(s != e && is_digit(*s))
+            ++s;
+        bool digits = s != int_start;
+        bool point = s != e && *s == '.';
+        if(point)
+        {
+            ++s;
+            const char* frac_start = s;
+            while(s != e && is_digit(*s))
+                ++s;
+            digits = digits || s != frac_start;
+        }
+        if(!digits || (need_point && !point))
+            return false;
+        if(s != e && (*s == 'e' || *s == 'E'))
+        {
+            ++s;
+            if(s != e && (*s == '-' || *s == '+'))
+                ++s;
+            if(s == e || !is_digit(*s))
+                return false;
+            while(s != e && is_digit(*s))
+                ++s;
+        }
+        return s == e;
+    }
+
+    ///Parses an integer matched by match_integer, returns false if it is out of range
+    template<class T>
+    bool parse_integer(const char* s, const char* e, T& out)
+    {
+        if(*s == '+')
+            ++s;
+        auto res = std::from_chars(s, e, out);
+        return res.ec == std::errc() && res.ptr == e;
+    }
+
+    ///Parses a number matched by match_decimal
+    template<class T>
+    T parse_decimal(const char* s, const char* e)
+    {
+        if(*s == '+')
+            ++s;
+        return detail::parse_floating<T>(s, e);
+    }
+
+    ///A token given without quotes, classified like Minecraft does
+    struct scalar
+    {
+        ///The type of the number, or tag_type::String if it is no number
+        tag_type type;
+        int64_t i;
+        double d;
+        float f;
+        ///Whether an integer had a type suffix
+        bool suffix;
+    };
+
+    scalar classify(const char* s, const char* e)
+    {
+        scalar sc;
+        sc.type = tag_type::String;
+        sc.suffix = true;
+        size_t len = e - s;
+        if((len == 4 && std::equal(s, e, "true")) || (len == 5 && std::equal(s, e, "false")))
+        {
+            sc.type = tag_type::Byte;
+            sc.i = len == 4;
+            return sc;
+        }
+
+        const char* body_end = e - 1;
+        switch(e[-1])
+        {
+        case 'b': case 'B':
+            if(int8_t v; match_integer(s, body_end) && parse_integer(s, body_end, v))
+                sc = {tag_type::Byte, v, 0, 0, true};
+            break;
+        case 's': case 'S':
+            if(int16_t v; match_integer(s, body_end) && parse_integer(s, body_end, v))
+                sc = {tag_type::Short, v, 0, 0, true};
+            break;
+        case 'l': case 'L':
+            if(int64_t v; match_integer(s, body_end) && parse_integer(s, body_end, v))
+                sc = {tag_type::Long, v, 0, 0, true};
+            break;
+        case 'f': case 'F':
+            if(match_decimal(s, body_end, false))
+            {
+                sc.type = tag_type::Float;
+                sc.f = parse_decimal<float>(s, body_end);
+            }
+            break;
+        case 'd': case 'D':
+            if(match_decimal(s, body_end, false))
+            {
+                sc.type = tag_type::Double;
+                sc.d = parse_decimal<double>(s, body_end);
+            }
+            break;
+        default:
+            if(match_integer(s, e))
+            {
+                if(int32_t v; parse_integer(s, e, v))
+                    sc = {tag_type::Int, v, 0, 0, false};
+            }
+            else if(match_decimal(s, e, true))
+            {
+                sc.type = tag_type::Double;
+                sc.d = parse_decimal<double>(s, e);
+            }
+        }
+        return sc;
+    }
+
+    ///Recursive descent parser over a buffer
+    class parser
+    {
+    public:
+        explicit parser(std::string_view str):
+            begin(str.data()), p(begin), end(begin + str.size())
+        {}
+
+        std::unique_ptr<tag> parse_root()
+        {
+            std::unique_ptr<tag> t = read_value();
+            skip_space();
+            if(p != end)
+                fail("Unexpected trailing data");
+            return t;
+        }
+
+        std::unique_ptr<tag_compound> parse_root_compound()
+        {
+            skip_space();
+            if(p == end || *p != '{')
+                fail("Expected '{'");
+            std::unique_ptr<tag_compound> comp = read_compound();
+            skip_space();
+            if(p != end)
+                fail("Unexpected trailing data");
+            return comp;
+        }
+
+    private:
+        const char* const begin;
+        const char* p;
+        const char* const end;
+        unsigned depth = 0;
+
+        [[noreturn]] void fail(const std::string& msg) const
+        {
+            fail(msg, p);
+        }
+
+        [[noreturn]] void fail(const std::string& msg, const char* at) const
+        {
+            throw parse_error(msg, at - begin);
+        }
+
+        void skip_space()
+        {
+            while(p != end && is_space(*p))
+                ++p;
+        }
+
+        void expect(char c)
+        {
+            skip_space();
+            if(p == end || *p != c)
+                fail(std::string("Expected '") + c + "'");
+            ++p;
+        }
+
+        ///Skips a comma if there is one, returns false if not
+        bool separator()
+        {
+            skip_space();
+            if(p != end && *p == ',')
+            {
+                ++p;
+                skip_space();
+                return true;
+            }
+            return false;
+        }
+
+        void enter()
+        {
+            if(++depth > snbt_parser::max_depth)
+                fail("Tags are nested too deeply");
+        }
+
+        ///Returns the unquoted token at the current position
+        std::string_view read_token()
+        {
+            const char* start = p;
+            while(p != end && is_unquoted(*p))
+                ++p;
+            if(p == start)
+            {
+                if(p == end)
+                    fail("Unexpected end of input");
+                fail(std::string("Unexpected character '") + *p + "'");
+            }
+            return std::string_view(start, p - start);
+        }
+
+        std::string read_quoted()
+        {
+            const char* start = p;
+            const char quote = *p++;
+            auto plain_end = [this, quote] {
+                const char* q = p;
+                while(q != end && *q != quote && *q != '\\')
+                    ++q;
+                return q;
+            };
+
+            const char* run_end = plain_end();
+            std::string str(p, run_end);
+            p = run_end;
+            while(p != end && *p == '\\')
+            {
+                const char* esc = p++;
+                if(p == end)
+                    break;
+                switch(char c = *p++)
+                {
+                case '\\': case '"': case '\'':
+                    str += c; break;
+                case 'b': str += '\b'; break;
+                case 'f': str += '\f'; break;
+                case 'n': str += '\n'; break;
+                case 'r': str += '\r'; break;
+                case 's': str += ' '; break;
+                case 't': str += '\t'; break;
+                case 'u':
+                    {
+                        uint32_t cp = read_hex4(esc);
+                        //Combine surrogate pairs
+                        if(cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+                        {
+                            const char* save = p;
+                            p += 2;
+                            uint32_t low = read_hex4(save);
+                            if(low >= 0xDC00 && low < 0xE000)
+                                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            else
+                                p = save;
+                        }
+                        append_utf8(str, cp);
+                    }
+                    break;
+                default:
+                    fail("Invalid escape sequence", esc);
+                }
+                run_end = plain_end();
+                str.append(p, run_end);
+                p = run_end;
+            }
+            if(p == end)
+                fail("Unterminated string", start);
+            ++p;
+            return str;
+        }
+
+        uint32_t read_hex4(const char* esc)
+        {
+            uint32_t cp;
+            auto res = std::from_chars(p, std::min(p + 4, end), cp, 16);
+            if(res.ec != std::errc() || res.ptr != p + 4)
+                fail("Invalid escape sequence", esc);
+            p += 4;
+            return cp;
+        }
+
+        std::string read_key()
+        {
+            skip_space();
+            if(p != end && (*p == '"' || *p == '\''))
+                return read_quoted();
+            if(p == end || !is_unquoted(*p))
+                fail("Expected key");
+            return std::string(read_token());
+        }
+
+        std::unique_ptr<tag> read_value()
+        {
+            skip_space();
+            if(p == end)
+                fail("Expected value");
+            switch(*p)
+            {
+            case '{':  return read_compound();
+            case '[':  return read_list();
+            case '"':
+            case '\'': return std::make_unique<tag_string>(read_quoted());
+            default:
+                {
+                    std::string_view token = read_token();
+                    return make_tag(classify(token.data(), token.data() + token.size()), token);
+                }
+            }
+        }
+
+        static std::unique_ptr<tag> make_tag(const scalar& sc, std::string_view token)
+        {
+            switch(sc.type)
+            {
+            case tag_type::Byte:   return std::make_unique<tag_byte>(static_cast<int8_t>(sc.i));
+            case tag_type::Short:  return std::make_unique<tag_short>(static_cast<int16_t>(sc.i));
+            case tag_type::Int:    return std::make_unique<tag_int>(static_cast<int32_t>(sc.i));
+            case tag_type::Long:   return std::make_unique<tag_long>(sc.i);
+            case tag_type::Float:  return std::make_unique<tag_float>(sc.f);
+            case tag_type::Double: return std::make_unique<tag_double>(sc.d);
+            default:               return std::make_unique<tag_string>(std::string(token));
+            }
+        }
+
+        std::unique_ptr<tag_compound> read_compound()
+        {
+            enter();
+            ++p;
+            auto comp = std::make_unique<tag_compound>();
+            skip_space();
+            while(p != end && *p != '}')
+            {
+                std::string key = read_key();
+                expect(':');
+                comp->put(key, read_value());
+                if(!separator())
+                    break;
+            }
+            expect('}');
+            --depth;
+            return comp;
+        }
+
+        std::unique_ptr<tag> read_list()
+        {
+            if(end - p >= 3 && p[2] == ';')
+            {
+                switch(p[1])
+                {
+                case 'B': return read_array<int8_t>(tag_type::Byte_Array);
+                case 'I': return read_array<int32_t>(tag_type::Int_Array);
+                case 'L': return read_array<int64_t>(tag_type::Long_Array);
+                }
+            }
+
+            enter();
+            ++p;
+            auto list = std::make_unique<tag_list>();
+            skip_space();
+            while(p != end && *p != ']')
+            {
+                const char* start = p;
+                if(*p == '{' || *p == '[' || *p == '"' || *p == '\'')
+                {
+                    std::unique_ptr<tag> t = read_value();
+                    check_element(*list, t->get_type(), start);
+                    list->push_back(std::move(t));
+                }
+                else
+                {
+                    //Numbers are appended unboxed
+                    std::string_view token = read_token();
+                    scalar sc = classify(token.data(), token.data() + token.size());
+                    check_element(*list, sc.type, start);
+                    switch(sc.type)
+                    {
+                    case tag_type::Byte:   list->primitives<int8_t>().push_back(static_cast<int8_t>(sc.i)); break;
+                    case tag_type::Short:  list->primitives<int16_t>().push_back(static_cast<int16_t>(sc.i)); break;
+                    case tag_type::Int:    list->primitives<int32_t>().push_back(static_cast<int32_t>(sc.i)); break;
+                    case tag_type::Long:   list->primitives<int64_t>().push_back(sc.i); break;
+                    case tag_type::Float:  list->primitives<float>().push_back(sc.f); break;
+                    case tag_type::Double: list->primitives<double>().push_back(sc.d); break;
+                    default:               list->push_back(std::string(token));
+                    }
+                }
+                if(!separator())
+                    break;
+            }
+            expect(']');
+            --depth;
+            return list;
+        }
+
+        void check_element(const tag_list& list, tag_type type, const char* at) const
+        {
+            if(list.el_type() != tag_type::Null && list.el_type() != type)
+                fail("Can't insert " + type_name(type) + " into list of " + type_name(list.el_type()), at);
+        }
+
+        template<class T>
+        std::unique_ptr<tag> read_array(tag_type type)
+        {
+            constexpr tag_type el_type = tag_primitive<T>::type;
+            p += 3;
+            std::vector<T> vec;
+            skip_space();
+            while(p != end && *p != ']')
+            {
+                const char* start = p;
+                std::string_view token = read_token();
+                scalar sc = classify(token.data(), token.data() + token.size());
+                //Accept the element type, or integers without suffix that fit into it
+                bool ok = sc.type == el_type
+                    || (sc.type == tag_type::Int && !sc.suffix
+                        && sc.i >= std::numeric_limits<T>::min() && sc.i <= std::numeric_limits<T>::max());
+                if(!ok)
+                    fail("Can't insert " + type_name(sc.type) + " into " + type_name(type), start);
+                vec.push_back(static_cast<T>(sc.i));
+                if(!separator())
+                    break;
+            }
+            expect(']');
+            return std::make_unique<tag_array<T>>(std::move(vec));
+        }
+    };
+}
+
+std::unique_ptr<tag> snbt_parser::parse(std::string_view str) const
+{
+    return parser(str).parse_root();
+}
+
+std::unique_ptr<tag_compound> snbt_parser::parse_compound(std::string_view str) const
+{
+    return parser(str).parse_root_compound();
+}
+
+}
+}
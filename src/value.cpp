@@ -315,24 +315,24 @@ value::operator const std::string&() const
     return dynamic_cast<tag_string&>(*tag_).get();
 }
 
-value& value::at(const std::string& key)
+value& value::at(std::string_view key)
 {
     return dynamic_cast<tag_compound&>(*tag_).at(key);
 }
 
-const value& value::at(const std::string& key) const
+const value& value::at(std::string_view key) const
 {
     return dynamic_cast<const tag_compound&>(*tag_).at(key);
 }
 
-value& value::operator[](const std::string& key)
+value& value::operator[](std::string_view key)
 {
     return dynamic_cast<tag_compound&>(*tag_)[key];
 }
 
 value& value::operator[](const char* key)
 {
-    return (*this)[std::string(key)];
+    return (*this)[std::string_view(key)];
 }
 
 value& value::at(size_t i)
@@ -0,0 +1,244 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "varint.h"
+#include "endian_str.h"
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace varint
+{
+
+namespace //anonymous
+{
+    ///The continuation bits of eight bytes loaded into a 64 bit word
+    const uint64_t high_bits = 0x8080808080808080;
+
+    ///Index of the lowest set bit, x must not be 0
+    unsigned lowest_bit(uint64_t x)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long i;
+        _BitScanForward64(&i, x);
+        return i;
+#else
+        unsigned i = 0;
+        for(; !(x & 1); x >>= 1)
+            ++i;
+        return i;
+#endif
+    }
+
+    ///Returns the length of the number starting in the low byte of w, or 0 if it is longer than 8 bytes
+    unsigned encoded_length(uint64_t w)
+    {
+        uint64_t stop = ~w & high_bits;
+        return stop ? lowest_bit(stop) / 8 + 1 : 0;
+    }
+
+    ///Concatenates the 7 bit groups of the lowest n bytes of w
+    uint64_t gather(uint64_t w, unsigned n)
+    {
+        if(n < 8)
+            w &= (uint64_t(1) << (8 * n)) - 1;
+#if defined(__BMI2__)
+        return _pext_u64(w, 0x7f7f7f7f7f7f7f7f);
+#else
+        return (w & 0x7f)
+             | (w >> 1 & 0x3f80)
+             | (w >> 2 & 0x1fc000)
+             | (w >> 3 & 0xfe00000)
+             | (w >> 4 & 0x7f0000000)
+             | (w >> 5 & 0x3f800000000)
+             | (w >> 6 & 0x1fc0000000000)
+             | (w >> 7 & 0xfe000000000000);
+#endif
+    }
+
+    ///Decodes byte by byte, for the end of a buffer
+    template<class U>
+    const char* decode_bytes(const char* p, const char* end, U& x)
+    {
+        const unsigned bits = 8 * sizeof(U);
+        U result = 0;
+        for(unsigned shift = 0; shift < bits && p != end; shift += 7)
+        {
+            unsigned char b = *p++;
+            U group = b & 0x7f;
+            //The last byte may only hold the bits that are left
+            if(shift + 7 > bits && (group >> (bits - shift)) != 0)
+                return nullptr;
+            result |= group << shift;
+            if(!(b & 0x80))
+            {
+                x = result;
+                return p;
+            }
+        }
+        return nullptr;
+    }
+
+    ///Decodes from an 8 byte load, at least 8 bytes must be left before end
+    template<class U>
+    const char* decode_word(const char* p, const char* end, U& x)
+    {
+        uint64_t w;
+        endian::read_little(p, w);
+        unsigned n;
+        uint64_t result;
+        //Branch for the short numbers, which are the most common ones. The CPU
+        //can predict the length and continue with the next number right away.
+        if(!(w & 0x80))
+        {
+            result = w & 0x7f;
+            n = 1;
+        }
+        else if(!(w & 0x8000))
+        {
+            result = (w & 0x7f) | (w >> 1 & 0x3f80);
+            n = 2;
+        }
+        else if((n = encoded_length(w)) != 0)
+            result = gather(w, n);
+        else
+        {
+            //Nine or ten bytes, which only 64 bit numbers can have.
+            //The tenth one holds the top bit.
+            if(sizeof(U) < 8 || end - p < 9)
+                return nullptr;
+            unsigned char b = p[8];
+            result = gather(w, 8) | uint64_t(b & 0x7f) << 56;
+            n = 9;
+            if(b & 0x80)
+            {
+                if(end - p < 10 || static_cast<unsigned char>(p[9]) > 1)
+                    return nullptr;
+                result |= uint64_t(p[9]) << 63;
+                n = 10;
+            }
+        }
+        if(sizeof(U) < 8 && (n > max_size32 || result > UINT32_MAX))
+            return nullptr;
+        x = static_cast<U>(result);
+        return p + n;
+    }
+
+    template<class T>
+    const char* decode_array_impl(const char* p, const char* end, T* arr, size_t n)
+    {
+        typedef std::make_unsigned_t<T> U;
+        size_t i = 0;
+        while(i < n)
+        {
+            U x;
+            if(end - p >= 8)
+            {
+                //Eight numbers of one byte each can be taken from a single load
+                uint64_t w;
+                endian::read_little(p, w);
+                if(!(w & high_bits) && n - i >= 8)
+                {
+                    for(unsigned k = 0; k < 8; ++k)
+                        arr[i + k] = zigzag_decode(static_cast<U>(w >> (8 * k) & 0xff));
+                    i += 8;
+                    p += 8;
+                    continue;
+                }
+                p = decode_word(p, end, x);
+            }
+            else
+                p = decode_bytes(p, end, x);
+            if(!p)
+                return nullptr;
+            arr[i++] = zigzag_decode(x);
+        }
+        return p;
+    }
+
+    template<class T>
+    char* encode_array_impl(char* dst, const T* arr, size_t n)
+    {
+        for(size_t i = 0; i < n; ++i)
+            dst = encode(dst, zigzag_encode(arr[i]));
+        return dst;
+    }
+
+    template<class U>
+    void read_impl(std::istream& is, U& x)
+    {
+        const size_t max_size = sizeof(U) == 4 ? max_size32 : max_size64;
+        char buf[max_size64];
+        size_t n = 0;
+        std::istream::int_type c;
+        do
+        {
+            c = is.get();
+            if(c == std::istream::traits_type::eof())
+                return; //get has set the failbit
+            buf[n++] = static_cast<char>(c);
+        } while((c & 0x80) && n < max_size);
+        if(!decode_bytes(buf, buf + n, x))
+            is.setstate(std::ios::failbit);
+    }
+
+    template<class U>
+    void write_impl(std::ostream& os, U x)
+    {
+        char buf[max_size64];
+        os.write(buf, encode(buf, x) - buf);
+    }
+}
+
+namespace detail
+{
+
+const char* decode_slow(const char* p, const char* end, uint32_t& x)
+{
+    return end - p < 8 ? decode_bytes(p, end, x) : decode_word(p, end, x);
+}
+
+const char* decode_slow(const char* p, const char* end, uint64_t& x)
+{
+    return end - p < 8 ? decode_bytes(p, end, x) : decode_word(p, end, x);
+}
+
+}
+
+const char* decode_array(const char* p, const char* end, int32_t* arr, size_t n) { return decode_array_impl(p, end, arr, n); }
+const char* decode_array(const char* p, const char* end, int64_t* arr, size_t n) { return decode_array_impl(p, end, arr, n); }
+
+char* encode_array(char* dst, const int32_t* arr, size_t n) { return encode_array_impl(dst, arr, n); }
+char* encode_array(char* dst, const int64_t* arr, size_t n) { return encode_array_impl(dst, arr, n); }
+
+void read(std::istream& is, uint32_t& x) { read_impl(is, x); }
+void read(std::istream& is, uint64_t& x) { read_impl(is, x); }
+
+void write(std::ostream& os, uint32_t x) { write_impl(os, x); }
+void write(std::ostream& os, uint64_t x) { write_impl(os, x); }
+
+}
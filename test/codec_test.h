@@ -0,0 +1,181 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cxxtest/TestSuite.h>
+#include "io/codec.h"
+#ifdef NBT_HAVE_LZ4
+#include "io/lz4stream.h"
+#endif
+#ifdef NBT_HAVE_ZSTD
+#include "io/zstdstream.h"
+#endif
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace nbt;
+
+class codec_test : public CxxTest::TestSuite
+{
+private:
+    std::string bigtest;
+    std::string large;
+
+public:
+    codec_test()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        bigtest.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if(bigtest.empty())
+            throw std::runtime_error("Could not read bigtest_uncompr file");
+
+        //Larger than the buffers and blocks, and not too compressible
+        uint32_t x = 1;
+        for(int i = 0; i < 200000; ++i)
+        {
+            x = x * 1103515245 + 12345;
+            large += (x >> 28) < 4 ? char(x >> 16) : 'a' + i % 7;
+        }
+    }
+
+    void test_registry()
+    {
+        TS_ASSERT(io::get_codec(io::compression::none));
+        TS_ASSERT_EQUALS(io::find_codec("none"), io::get_codec(io::compression::none));
+        TS_ASSERT(!io::get_codec(io::compression::custom));
+        TS_ASSERT(!io::find_codec("brotli"));
+#ifdef NBT_HAVE_ZLIB
+        TS_ASSERT_EQUALS(std::string(io::get_codec(io::compression::gzip)->name()), "gzip");
+        TS_ASSERT_EQUALS(io::find_codec("zlib")->scheme(), io::compression::zlib);
+#endif
+#ifdef NBT_HAVE_LZ4
+        TS_ASSERT_EQUALS(io::find_codec("lz4"), io::get_codec(io::compression::lz4));
+#else
+        TS_ASSERT(!io::get_codec(io::compression::lz4));
+#endif
+#ifdef NBT_HAVE_ZSTD
+        TS_ASSERT_EQUALS(io::find_codec("zstd")->scheme(), io::compression::custom);
+#else
+        TS_ASSERT(!io::find_codec("zstd"));
+#endif
+        for(const io::codec* c: io::available_codecs())
+            TS_ASSERT_EQUALS(io::find_codec(c->name()), c);
+    }
+
+    void test_roundtrip()
+    {
+        for(const io::codec* c: io::available_codecs())
+        {
+            for(const std::string* data: {&bigtest, &large})
+            {
+                //One-shot
+                std::string compressed, buf;
+                c->compress(data->data(), data->size(), compressed);
+                c->decompress(compressed.data(), compressed.size(), buf);
+                TS_ASSERT(buf == *data);
+                c->decompress(compressed.data(), compressed.size(), buf, data->size());
+                TS_ASSERT(buf == *data);
+
+                //Streams, which must be interchangeable with the one-shot functions
+                std::stringstream ss;
+                {
+                    auto os = c->open_ostream(ss, 1);
+                    os->exceptions(std::ios::failbit | std::ios::badbit);
+                    os->write(data->data(), 1000);
+                    os->write(data->data() + 1000, data->size() - 1000);
+                }
+                c->decompress(ss.str().data(), ss.str().size(), buf);
+                TS_ASSERT(buf == *data);
+
+                ss.str(compressed + "tail");
+                {
+                    auto is = c->open_istream(ss);
+                    buf.assign(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>());
+                }
+                if(c->scheme() == io::compression::none)
+                    continue;
+                TS_ASSERT(buf == *data);
+                //Reading stops at the end of the compressed data
+                std::string tail;
+                ss >> tail;
+                TS_ASSERT_EQUALS(tail, "tail");
+            }
+        }
+    }
+
+    void test_lz4()
+    {
+#ifdef NBT_HAVE_LZ4
+        //Checked against an independent implementation of XXH32
+        TS_ASSERT_EQUALS(lz4::checksum("", 0), 0xd3b42d8u);
+        TS_ASSERT_EQUALS(lz4::checksum("abc", 3), 0xd4cb222u);
+        TS_ASSERT_EQUALS(lz4::checksum("0123456789abcdefghijklmnopqrstuvwxyz", 36), 0x3c07c11u);
+
+        //Empty data consist only of the end mark
+        std::string out;
+        lz4::compress("", 0, out);
+        TS_ASSERT_EQUALS(out, std::string("LZ4Block\x16", 9) + std::string(12, '\0'));
+
+        //Incompressible blocks are stored
+        lz4::compress("abc", 3, out);
+        TS_ASSERT_EQUALS(out.size(), 21u + 3 + 21);
+        TS_ASSERT_EQUALS(out[8], '\x16');
+        TS_ASSERT_EQUALS(out.substr(21, 3), "abc");
+
+        std::string compressed, buf;
+        lz4::compress(large.data(), large.size(), compressed, 9, 1 << 12);
+        lz4::decompress(compressed.data(), compressed.size(), buf);
+        TS_ASSERT(buf == large);
+
+        TS_ASSERT_THROWS(lz4::decompress(compressed.data(), compressed.size() - 21, buf), io::codec_error);
+        TS_ASSERT_THROWS(lz4::decompress(compressed.data(), 10, buf), io::codec_error);
+        compressed[40] ^= 1;
+        TS_ASSERT_THROWS(lz4::decompress(compressed.data(), compressed.size(), buf), io::codec_error);
+        compressed[0] = 'X';
+        TS_ASSERT_THROWS(lz4::decompress(compressed.data(), compressed.size(), buf), io::codec_error);
+
+        TS_ASSERT_THROWS(lz4::compress("", 0, out, 13), io::codec_error);
+        TS_ASSERT_THROWS(lz4::compress("", 0, out, -1, 5000), io::codec_error);
+        std::ostringstream os;
+        TS_ASSERT_THROWS(lz4::olz4stream(os, -1, 512), io::codec_error);
+#endif
+    }
+
+    void test_zstd()
+    {
+#ifdef NBT_HAVE_ZSTD
+        std::string compressed, buf;
+        zstd::compress(large.data(), large.size(), compressed, 19);
+        TS_ASSERT_EQUALS(compressed.substr(0, 4), "\x28\xb5\x2f\xfd");
+        //Several frames are decompressed one after the other
+        std::string twice = compressed + compressed;
+        zstd::decompress(twice.data(), twice.size(), buf);
+        TS_ASSERT(buf == large + large);
+
+        TS_ASSERT_THROWS(zstd::decompress(compressed.data(), compressed.size() / 2, buf), io::codec_error);
+        TS_ASSERT_THROWS(zstd::decompress("abcdefgh", 8, buf), io::codec_error);
+        TS_ASSERT_THROWS(zstd::compress("", 0, buf, 23), io::codec_error);
+
+        //A stream truncated in the middle of the frame
+        std::istringstream is(compressed.substr(0, compressed.size() / 2));
+        zstd::izstdstream zs(is, 1024);
+        TS_ASSERT_THROWS(buf.assign(std::istreambuf_iterator<char>(zs), std::istreambuf_iterator<char>()), io::codec_error);
+#endif
+    }
+};
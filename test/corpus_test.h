@@ -0,0 +1,114 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cxxtest/TestSuite.h>
+#include "corpus.h"
+#include "io/imemstream.h"
+#include "io/omemstream.h"
+#include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include "nbt_tags.h"
+
+using namespace nbt;
+
+class corpus_test : public CxxTest::TestSuite
+{
+public:
+    void test_reproducible()
+    {
+        corpus::generator gen;
+        auto chunk = gen.chunk(3, -2);
+        TS_ASSERT(*chunk == *corpus::generator().chunk(3, -2));
+        TS_ASSERT(*chunk != *gen.chunk(2, -2));
+        TS_ASSERT(*gen.level() == *gen.level());
+        TS_ASSERT(*gen.item(5) == *gen.item(5));
+
+        corpus::options opt;
+        opt.seed = 1;
+        TS_ASSERT(*chunk != *corpus::generator(opt).chunk(3, -2));
+
+        //The same on every platform
+        TS_ASSERT_EQUALS(io::serialized_size(*gen.chunk(0, 0)), 167808u);
+        TS_ASSERT_EQUALS(io::serialized_size(*gen.level()), 4459u);
+    }
+
+    void test_chunk()
+    {
+        corpus::options opt;
+        opt.sections = 6;
+        opt.max_palette = 40;
+        opt.block_entities = 0;
+        opt.entities = 30;
+        auto chunk = corpus::generator(opt).chunk(1, 2);
+        TS_ASSERT(chunk->at("xPos") == tag_int(1));
+        TS_ASSERT(chunk->at("zPos") == tag_int(2));
+        TS_ASSERT_EQUALS(chunk->at("block_entities").as<tag_list>().size(), 0u);
+        TS_ASSERT(chunk->at("entities").as<tag_list>().size() > 10u);
+
+        const tag_list& sections = chunk->at("sections").as<tag_list>();
+        TS_ASSERT_EQUALS(sections.size(), 6u);
+        for(const value& sec: sections)
+        {
+            const tag_compound& states = sec.at("block_states").as<tag_compound>();
+            size_t palette = states.at("palette").as<tag_list>().size();
+            TS_ASSERT(palette >= 1 && palette <= 40);
+            if(palette == 1)
+            {
+                TS_ASSERT(!states.has_key("data"));
+                continue;
+            }
+            //The indices must be packed like in vanilla chunks
+            int bits = 4;
+            while((size_t(1) << bits) < palette)
+                ++bits;
+            size_t per_long = 64 / bits;
+            const auto& data = states.at("data").as<tag_long_array>().get();
+            TS_ASSERT_EQUALS(data.size(), (4096 + per_long - 1) / per_long);
+            for(size_t i = 0; i < 4096; ++i)
+                TS_ASSERT(((uint64_t(data[i / per_long]) >> (i % per_long * bits)) & ((1u << bits) - 1)) < palette);
+        }
+
+        io::omemstream os;
+        io::write_tag("", *chunk, os);
+        std::string data = os.str();
+        io::imemstream is(data);
+        TS_ASSERT(*io::read_compound(is).second == *chunk);
+    }
+
+    void test_item_nesting()
+    {
+        corpus::options opt;
+        opt.item_tag_chance = 1;
+        opt.nested_container_chance = 1;
+        opt.items_per_container = 27;
+        opt.max_item_depth = 3;
+        auto item = corpus::generator(opt).item(0);
+
+        //Every item is a full shulker box down to the maximum depth
+        const tag_compound* it = item.get();
+        for(int depth = 0; depth < 3; ++depth)
+        {
+            TS_ASSERT(it->at("id") == tag_string("minecraft:shulker_box"));
+            const tag_list& items = it->at("tag").at("BlockEntityTag").at("Items").as<tag_list>();
+            TS_ASSERT_EQUALS(items.size(), 27u);
+            it = &items.at(0).as<tag_compound>();
+        }
+        TS_ASSERT(it->at("tag").as<tag_compound>().has_key("Enchantments"));
+    }
+};
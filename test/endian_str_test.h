@@ -19,9 +19,12 @@
  */
 #include <cxxtest/TestSuite.h>
 #include "endian_str.h"
+#include "varint.h"
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 using namespace endian;
 
@@ -172,4 +175,203 @@ public:
 
         TS_ASSERT(str); //Check if stream has failed
     }
+
+    void test_memory()
+    {
+        const char data[] = {
+            '\x01', '\x02', '\x03', '\x04', '\x05', '\x06', '\x07', '\x08',
+            '\xAB', '\xCD', '\xEF', '\x01', '\x02', '\x03', '\x04', '\x05'
+        };
+
+        uint8_t u8;
+        uint16_t u16;
+        int32_t i32;
+        uint64_t u64;
+        float f;
+        double d;
+
+        read_little(data, u8);
+        TS_ASSERT_EQUALS(u8, 0x01);
+        read_little(data, u16);
+        TS_ASSERT_EQUALS(u16, 0x0201);
+        read(data, i32, little);
+        TS_ASSERT_EQUALS(i32, 0x04030201);
+        read_little(data, u64);
+        TS_ASSERT_EQUALS(u64, 0x0807060504030201u);
+
+        read_big(data, u16);
+        TS_ASSERT_EQUALS(u16, 0x0102);
+        read(data, i32, big);
+        TS_ASSERT_EQUALS(i32, 0x01020304);
+        read_big(data, u64);
+        TS_ASSERT_EQUALS(u64, 0x0102030405060708u);
+
+        read_big(data + 8, f);
+        TS_ASSERT_EQUALS(f, std::stof("-0xCDEF01p-63"));
+        read_big(data + 8, d);
+        TS_ASSERT_EQUALS(d, std::stod("-0x1DEF0102030405p-375"));
+    }
+
+    void test_array()
+    {
+        //Odd lengths to exercise both the vectorized loops and the remainders
+        std::vector<int16_t> shorts;
+        std::vector<int32_t> ints;
+        std::vector<int64_t> longs;
+        std::vector<double> doubles;
+        for(int i = 0; i < 37; ++i)
+        {
+            shorts.push_back(static_cast<int16_t>(0x0102 * i - 1000));
+            ints.push_back(0x01020304 * i - 100000);
+            longs.push_back(0x0102030405060708 * i - 10000000);
+            doubles.push_back(0.1 * i - 1.5);
+        }
+
+        std::stringstream str(std::ios::in | std::ios::out | std::ios::binary);
+        write_array(str, shorts.data(), shorts.size(), big);
+        write_array(str, ints.data(), ints.size(), little);
+        write_array(str, longs.data(), longs.size(), big);
+        write_array(str, doubles.data(), doubles.size(), little);
+        TS_ASSERT_EQUALS(str.str().size(), 37u * (2 + 4 + 8 + 8));
+
+        //Compare with the results of the single value functions
+        for(size_t i = 0; i < shorts.size(); ++i)
+        {
+            int16_t x;
+            read_big(str, x);
+            TS_ASSERT_EQUALS(x, shorts[i]);
+        }
+        for(size_t i = 0; i < ints.size(); ++i)
+        {
+            int32_t x;
+            read_little(str, x);
+            TS_ASSERT_EQUALS(x, ints[i]);
+        }
+
+        std::vector<int64_t> longs2(longs.size());
+        read_array(str, longs2.data(), longs2.size(), big);
+        TS_ASSERT(longs == longs2);
+        std::vector<double> doubles2(doubles.size());
+        read_array(str, doubles2.data(), doubles2.size(), little);
+        TS_ASSERT(doubles == doubles2);
+        TS_ASSERT(str);
+
+        //In place conversion
+        std::vector<int32_t> conv = ints;
+        convert_array(conv.data(), conv.size(), big);
+        convert_array(conv.data(), conv.size(), big);
+        TS_ASSERT(conv == ints);
+        const std::string raw{0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+        memcpy(conv.data(), raw.data(), 8);
+        convert_array(conv.data(), 2, big);
+        TS_ASSERT_EQUALS(conv[0], 0x01020304);
+        TS_ASSERT_EQUALS(conv[1], 0x05060708);
+    }
+    void test_varint()
+    {
+        char buf[varint::max_size64];
+        TS_ASSERT_EQUALS(varint::encode(buf, uint32_t(300)) - buf, 2);
+        TS_ASSERT_EQUALS(std::string(buf, 2), "\xAC\x02");
+        TS_ASSERT_EQUALS(varint::encode(buf, UINT32_MAX) - buf, 5);
+        TS_ASSERT_EQUALS(std::string(buf, 5), "\xFF\xFF\xFF\xFF\x0F");
+        TS_ASSERT_EQUALS(varint::encode(buf, UINT64_MAX) - buf, 10);
+        TS_ASSERT_EQUALS(varint::size(127), 1u);
+        TS_ASSERT_EQUALS(varint::size(128), 2u);
+        TS_ASSERT_EQUALS(varint::size(UINT64_MAX), 10u);
+
+        TS_ASSERT_EQUALS(varint::zigzag_encode(int32_t(0)), 0u);
+        TS_ASSERT_EQUALS(varint::zigzag_encode(int32_t(-1)), 1u);
+        TS_ASSERT_EQUALS(varint::zigzag_encode(int32_t(1)), 2u);
+        TS_ASSERT_EQUALS(varint::zigzag_encode(int32_t(INT32_MAX)), 0xFFFFFFFEu);
+        TS_ASSERT_EQUALS(varint::zigzag_encode(int32_t(INT32_MIN)), 0xFFFFFFFFu);
+        TS_ASSERT_EQUALS(varint::zigzag_encode(int64_t(INT64_MIN)), UINT64_MAX);
+        TS_ASSERT_EQUALS(varint::zigzag_decode(uint32_t(3)), -2);
+        TS_ASSERT_EQUALS(varint::zigzag_decode(uint32_t(0xFFFFFFFF)), INT32_MIN);
+        TS_ASSERT_EQUALS(varint::zigzag_decode(uint64_t(0xFFFFFFFFFFFFFFFE)), INT64_MAX);
+
+        //The boundaries between the encoded lengths, decoded with and without
+        //8 bytes of room for the fast path
+        for(int bits: {0, 7, 14, 21, 28, 32, 35, 49, 56, 63, 64})
+            for(int delta: {-1, 0})
+            {
+                uint64_t x = (bits == 64 ? 0 : uint64_t(1) << bits) + delta;
+                char data[varint::max_size64 + 8] = {};
+                size_t n = varint::encode(data, x) - data;
+                TS_ASSERT_EQUALS(n, varint::size(x));
+
+                uint64_t y = 0;
+                TS_ASSERT_EQUALS(varint::decode(data, data + sizeof(data), y), data + n);
+                TS_ASSERT_EQUALS(y, x);
+                y = 0;
+                TS_ASSERT_EQUALS(varint::decode(data, data + n, y), data + n);
+                TS_ASSERT_EQUALS(y, x);
+                TS_ASSERT(!varint::decode(data, data + n - 1, y));
+
+                uint32_t z = 0;
+                if(x <= UINT32_MAX)
+                {
+                    TS_ASSERT_EQUALS(varint::decode(data, data + sizeof(data), z), data + n);
+                    TS_ASSERT_EQUALS(z, x);
+                    TS_ASSERT_EQUALS(varint::decode(data, data + n, z), data + n);
+                }
+                else
+                {
+                    TS_ASSERT(!varint::decode(data, data + sizeof(data), z));
+                    TS_ASSERT(!varint::decode(data, data + n, z));
+                }
+            }
+
+        //Encodings that are too long or overflow
+        uint32_t u32;
+        uint64_t u64;
+        for(std::string pad: {"", "........"})
+        {
+            std::string str = "\x80\x80\x80\x80\x80\x01" + pad;
+            TS_ASSERT(!varint::decode(str.data(), str.data() + str.size(), u32));
+            str = "\xFF\xFF\xFF\xFF\x1F" + pad;
+            TS_ASSERT(!varint::decode(str.data(), str.data() + str.size(), u32));
+            str = std::string(10, '\x80') + "\x01" + pad;
+            TS_ASSERT(!varint::decode(str.data(), str.data() + str.size(), u64));
+            str = std::string(9, '\xFF') + "\x02" + pad;
+            TS_ASSERT(!varint::decode(str.data(), str.data() + str.size(), u64));
+        }
+
+        //Arrays with runs of small numbers in between large ones
+        std::vector<int32_t> ints;
+        std::vector<int64_t> longs;
+        for(int i = 0; i < 100; ++i)
+        {
+            ints.push_back(i % 10 == 9 ? INT32_MIN + i : i - 50);
+            longs.push_back(i % 7 == 6 ? INT64_MAX - i : -i);
+        }
+        std::string enc(ints.size() * varint::max_size32, '\0');
+        char* end = varint::encode_array(&enc[0], ints.data(), ints.size());
+        std::vector<int32_t> ints2(ints.size());
+        TS_ASSERT_EQUALS(varint::decode_array(enc.data(), end, ints2.data(), ints2.size()), end);
+        TS_ASSERT(ints == ints2);
+        TS_ASSERT(!varint::decode_array(enc.data(), end - 1, ints2.data(), ints2.size()));
+
+        enc.assign(longs.size() * varint::max_size64, '\0');
+        end = varint::encode_array(&enc[0], longs.data(), longs.size());
+        std::vector<int64_t> longs2(longs.size());
+        TS_ASSERT_EQUALS(varint::decode_array(enc.data(), end, longs2.data(), longs2.size()), end);
+        TS_ASSERT(longs == longs2);
+
+        //Streams
+        std::stringstream str(std::ios::in | std::ios::out | std::ios::binary);
+        varint::write(str, uint32_t(300));
+        varint::write(str, UINT64_MAX);
+        TS_ASSERT_EQUALS(str.str().size(), 12u);
+        varint::read(str, u32);
+        TS_ASSERT_EQUALS(u32, 300u);
+        varint::read(str, u64);
+        TS_ASSERT_EQUALS(u64, UINT64_MAX);
+        TS_ASSERT(str);
+        varint::read(str, u32);
+        TS_ASSERT(!str);
+
+        std::istringstream bad("\xFF\xFF\xFF\xFF\x1F");
+        varint::read(bad, u32);
+        TS_ASSERT(!bad);
+    }
 };
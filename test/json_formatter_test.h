@@ -0,0 +1,209 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cxxtest/TestSuite.h>
+#include "text/json_formatter.h"
+#include "nbt_tags.h"
+#include <limits>
+#include <locale>
+#include <sstream>
+
+using namespace nbt;
+
+class json_formatter_test : public CxxTest::TestSuite
+{
+private:
+    static std::string print(const tag& t, const text::json_options& opts = text::json_options())
+    {
+        std::ostringstream os;
+        text::json_formatter(opts).print(os, t);
+        return os.str();
+    }
+
+    static text::json_options strict(text::json_types types = text::json_types::plain, bool pretty = false)
+    {
+        text::json_options opts;
+        opts.syntax = text::json_syntax::strict;
+        opts.types = types;
+        opts.pretty = pretty;
+        return opts;
+    }
+
+public:
+    void test_numbers()
+    {
+        TS_ASSERT_EQUALS(print(tag_byte(-128)), "-128b");
+        TS_ASSERT_EQUALS(print(tag_short(-32768)), "-32768s");
+        TS_ASSERT_EQUALS(print(tag_int(-2147483648LL)), "-2147483648");
+        TS_ASSERT_EQUALS(print(tag_long(std::numeric_limits<int64_t>::min())), "-9223372036854775808l");
+        //Shortest representations that read back exactly
+        TS_ASSERT_EQUALS(print(tag_float(1.618034f)), "1.618034f");
+        TS_ASSERT_EQUALS(print(tag_float(0.1f)), "0.1f");
+        TS_ASSERT_EQUALS(print(tag_float(6.62607e-34f)), "6.62607e-34f");
+        TS_ASSERT_EQUALS(print(tag_double(0.1)), "0.1d");
+        TS_ASSERT_EQUALS(print(tag_double(3.141592653589793)), "3.141592653589793d");
+        TS_ASSERT_EQUALS(print(tag_double(1e100)), "1e+100d");
+        TS_ASSERT_EQUALS(print(tag_double(-std::numeric_limits<double>::infinity())), "-Infinityd");
+        TS_ASSERT_EQUALS(print(tag_float(std::numeric_limits<float>::quiet_NaN())), "NaNf");
+        TS_ASSERT_EQUALS(print(tag_long_array{1, -2}), "[1l, -2l]");
+        TS_ASSERT_EQUALS(print(tag_byte_array{1, 2, 3}), "[3 bytes]");
+    }
+
+    void test_stream_state()
+    {
+        //Neither the stream's flags nor its locale change the output
+        struct grouping : std::numpunct<char>
+        {
+            char do_thousands_sep() const override { return ','; }
+            std::string do_grouping() const override { return "\3"; }
+            char do_decimal_point() const override { return '#'; }
+        };
+        std::ostringstream os;
+        os.imbue(std::locale(os.getloc(), new grouping));
+        os << std::hex << std::fixed;
+        text::json_formatter().print(os, tag_list{1234567.5, 0.25});
+        TS_ASSERT_EQUALS(os.str(), "[1234567.5d, 0.25d]");
+        TS_ASSERT_EQUALS(print(tag_int(1234567)), "1234567");
+    }
+
+    void test_layout()
+    {
+        tag_compound comp{
+            {"list", tag_list::of<tag_compound>({{{"a", "x"}}, {}})},
+            {"ints", tag_int_array{1, 2}}
+        };
+        //Compounds are sorted by key
+        TS_ASSERT_EQUALS(print(comp),
+            "{\n"
+            "  ints: [1, 2],\n"
+            "  list: [\n"
+            "    {\n"
+            "      a: \"x\"\n"
+            "    },\n"
+            "    {}\n"
+            "  ]\n"
+            "}");
+    }
+
+    void test_large_output()
+    {
+        //Larger than the internal buffer, with strings longer than it
+        tag_list list;
+        std::string expected = "[";
+        for(int i = 0; i < 2000; ++i)
+        {
+            std::string str(i % 7 == 0 ? 20000 : i % 50, 'a' + i % 26);
+            list.push_back(str);
+            expected += "\"" + str + "\"";
+            if(i != 1999)
+                expected += ", ";
+        }
+        expected += "]";
+        TS_ASSERT(print(list) == expected);
+    }
+
+    void test_compact()
+    {
+        text::json_options opts;
+        opts.pretty = false;
+        TS_ASSERT_EQUALS(print(tag_compound{{"a", tag_list{1, 2}}, {"b", tag_compound()}}, opts),
+            "{a:[1,2],b:{}}");
+
+        //Unboxed lists are formatted in place
+        tag_list list{3, 4};
+        std::vector<int32_t>& vec = list.primitives<int32_t>();
+        TS_ASSERT_EQUALS(print(list, opts), "[3,4]");
+        vec[0] = 5;
+        TS_ASSERT((list == tag_list{5, 4}));
+    }
+
+    void test_strict_plain()
+    {
+        tag_compound comp{
+            {"byte", int8_t(-1)},
+            {"long", int64_t(1) << 60},
+            {"float", 0.5f},
+            {"nan", std::numeric_limits<double>::quiet_NaN()},
+            {"bytes", tag_byte_array{1, -2}},
+            {"longs", tag_long_array{3}},
+            {"list", tag_list::of<tag_compound>({{{"s", "x"}}, {}})},
+            {"empty", tag_list()},
+            {"null", nullptr}
+        };
+        TS_ASSERT_EQUALS(print(comp, strict()),
+            "{\"byte\":-1,\"bytes\":[1,-2],\"empty\":[],\"float\":0.5,"
+            "\"list\":[{\"s\":\"x\"},{}],\"long\":1152921504606846976,\"longs\":[3],"
+            "\"nan\":null,\"null\":null}");
+
+        TS_ASSERT_EQUALS(print(tag_compound{{"a", tag_list::of<tag_list>({{1, 2}})}, {"b", "c"}},
+                               strict(text::json_types::plain, true)),
+            "{\n"
+            "  \"a\": [\n"
+            "    [1, 2]\n"
+            "  ],\n"
+            "  \"b\": \"c\"\n"
+            "}");
+    }
+
+    void test_escaping()
+    {
+        TS_ASSERT_EQUALS(print(tag_string("say \"hi\"\\\n\t\x01\x1f\x7f \xc3\xa4"), strict()),
+            "\"say \\\"hi\\\"\\\\\\n\\t\\u0001\\u001f\x7f \xc3\xa4\"");
+        TS_ASSERT_EQUALS(print(tag_compound{{"key\"", 1}}, strict()), "{\"key\\\"\":1}");
+
+        //Characters to escape at every position of longer strings
+        for(size_t len: {1, 15, 16, 17, 31, 32, 33, 100})
+        {
+            for(size_t i = 0; i < len; ++i)
+            {
+                std::string str(len, 'a');
+                str[i] = '\n';
+                std::string expected = "\"" + std::string(i, 'a') + "\\n" + std::string(len - i - 1, 'a') + "\"";
+                TS_ASSERT_EQUALS(print(tag_string(str), strict()), expected);
+            }
+        }
+    }
+
+    void test_strict_typed()
+    {
+        tag_compound comp{
+            {"i", 1},
+            {"f", -std::numeric_limits<float>::infinity()},
+            {"l", tag_list{int16_t(2)}},
+            {"e", tag_list::of<tag_string>({})},
+            {"u", tag_list()},
+            {"a", tag_int_array{3}}
+        };
+        TS_ASSERT_EQUALS(print(comp, strict(text::json_types::typed)),
+            "{\"type\":\"compound\",\"value\":{"
+            "\"a\":{\"type\":\"int_array\",\"value\":[3]},"
+            "\"e\":{\"type\":\"list\",\"element_type\":\"string\",\"value\":[]},"
+            "\"f\":{\"type\":\"float\",\"value\":\"-Infinity\"},"
+            "\"i\":{\"type\":\"int\",\"value\":1},"
+            "\"l\":{\"type\":\"list\",\"element_type\":\"short\",\"value\":[{\"type\":\"short\",\"value\":2}]},"
+            "\"u\":{\"type\":\"list\",\"value\":[]}"
+            "}}");
+
+        TS_ASSERT_EQUALS(print(tag_compound{{"d", 0.25}}, strict(text::json_types::typed, true)),
+            "{\"type\": \"compound\", \"value\": {\n"
+            "  \"d\": {\"type\": \"double\", \"value\": 0.25}\n"
+            "}}");
+    }
+};
+
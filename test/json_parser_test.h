@@ -0,0 +1,180 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cxxtest/TestSuite.h>
+#include "text/json_parser.h"
+#include "text/json_formatter.h"
+#include "corpus.h"
+#include "nbt_tags.h"
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+using namespace nbt;
+using text::parse_error;
+
+class json_parser_test : public CxxTest::TestSuite
+{
+private:
+    text::json_parser plain;
+    text::json_parser typed{text::json_types::typed};
+
+    static std::string format(const tag& t, bool pretty)
+    {
+        text::json_options opts;
+        opts.syntax = text::json_syntax::strict;
+        opts.types = text::json_types::typed;
+        opts.pretty = pretty;
+        std::ostringstream os;
+        text::json_formatter(opts).print(os, t);
+        return os.str();
+    }
+
+    ///Returns the offset of the parse_error that parsing the string throws
+    static size_t error_offset(const text::json_parser& parser, const std::string& str)
+    {
+        try
+        {
+            parser.parse(str);
+        }
+        catch(parse_error& ex)
+        {
+            return ex.offset();
+        }
+        TS_FAIL("Expected a parse_error");
+        return -1;
+    }
+
+public:
+    void test_plain()
+    {
+        TS_ASSERT(*plain.parse("42") == tag_int(42));
+        TS_ASSERT(*plain.parse("-2147483649") == tag_long(-2147483649LL));
+        TS_ASSERT(*plain.parse("1.5e1") == tag_double(15));
+        TS_ASSERT(*plain.parse("18446744073709551616") == tag_double(18446744073709551616.0));
+        TS_ASSERT(*plain.parse(" true ") == tag_byte(1));
+        TS_ASSERT(*plain.parse(R"("a\"\\\/\nä😀")")
+            == tag_string("a\"\\/\n\xc3\xa4\xf0\x9f\x98\x80"));
+
+        auto comp = plain.parse_compound(R"({"a": {"b": [], "c": null}, "d": ["x", "y"]})");
+        TS_ASSERT(*comp == (tag_compound{
+            {"a", tag_compound{{"b", tag_list()}, {"c", nullptr}}},
+            {"d", tag_list{"x", "y"}}
+        }));
+        TS_ASSERT(*plain.parse("[[1], [{}]]") == (tag_list{tag_list{1}, tag_list{tag_compound()}}));
+        TS_ASSERT_THROWS(plain.parse_compound("[]"), parse_error);
+    }
+
+    void test_plain_numbers()
+    {
+        TS_ASSERT(*plain.parse("[1, 2]") == (tag_list{1, 2}));
+        TS_ASSERT(*plain.parse("[1, 3000000000]") == (tag_list{int64_t(1), int64_t(3000000000)}));
+        TS_ASSERT(*plain.parse("[1, 2.5, 3]") == (tag_list{1.0, 2.5, 3.0}));
+        TS_ASSERT(*plain.parse("[true, false]") == (tag_list{int8_t(1), int8_t(0)}));
+
+        //Numbers out of range overflow to infinity and underflow to zero
+        const double inf = std::numeric_limits<double>::infinity();
+        TS_ASSERT(*plain.parse("1.5e400") == tag_double(inf));
+        TS_ASSERT(*plain.parse("-0.01e311") == tag_double(-inf));
+        TS_ASSERT(*plain.parse("1000e-330") == tag_double(0));
+        TS_ASSERT(std::signbit(plain.parse("-1e-400")->as<tag_double>().get()));
+    }
+
+    void test_typed()
+    {
+        auto t = typed.parse(R"({"value": [{"type": "short", "value": 7}], "element_type": "short", "type": "list"})");
+        TS_ASSERT(*t == tag_list{int16_t(7)});
+        TS_ASSERT(*typed.parse(R"({"type": "list", "element_type": "byte_array", "value": []})")
+            == tag_list(tag_type::Byte_Array));
+        TS_ASSERT(*typed.parse(R"({"type": "float", "value": "-Infinity"})")
+            == tag_float(-std::numeric_limits<float>::infinity()));
+        TS_ASSERT(*typed.parse(R"({"type": "float", "value": 1})") == tag_float(1));
+        TS_ASSERT(*typed.parse(R"({"type": "compound", "value": {"n": null}})")
+            == (tag_compound{{"n", nullptr}}));
+    }
+
+    void test_round_trip()
+    {
+        tag_compound comp{
+            {"byte", tag_byte(-128)},
+            {"short", tag_short(-32768)},
+            {"int", tag_int(-2147483648LL)},
+            {"long", tag_long(std::numeric_limits<int64_t>::min())},
+            {"float", 6.626070e-34f},
+            {"float max", std::numeric_limits<float>::max()},
+            {"double", 1.749899444387479e-193},
+            {"infinity", -std::numeric_limits<double>::infinity()},
+            {"string", "Hello World! äöüß \"\\\n\t\x01"},
+            {"byte array", tag_byte_array{12, -13, 14}},
+            {"int array", tag_int_array{0x0badc0de, -0x0dedbeef}},
+            {"long array", tag_long_array{0x0badc0de0badc0de, -0x0dedbeef0dedbeef}},
+            {"list (empty)", tag_list::of<tag_byte_array>({})},
+            {"list (float)", tag_list{2.0f, 1.0f, 0.5f, 0.1f}},
+            {"list (list)", tag_list::of<tag_list>({
+                {},
+                {4, 5, 6},
+                {tag_compound{{"egg", "ham"}}, tag_compound{{"foo", "bar"}}}
+            })},
+            {"compound (empty)", tag_compound()},
+            {"key with\nnewline \"and\" ä", tag_compound{{"", ""}}},
+            {"null", nullptr}
+        };
+        TS_ASSERT(*typed.parse_compound(format(comp, false)) == comp);
+        TS_ASSERT(*typed.parse_compound(format(comp, true)) == comp);
+
+        corpus::generator gen;
+        auto chunk = gen.chunk(0, 0);
+        TS_ASSERT(*typed.parse_compound(format(*chunk, false)) == *chunk);
+        auto level = gen.level();
+        TS_ASSERT(*typed.parse_compound(format(*level, true)) == *level);
+    }
+
+    void test_errors()
+    {
+        TS_ASSERT_EQUALS(error_offset(plain, ""), 0u);
+        TS_ASSERT_EQUALS(error_offset(plain, "null"), 0u);
+        TS_ASSERT_EQUALS(error_offset(plain, "{\"a\" 1}"), 5u);
+        TS_ASSERT_EQUALS(error_offset(plain, "{a: 1}"), 1u);
+        TS_ASSERT_EQUALS(error_offset(plain, "[1, 2,]"), 6u);
+        TS_ASSERT_EQUALS(error_offset(plain, "[1, \"a\"]"), 4u);
+        TS_ASSERT_EQUALS(error_offset(plain, "[\"a\", 1]"), 6u);
+        TS_ASSERT_EQUALS(error_offset(plain, "[null]"), 1u);
+        TS_ASSERT_EQUALS(error_offset(plain, "01"), 1u);
+        TS_ASSERT_EQUALS(error_offset(plain, "1."), 2u);
+        TS_ASSERT_EQUALS(error_offset(plain, "\"a\nb\""), 2u);
+        TS_ASSERT_EQUALS(error_offset(plain, "\"abc"), 0u);
+        TS_ASSERT_EQUALS(error_offset(plain, "tru"), 0u);
+        TS_ASSERT_EQUALS(error_offset(plain, std::string(600, '[')), 512u);
+
+        TS_ASSERT_EQUALS(error_offset(typed, "42"), 0u);
+        std::string deep;
+        for(int i = 0; i < 600; ++i)
+            deep += R"({"type": "list", "value": [)";
+        TS_ASSERT_EQUALS(error_offset(typed, deep), 512 * 27u);
+        TS_ASSERT_EQUALS(error_offset(typed, R"({"type": "byte", "value": 128})"), 26u);
+        TS_ASSERT_EQUALS(error_offset(typed, R"({"type": "bool", "value": 1})"), 9u);
+        TS_ASSERT_EQUALS(error_offset(typed, R"({"type": "int"})"), 0u);
+        TS_ASSERT_EQUALS(error_offset(typed, R"({"value": 1})"), 0u);
+        TS_ASSERT_EQUALS(error_offset(typed, R"({"type": "int", "value": 1, "x": 2})"), 28u);
+        TS_ASSERT_EQUALS(error_offset(typed,
+            R"({"type": "list", "value": [{"type": "int", "value": 1}, {"type": "long", "value": 1}]})"), 56u);
+        TS_ASSERT_EQUALS(error_offset(typed,
+            R"({"type": "list", "element_type": "long", "value": [{"type": "int", "value": 1}]})"), 0u);
+    }
+};
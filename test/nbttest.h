@@ -18,11 +18,13 @@
  * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <cxxtest/TestSuite.h>
+#include "flat_map.h"
 #include "nbt_tags.h"
 #include "nbt_visitor.h"
 #include <algorithm>
 #include <set>
 #include <stdexcept>
+#include <string_view>
 
 using namespace nbt;
 
@@ -190,7 +192,7 @@ public:
         std::set<std::string> keys{"bar", "baz", "foo", "list", "quux"};
         TS_ASSERT_EQUALS(comp2.size(), keys.size());
         unsigned int i = 0;
-        for(const std::pair<const std::string, value>& val: comp2)
+        for(const auto& val: comp2) //value_type depends on NBT_FLAT_COMPOUND
         {
             TS_ASSERT_LESS_THAN(i, comp2.size());
             TS_ASSERT(keys.count(val.first));
@@ -226,6 +228,55 @@ public:
             {"def", tag_byte(4)},
             {"ghi", tag_string("world")}
         }));
+
+        //Test lookup with string_view keys
+        std::string_view key = std::string_view("ghijkl").substr(0, 3);
+        TS_ASSERT(comp.has_key(key, tag_type::String));
+        TS_ASSERT_EQUALS(static_cast<std::string>(comp.at(key)), "world");
+        TS_ASSERT_THROWS(comp.at(std::string_view("gh")), std::out_of_range);
+        comp[std::string_view("jklmno", 3)] = int8_t(7);
+        TS_ASSERT(comp.at("jkl") == tag_byte(7));
+        TS_ASSERT(comp.erase(key));
+        TS_ASSERT_EQUALS(comp.size(), 3u);
+    }
+
+    void test_flat_map()
+    {
+        detail::flat_map<std::string, int> map;
+        TS_ASSERT(map.emplace("foo", 1).second);
+        TS_ASSERT(map.emplace("bar", 2).second);
+        TS_ASSERT(map.emplace("quux", 3).second);
+        TS_ASSERT(!map.emplace("foo", 4).second);
+        map["baz"] = 5;
+        TS_ASSERT_EQUALS(map.size(), 4u);
+        TS_ASSERT_EQUALS(map.at("foo"), 1);
+        TS_ASSERT_THROWS(map.at("egg"), std::out_of_range);
+        TS_ASSERT(map.find("egg") == map.end());
+
+        //Iteration order is sorted by key, like std::map
+        std::vector<std::string> keys;
+        for(const auto& kv: map)
+            keys.push_back(kv.first);
+        TS_ASSERT((keys == std::vector<std::string>{"bar", "baz", "foo", "quux"}));
+
+        TS_ASSERT_EQUALS(map.erase("bar"), 1u);
+        TS_ASSERT_EQUALS(map.erase("bar"), 0u);
+        TS_ASSERT_EQUALS(map.begin()->first, "baz");
+
+        //Bulk assignment, the first one of duplicate keys wins
+        map.assign({{"b", 1}, {"c", 2}, {"a", 3}, {"b", 4}, {"a", 5}});
+        TS_ASSERT_EQUALS(map.size(), 3u);
+        TS_ASSERT_EQUALS(map.at("a"), 3);
+        TS_ASSERT_EQUALS(map.at("b"), 1);
+        TS_ASSERT_EQUALS(map.begin()->first, "a");
+
+        detail::flat_map<std::string, int> map2;
+        map2.emplace("c", 2);
+        map2.emplace("b", 1);
+        map2.emplace("a", 3);
+        TS_ASSERT(map == map2);
+        map2["a"] = 4;
+        TS_ASSERT(map != map2);
     }
 
     void test_value()
@@ -373,6 +424,75 @@ public:
         TS_ASSERT_EQUALS((tag_list{2, 3, 5, 7}).el_type(), tag_type::Int);
     }
 
+    void test_tag_list_primitives()
+    {
+        tag_list list{1.5, -2.0, 4.25};
+        TS_ASSERT((list.primitives<double>() == std::vector<double>{1.5, -2.0, 4.25}));
+        TS_ASSERT_THROWS(list.primitives<float>(), std::bad_cast);
+
+        //Unboxed and boxed lists compare equal
+        TS_ASSERT(list == tag_list::of<tag_double>({1.5, -2.0, 4.25}));
+        TS_ASSERT(tag_list::of<tag_double>({1.5, -2.0, 4.25}) == list);
+        TS_ASSERT(list != tag_list::of<tag_double>({1.5, -2.0}));
+
+        list.push_back(8.0);
+        TS_ASSERT_EQUALS(list.size(), 4u);
+        list.pop_back();
+        TS_ASSERT_EQUALS(list.size(), 3u);
+
+        //Access as values boxes the elements, primitives() unboxes them
+        list[1] = 3.0;
+        TS_ASSERT_EQUALS(static_cast<double>(list.at(1)), 3.0);
+        list.primitives<double>().push_back(5.0);
+        TS_ASSERT_EQUALS(list.size(), 4u);
+        TS_ASSERT((list == tag_list{1.5, 3.0, 4.25, 5.0}));
+
+        //visit_elements reads the elements as they are stored, so references stay valid
+        std::vector<double>& vec = list.primitives<double>();
+        auto sum = [](const auto& elements) {
+            double s = 0;
+            for(const auto& x: elements)
+                s += static_cast<double>(x);
+            return s;
+        };
+        TS_ASSERT_EQUALS(static_cast<const tag_list&>(list).visit_elements(sum), 13.75);
+        vec[0] = 2.0;
+        value& first = list[0];
+        TS_ASSERT_EQUALS(static_cast<const tag_list&>(list).visit_elements(sum), 14.25);
+        first = 1.5;
+        TS_ASSERT((list == tag_list{1.5, 3.0, 4.25, 5.0}));
+
+        //Const access returns boxed copies and leaves the unboxed elements in place
+        tag_list ints{1, 2, 3};
+        const tag_list& cints = ints;
+        const value& one = cints[0];
+        const std::vector<int32_t>& unboxed = cints.primitives<int32_t>();
+        TS_ASSERT_EQUALS(static_cast<int32_t>(one), 1);
+        TS_ASSERT_EQUALS(&cints.at(0), &one);
+        TS_ASSERT_EQUALS(&*cints.begin(), &one);
+        TS_ASSERT_EQUALS(&cints.primitives<int32_t>(), &unboxed);
+        TS_ASSERT_THROWS(cints.primitives<int64_t>(), std::bad_cast);
+        //Boxing the elements for modification keeps the copies
+        ints[1] = 5;
+        TS_ASSERT_EQUALS(&ints[0], &one);
+        TS_ASSERT_THROWS(cints.primitives<int32_t>(), std::logic_error);
+        //Copies and changes discard the boxed copies
+        ints.primitives<int32_t>();
+        TS_ASSERT_EQUALS(static_cast<int32_t>(cints[2]), 3);
+        tag_list copy = cints;
+        TS_ASSERT(copy == ints);
+        ints.push_back(4);
+        TS_ASSERT_EQUALS(cints.size(), 4u);
+        TS_ASSERT_EQUALS(static_cast<int32_t>(cints.at(3)), 4);
+        TS_ASSERT_EQUALS(copy.size(), 3u);
+
+        tag_list empty;
+        TS_ASSERT(static_cast<const tag_list&>(empty).primitives<int32_t>().empty());
+        empty.primitives<int32_t>().push_back(17);
+        TS_ASSERT_EQUALS(empty.el_type(), tag_type::Int);
+        TS_ASSERT(empty == tag_list::of<tag_int>({17}));
+    }
+
     void test_tag_byte_array()
     {
         std::vector<int8_t> vec{1, 2, 127, -128};
@@ -19,13 +19,20 @@
  */
 #include <cxxtest/TestSuite.h>
 #include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include "io/imemstream.h"
+#include "io/level_dat.h"
+#include "io/path_query.h"
 #ifdef NBT_HAVE_ZLIB
 #include "io/izlibstream.h"
 #endif
 #include "nbt_tags.h"
+#include "tag_arena.h"
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <sstream>
+#include <thread>
 
 using namespace nbt;
 
@@ -104,6 +111,65 @@ public:
         TS_ASSERT(!is);
     }
 
+    void test_stream_reader_network()
+    {
+        const std::string input{
+            '\x05', //Int -3 as zigzag varint
+            '\x80', '\x01', //Int 64
+            '\xFF', '\xFF', '\xFF', '\xFF', '\x0F', //Int INT32_MIN
+            '\xFE', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\x01', //Long INT64_MAX
+            0x02, 0x01, //Short 258 in Little Endian
+            0x01, 0x02, 0x03, //Ints -1, 1, -2
+
+            0x06, //String length as varint (not zigzag encoded)
+            'f', 'o', 'o', 'b', 'a', 'r',
+
+            '\x80', '\x80', 0x04 //String length (too large for NBT)
+        };
+
+        //Through the std::istream interface and directly from memory
+        std::istringstream sstr(input);
+        io::imemstream mstr(input);
+        for(std::istream* is: {static_cast<std::istream*>(&sstr), static_cast<std::istream*>(&mstr)})
+        {
+            nbt::io::stream_reader reader(*is, endian::network);
+            TS_ASSERT_EQUALS(reader.get_endian(), endian::network);
+
+            int32_t i;
+            int64_t l;
+            int16_t s;
+            reader.read_num(i);
+            TS_ASSERT_EQUALS(i, -3);
+            reader.read_num(i);
+            TS_ASSERT_EQUALS(i, 64);
+            reader.read_num(i);
+            TS_ASSERT_EQUALS(i, INT32_MIN);
+            reader.read_num(l);
+            TS_ASSERT_EQUALS(l, INT64_MAX);
+            reader.read_num(s);
+            TS_ASSERT_EQUALS(s, 258);
+            int32_t arr[3];
+            reader.read_array(arr, 3);
+            TS_ASSERT_EQUALS(arr[0], -1);
+            TS_ASSERT_EQUALS(arr[1], 1);
+            TS_ASSERT_EQUALS(arr[2], -2);
+
+            TS_ASSERT_EQUALS(reader.read_string(), "foobar");
+            TS_ASSERT(*is);
+            TS_ASSERT_THROWS(reader.read_string(), io::input_error);
+            TS_ASSERT(!*is);
+        }
+
+        //Varints that are too long
+        for(const std::string& bad: {std::string("\x80\x80\x80\x80\x80\x01"), std::string("\x80\x80\x80\x80\x80\x01....")})
+        {
+            io::imemstream is(bad);
+            int32_t i;
+            nbt::io::stream_reader(is, endian::network).read_num(i);
+            TS_ASSERT(!is);
+        }
+    }
+
     //Tests if comp equals an extended variant of Notch's bigtest NBT
     void verify_bigtest_structure(const tag_compound& comp)
     {
@@ -220,6 +286,409 @@ public:
             "the case where the file consists of something else than tag_compound"));
     }
 
+    void test_read_memory()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        TS_ASSERT(file);
+
+        //Big endian
+        {
+            io::imemstream is(data);
+            auto pair = nbt::io::read_compound(is);
+            TS_ASSERT(is);
+            TS_ASSERT_EQUALS(pair.first, "Level");
+            verify_bigtest_structure(*pair.second);
+            TS_ASSERT_EQUALS(is.peek(), EOF);
+
+            //Rewind and read again
+            is.clear();
+            TS_ASSERT(is.seekg(0));
+            TS_ASSERT_EQUALS(is.tellg(), 0);
+            pair = nbt::io::read_compound(is);
+            TS_ASSERT_EQUALS(pair.first, "Level");
+            verify_bigtest_structure(*pair.second);
+        }
+
+        //Truncated input
+        {
+            io::imemstream is(data.data(), data.size() - 3);
+            TS_ASSERT_THROWS(nbt::io::read_compound(is), io::input_error);
+            TS_ASSERT(!is);
+        }
+
+        //Little endian, mixing in reads through the std::istream interface
+        std::ifstream little_file("littletest_uncompr", std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(little_file), std::istreambuf_iterator<char>());
+        io::imemstream is(data);
+        nbt::io::stream_reader reader(is, endian::little);
+        TS_ASSERT_EQUALS(is.get(), static_cast<int>(tag_type::Compound));
+        TS_ASSERT_EQUALS(reader.read_string(), "Level");
+        tag_compound comp;
+        comp.read_payload(reader);
+        verify_bigtest_structure(comp);
+        TS_ASSERT(is);
+        TS_ASSERT_THROWS(reader.read_type(), io::input_error);
+        TS_ASSERT(!is);
+    }
+
+    void test_read_arena()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+        tag_arena arena(256);
+        TS_ASSERT(tag_arena::current() == nullptr);
+        for(int i = 0; i < 3; ++i)
+        {
+            value heap_tag(tag_string("from the heap")); //Outside of any scope
+            {
+                tag_arena::scope scope(arena);
+                TS_ASSERT_EQUALS(tag_arena::current(), &arena);
+
+                io::imemstream is(data);
+                auto pair = nbt::io::read_compound(is);
+                TS_ASSERT(arena.bytes_used() > 0);
+                verify_bigtest_structure(*pair.second);
+
+                //Tags from the heap or from another arena can be mixed freely
+                //with tags from the arena
+                pair.second->put("heap", std::move(heap_tag));
+                TS_ASSERT_EQUALS(static_cast<std::string>(pair.second->at("heap")), "from the heap");
+                tag_arena other;
+                {
+                    tag_arena::scope inner(other);
+                    TS_ASSERT_EQUALS(tag_arena::current(), &other);
+                    pair.second->put("arena", tag_int(1));
+                }
+                TS_ASSERT_EQUALS(tag_arena::current(), &arena);
+                TS_ASSERT(other.bytes_used() > 0);
+                pair.second->erase("arena");
+            }
+            TS_ASSERT(tag_arena::current() == nullptr);
+            arena.release();
+            TS_ASSERT_EQUALS(arena.bytes_used(), 0u);
+        }
+    }
+
+    void test_read_const_access()
+    {
+        std::ostringstream os;
+        io::write_tag("", tag_compound{{"l", tag_list{1, 2, 3}}}, os);
+        const std::string data = os.str();
+
+        //Lists are read unboxed, const access must not change that
+        io::imemstream is(data);
+        const auto comp = io::read_compound(is).second;
+        const tag_list& list = comp->at("l").as<tag_list>();
+        const value& first = list[0];
+        TS_ASSERT((list.primitives<int32_t>() == std::vector<int32_t>{1, 2, 3}));
+        TS_ASSERT_EQUALS(static_cast<int32_t>(first), 1);
+
+        //Several threads can read the same tree at once
+        io::imemstream is2(data);
+        const auto shared = io::read_compound(is2).second;
+        auto sum = [&shared]() {
+            const tag_list& l = shared->at("l").as<tag_list>();
+            int32_t s = 0;
+            for(const value& val: l)
+                s += static_cast<int32_t>(val);
+            return s + 10 * static_cast<int32_t>(l.at(2));
+        };
+        int32_t s1 = 0, s2 = 0;
+        std::thread t1([&] { s1 = sum(); }), t2([&] { s2 = sum(); });
+        int32_t s0 = sum();
+        t1.join();
+        t2.join();
+        TS_ASSERT(s0 == 36 && s1 == 36 && s2 == 36);
+    }
+
+    void test_read_lazy()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+        //Skipping
+        {
+            io::imemstream is(data);
+            nbt::io::stream_reader reader(is);
+            TS_ASSERT_EQUALS(reader.read_type(), tag_type::Compound);
+            TS_ASSERT_EQUALS(reader.read_string(), "Level");
+            reader.skip_payload(tag_type::Compound);
+            TS_ASSERT_EQUALS(is.peek(), EOF);
+        }
+        {
+            std::istringstream is(data.substr(0, data.size() - 3));
+            nbt::io::stream_reader reader(is);
+            reader.read_type();
+            reader.read_string();
+            TS_ASSERT_THROWS(reader.skip_payload(tag_type::Compound), io::input_error);
+            TS_ASSERT(!is);
+        }
+
+        //Lazy reading validates the data, but decodes it on first access
+        {
+            io::imemstream is(data.data(), data.size() - 3);
+            nbt::io::stream_reader reader(is);
+            reader.set_lazy(true);
+            TS_ASSERT_THROWS(reader.read_compound(), io::input_error);
+        }
+        std::unique_ptr<tag_compound> comp;
+        {
+            io::imemstream is(data);
+            nbt::io::stream_reader reader(is);
+            reader.set_lazy(true);
+            comp = reader.read_compound().second;
+            TS_ASSERT_EQUALS(is.peek(), EOF);
+        }
+        //The recorded payloads are copies, so the input may go away
+        std::string copy = data;
+        data.assign(data.size(), '\0');
+        TS_ASSERT_EQUALS(static_cast<int64_t>(comp->at("longTest")), 9223372036854775807);
+        verify_bigtest_structure(*comp);
+
+        //Lazy subtrees are written without decoding them
+        io::imemstream is(copy);
+        nbt::io::stream_reader reader(is);
+        reader.set_lazy(true);
+        auto pair = reader.read_compound();
+        std::ostringstream os;
+        nbt::io::write_tag(pair.first, *pair.second, os);
+        std::istringstream written(os.str());
+        verify_bigtest_structure(*nbt::io::read_compound(written).second);
+        TS_ASSERT(*pair.second == *comp);
+    }
+
+    void test_read_network()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        auto orig = nbt::io::read_compound(file).second;
+        orig->put("ints", tag_int_array{0, -1, 1, INT32_MIN, INT32_MAX});
+        orig->put("longs", tag_long_array{0, -1, 64, INT64_MIN, INT64_MAX});
+        orig->put("intList", tag_list{1, 200, -300000});
+        io::omemstream os;
+        nbt::io::write_tag("Level", *orig, os, endian::network);
+        const std::string data = os.take();
+
+        {
+            io::imemstream is(data);
+            auto pair = nbt::io::read_compound(is, endian::network);
+            TS_ASSERT_EQUALS(pair.first, "Level");
+            TS_ASSERT(*pair.second == *orig);
+            TS_ASSERT_EQUALS(is.peek(), EOF);
+        }
+        {
+            std::istringstream is(data);
+            auto pair = nbt::io::read_compound(is, endian::network);
+            TS_ASSERT(*pair.second == *orig);
+            TS_ASSERT_EQUALS(is.peek(), EOF);
+        }
+
+        //Skipping needs to find the end of each varint
+        {
+            io::imemstream is(data);
+            nbt::io::stream_reader reader(is, endian::network);
+            reader.read_type();
+            reader.read_string();
+            reader.skip_payload(tag_type::Compound);
+            TS_ASSERT_EQUALS(is.peek(), EOF);
+        }
+        {
+            std::istringstream is(data);
+            auto result = io::path_query{"listTest (long)[3]", "intList[2]", "longs"}.run(is, endian::network);
+            TS_ASSERT(result[0].at(0) == tag_long(14));
+            TS_ASSERT(result[1].at(0) == tag_int(-300000));
+            TS_ASSERT(result[2].at(0) == tag_long_array({0, -1, 64, INT64_MIN, INT64_MAX}));
+        }
+
+        //Lazy payloads are copied if the encoding matches, and converted otherwise
+        {
+            io::imemstream is(data);
+            nbt::io::stream_reader reader(is, endian::network);
+            reader.set_lazy(true);
+            auto pair = reader.read_compound();
+            TS_ASSERT_EQUALS(io::stream_writer(os, endian::network).tag_size(pair.first, *pair.second), data.size());
+            nbt::io::write_tag(pair.first, *pair.second, os, endian::network);
+            TS_ASSERT_EQUALS(os.take(), data);
+
+            std::ostringstream expected;
+            nbt::io::write_tag("Level", *orig, expected, endian::little);
+            TS_ASSERT_EQUALS(io::stream_writer(os, endian::little).tag_size(pair.first, *pair.second), expected.str().size());
+            nbt::io::write_tag(pair.first, *pair.second, os, endian::little);
+            TS_ASSERT_EQUALS(os.take(), expected.str());
+        }
+
+        //Truncated input
+        {
+            io::imemstream is(data.data(), data.size() - 3);
+            TS_ASSERT_THROWS(nbt::io::read_compound(is, endian::network), io::input_error);
+        }
+        {
+            std::istringstream is(data.substr(0, data.size() - 3));
+            nbt::io::stream_reader reader(is, endian::network);
+            reader.read_type();
+            reader.read_string();
+            TS_ASSERT_THROWS(reader.skip_payload(tag_type::Compound), io::input_error);
+        }
+    }
+
+    void test_read_level_dat()
+    {
+        tag_compound comp{{"LevelName", "Bedrock level"}, {"StorageVersion", tag_int(10)}};
+        std::ostringstream payload;
+        nbt::io::write_tag("", comp, payload, endian::little);
+
+        //The header gives the storage version and the length of the payload in Little Endian
+        std::ostringstream os;
+        endian::write_little(os, int32_t(10));
+        endian::write_little(os, static_cast<uint32_t>(payload.str().size()));
+        const std::string data = os.str() + payload.str();
+        TS_ASSERT_EQUALS(data.size(), payload.str().size() + 8);
+
+        std::istringstream is(data);
+        auto header = io::read_level_dat_header(is);
+        TS_ASSERT_EQUALS(header.version, 10);
+        TS_ASSERT_EQUALS(header.length, payload.str().size());
+
+        is.str(data);
+        auto level = io::read_level_dat(is);
+        TS_ASSERT_EQUALS(level.version, 10);
+        TS_ASSERT_EQUALS(level.name, "");
+        TS_ASSERT(*level.root == comp);
+
+        //Lengths that don't match the data
+        std::string longer = data + '\0';
+        longer[4] += 1;
+        is.str(longer);
+        is.clear();
+        TS_ASSERT_THROWS(io::read_level_dat(is), io::input_error);
+        std::string shorter = data;
+        shorter[4] -= 1;
+        is.str(shorter);
+        is.clear();
+        TS_ASSERT_THROWS(io::read_level_dat(is), io::input_error);
+
+        is.str(data.substr(0, data.size() - 1));
+        is.clear();
+        TS_ASSERT_THROWS(io::read_level_dat(is), io::input_error);
+        is.str(data.substr(0, 6));
+        is.clear();
+        TS_ASSERT_THROWS(io::read_level_dat_header(is), io::input_error);
+    }
+
+    void test_path_query()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        io::path_query query{
+            "intTest",
+            "listTest (long)[3]",
+            "listTest (compound)[*].name",
+            "\"nested compound test\".*.value",
+            "nested compound test",
+            "nothing.here",
+            "[0]"
+        };
+        auto result = query.run(file);
+        TS_ASSERT(file);
+        TS_ASSERT_EQUALS(result.size(), 7u);
+
+        TS_ASSERT_EQUALS(result[0].size(), 1u);
+        TS_ASSERT(result[0].at(0) == tag_int(2147483647));
+        TS_ASSERT_EQUALS(result[1].size(), 1u);
+        TS_ASSERT(result[1].at(0) == tag_long(14));
+        TS_ASSERT_EQUALS(result[2].size(), 2u);
+        TS_ASSERT_EQUALS(static_cast<std::string>(result[2].at(1)), "Compound tag #1");
+        TS_ASSERT_EQUALS(result[3].size(), 2u);
+        TS_ASSERT(result[3].at(0) == tag_float(0.5f));
+        TS_ASSERT(result[3].at(1) == tag_float(0.75f));
+        TS_ASSERT_EQUALS(result[4].size(), 1u);
+        TS_ASSERT_EQUALS(result[4].at(0).get_type(), tag_type::Compound);
+        TS_ASSERT(result[5].empty());
+        TS_ASSERT(result[6].empty());
+
+        TS_ASSERT_THROWS(io::path_query{""}, std::invalid_argument);
+        TS_ASSERT_THROWS(io::path_query{"a..b"}, std::invalid_argument);
+        TS_ASSERT_THROWS(io::path_query{"a[x]"}, std::invalid_argument);
+        TS_ASSERT_THROWS(io::path_query{"a[1"}, std::invalid_argument);
+        TS_ASSERT_THROWS(io::path_query{"a[1]b"}, std::invalid_argument);
+        TS_ASSERT_THROWS(io::path_query{"\"a"}, std::invalid_argument);
+    }
+
+    void test_parse()
+    {
+        //Logs the events and returns the actions given for some of them
+        struct logger : public io::stream_visitor
+        {
+            std::string log;
+            std::string skip_key;
+            int32_t leave_at = -1;
+            bool stop_in_array = false;
+
+            action key(const std::string& name, tag_type) override
+            { log += name + ":"; return name == skip_key ? action::skip : action::proceed; }
+            action begin_compound() override { log += "{"; return action::proceed; }
+            action end_compound() override { log += "}"; return action::proceed; }
+            action begin_list(tag_type, int32_t length) override
+            { log += "[" + std::to_string(length) + " "; return action::proceed; }
+            action end_list() override { log += "]"; return action::proceed; }
+            action primitive(int8_t val) override { log += std::to_string(val) + "b "; return action::proceed; }
+            action primitive(int32_t val) override
+            { log += std::to_string(val) + " "; return val == leave_at ? action::leave : action::proceed; }
+            action string(const std::string& str) override { log += "\"" + str + "\" "; return action::proceed; }
+            action begin_array(tag_type, int32_t length) override
+            { log += "<" + std::to_string(length) + " "; return action::proceed; }
+            action array_data(const int32_t*, size_t n) override
+            { log += std::to_string(n) + " "; return stop_in_array ? action::stop : action::proceed; }
+            action end_array() override { log += ">"; return action::proceed; }
+        };
+
+        tag_compound comp{
+            {"a", int8_t(1)},
+            {"b", tag_list{2, 3, 4}},
+            {"c", tag_compound{{"d", "e"}}},
+            {"f", tag_int_array{1, 2, 3}},
+            {"g", tag_list{tag_list{5}, tag_list{6}}}
+        };
+        std::ostringstream os;
+        nbt::io::write_tag("root", comp, os);
+        const std::string data = os.str();
+
+        logger all;
+        std::istringstream is(data);
+        TS_ASSERT(nbt::io::stream_reader(is).parse(all));
+        TS_ASSERT_EQUALS(all.log, "root:{a:1b b:[3 2 3 4 ]c:{d:\"e\" }f:<3 3 >g:[2 [1 5 ][1 6 ]]}");
+        TS_ASSERT_EQUALS(is.peek(), EOF);
+
+        logger partial;
+        partial.skip_key = "c";
+        partial.leave_at = 3;
+        is.str(data);
+        is.clear();
+        TS_ASSERT(nbt::io::stream_reader(is).parse(partial));
+        TS_ASSERT_EQUALS(partial.log, "root:{a:1b b:[3 2 3 ]c:f:<3 3 >g:[2 [1 5 ][1 6 ]]}");
+        TS_ASSERT_EQUALS(is.peek(), EOF);
+
+        //Leaving from the inner list continues with the outer one
+        partial.log.clear();
+        partial.leave_at = 5;
+        is.str(data);
+        is.clear();
+        TS_ASSERT(nbt::io::stream_reader(is).parse(partial));
+        TS_ASSERT_EQUALS(partial.log, "root:{a:1b b:[3 2 3 4 ]c:f:<3 3 >g:[2 [1 5 ][1 6 ]]}");
+
+        logger stopping;
+        stopping.stop_in_array = true;
+        io::imemstream mem(data);
+        TS_ASSERT(!nbt::io::stream_reader(mem).parse(stopping));
+        TS_ASSERT_EQUALS(stopping.log, "root:{a:1b b:[3 2 3 4 ]c:{d:\"e\" }f:<3 3 ");
+
+        //Truncated input
+        is.str(data.substr(0, data.size() - 2));
+        is.clear();
+        logger truncated;
+        TS_ASSERT_THROWS(nbt::io::stream_reader(is).parse(truncated), io::input_error);
+    }
+
     void test_read_gzip()
     {
 #ifdef NBT_HAVE_ZLIB
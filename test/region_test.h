@@ -0,0 +1,332 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cxxtest/TestSuite.h>
+#include "io/region_decoder.h"
+#include "io/region_reader.h"
+#include "io/region_writer.h"
+#include "io/stream_reader.h"
+#include "nbt_tags.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace nbt;
+
+class region_test : public CxxTest::TestSuite
+{
+private:
+    static std::string read_file(const char* name)
+    {
+        std::ifstream file(name, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    //Appends a chunk with the given compression scheme and data at the end of the region
+    static void add_chunk(std::string& region, int index, int scheme, const std::string& data)
+    {
+        size_t sector = region.size() / 4096;
+        size_t count = (data.size() + 5 + 4095) / 4096;
+        uint32_t loc = static_cast<uint32_t>(sector << 8 | count);
+        uint32_t length = static_cast<uint32_t>(data.size() + 1);
+        for(int i = 0; i < 4; ++i)
+        {
+            region[4*index + i] = static_cast<char>(loc >> (24 - 8*i));
+            region[4096 + 4*index + i] = static_cast<char>(0x5f + i);
+        }
+        for(int i = 0; i < 4; ++i)
+            region.push_back(static_cast<char>(length >> (24 - 8*i)));
+        region.push_back(static_cast<char>(scheme));
+        region += data;
+        region.resize((sector + count) * 4096);
+    }
+
+    static std::string compress(const std::string& data)
+    {
+        std::string out(compressBound(data.size()), '\0');
+        uLongf len = out.size();
+        ::compress(reinterpret_cast<Bytef*>(&out[0]), &len,
+                   reinterpret_cast<const Bytef*>(data.data()), data.size());
+        out.resize(len);
+        return out;
+    }
+
+public:
+    void test_region_reader()
+    {
+        std::string bigtest = read_file("bigtest_uncompr");
+        std::string region(8192, '\0');
+        add_chunk(region, 0, 2, compress(bigtest));
+        add_chunk(region, 31 + 32, 3, bigtest);
+        add_chunk(region, 2, 1, read_file("bigtest.nbt"));
+        add_chunk(region, 3, 2, compress(bigtest).substr(0, 100));
+        add_chunk(region, 4, 0x82, ""); //External chunk
+        region[4*5 + 3] = 1; //Chunk in the header
+        region[4*6 + 1] = 0x7f; //Chunk beyond the end of the file
+        region[4*6 + 3] = 1;
+        region[4*7 + 2] = 2; //Chunk with a sector count of 0
+        add_chunk(region, 8, 3, "abc");
+        region[region.size() - 4096 + 1] = 0x10; //Length beyond the end of the chunk's sector
+
+        io::region_reader reader(region.data(), region.size());
+        TS_ASSERT(reader.has_chunk(0, 0));
+        TS_ASSERT(!reader.has_chunk(1, 0));
+        TS_ASSERT(reader.has_chunk(31, 1));
+        TS_ASSERT(reader.has_chunk(-1, 33)); //same as (31, 1)
+
+        auto chunk = reader.get_chunk(31, 1);
+        TS_ASSERT(chunk);
+        TS_ASSERT_EQUALS(chunk.scheme, io::region_reader::compression::none);
+        TS_ASSERT_EQUALS(chunk.timestamp, 0x5f606162);
+        TS_ASSERT_EQUALS(chunk.size, bigtest.size());
+        TS_ASSERT(chunk.data >= region.data() && chunk.data < region.data() + region.size());
+        TS_ASSERT(!reader.get_chunk(1, 0));
+
+        std::string buf;
+        io::region_reader::decompress(reader.get_chunk(0, 0), buf);
+        TS_ASSERT(buf == bigtest);
+        io::region_reader::decompress(reader.get_chunk(2, 0), buf);
+        TS_ASSERT(buf == bigtest);
+
+        auto comp = reader.read_chunk(31, 1);
+        TS_ASSERT(comp);
+        TS_ASSERT(comp->at("intTest") == tag_int(2147483647));
+        TS_ASSERT(*comp == *reader.read_chunk(0, 0));
+        TS_ASSERT(!reader.read_chunk(1, 0));
+
+        TS_ASSERT_THROWS(reader.read_chunk(3, 0), zlib::zlib_error);
+        TS_ASSERT(reader.get_chunk(4, 0).external);
+        TS_ASSERT_THROWS(reader.read_chunk(4, 0), io::input_error);
+        TS_ASSERT_THROWS(reader.get_chunk(5, 0), io::input_error);
+        TS_ASSERT_THROWS(reader.get_chunk(6, 0), io::input_error);
+        TS_ASSERT_THROWS(reader.get_chunk(7, 0), io::input_error);
+        TS_ASSERT_THROWS(reader.get_chunk(8, 0), io::input_error);
+
+        TS_ASSERT_THROWS(io::region_reader(region.data(), 4096), io::input_error);
+        TS_ASSERT(!io::region_reader(region.data(), 0).has_chunk(0, 0));
+    }
+
+    void test_region_file()
+    {
+        std::string region(8192, '\0');
+        add_chunk(region, 0, 2, compress(read_file("bigtest_uncompr")));
+        {
+            std::ofstream file("r.0.0.mca", std::ios::binary);
+            file.write(region.data(), region.size());
+        }
+
+        {
+            io::region_reader reader("r.0.0.mca");
+            auto comp = reader.read_chunk(0, 0);
+            TS_ASSERT(comp);
+            TS_ASSERT(comp->at("intTest") == tag_int(2147483647));
+            io::region_reader moved(std::move(reader));
+            TS_ASSERT(moved.has_chunk(0, 0));
+        }
+        std::remove("r.0.0.mca");
+
+        TS_ASSERT_THROWS(io::region_reader("nonexistent.mca"), io::input_error);
+    }
+
+    void test_region_writer()
+    {
+        using compression = io::region_writer::compression;
+        std::remove("r.1.1.mca");
+        std::istringstream bigtest_is(read_file("bigtest_uncompr"));
+        auto bigtest = io::stream_reader(bigtest_is).read_compound().second;
+        tag_compound small{{"x", 1}};
+        tag_compound large{{"data", tag_byte_array(std::vector<int8_t>(10000, 7))}};
+
+        {
+            io::region_writer writer("r.1.1.mca");
+            TS_ASSERT_EQUALS(writer.sector_count(), 2u);
+            writer.write_chunk(0, 0, *bigtest, compression::none, -1, 1234);
+            writer.write_chunk(1, 0, small);
+            writer.write_chunk(2, 0, *bigtest, compression::gzip);
+            TS_ASSERT_EQUALS(writer.sector_count(), 5u);
+            TS_ASSERT(writer.has_chunk(1, 0) && !writer.has_chunk(3, 0));
+
+            //Grows from one to three sectors, so it has to move to the end
+            writer.write_chunk(0, 0, large, compression::none);
+            TS_ASSERT_EQUALS(writer.sector_count(), 8u);
+            TS_ASSERT_EQUALS(writer.free_sectors(), 1u);
+            //Reuses the sector that became free
+            writer.write_chunk(3, 0, small);
+            TS_ASSERT_EQUALS(writer.sector_count(), 8u);
+            TS_ASSERT_EQUALS(writer.free_sectors(), 0u);
+            //Shrinks in place
+            writer.write_chunk(0, 0, small, compression::none);
+            TS_ASSERT_EQUALS(writer.free_sectors(), 2u);
+            writer.remove_chunk(2, 0);
+            TS_ASSERT_EQUALS(writer.free_sectors(), 3u);
+            TS_ASSERT_THROWS(writer.write_chunk(4, 0, small, compression::custom), std::invalid_argument);
+            std::string huge(256 * 4096, 'x');
+            TS_ASSERT_THROWS(writer.write_chunk_data(4, 0, huge.data(), huge.size(), compression::none), std::length_error);
+        }
+        {
+            io::region_reader reader("r.1.1.mca");
+            TS_ASSERT(*reader.read_chunk(0, 0) == small);
+            TS_ASSERT(*reader.read_chunk(1, 0) == small);
+            TS_ASSERT(!reader.has_chunk(2, 0));
+            TS_ASSERT(*reader.read_chunk(3, 0) == small);
+            TS_ASSERT(!reader.has_chunk(4, 0));
+        }
+        {
+            //Reopening keeps the existing chunks
+            io::region_writer writer("r.1.1.mca");
+            TS_ASSERT_EQUALS(writer.sector_count(), 8u);
+            writer.write_chunk(2, 0, *bigtest, compression::zlib, 9, 42);
+            writer.compact();
+            TS_ASSERT_EQUALS(writer.sector_count(), 6u);
+            TS_ASSERT_EQUALS(writer.free_sectors(), 0u);
+            writer.write_chunk(5, 5, large);
+            TS_ASSERT_EQUALS(writer.sector_count(), 7u);
+        }
+        {
+            io::region_reader reader("r.1.1.mca");
+            TS_ASSERT_EQUALS(read_file("r.1.1.mca").size(), 7u * 4096);
+            TS_ASSERT(*reader.read_chunk(0, 0) == small);
+            TS_ASSERT(*reader.read_chunk(1, 0) == small);
+            TS_ASSERT(*reader.read_chunk(2, 0) == *bigtest);
+            TS_ASSERT_EQUALS(reader.get_chunk(2, 0).timestamp, 42);
+            TS_ASSERT(*reader.read_chunk(3, 0) == small);
+            TS_ASSERT(*reader.read_chunk(5, 5) == large);
+        }
+        std::remove("r.1.1.mca");
+
+        //The external files of chunks that are replaced or removed are deleted
+        {
+            const auto external = static_cast<compression>(0x80 | static_cast<int>(compression::zlib));
+            io::region_writer writer("r.1.1.mca");
+            writer.write_chunk_data(1, 2, "", 0, external);
+            writer.write_chunk_data(3, 0, "", 0, external);
+            std::ofstream("c.33.34.mcc") << "chunk";
+            std::ofstream("c.35.32.mcc") << "chunk";
+            //Rewriting it as external keeps the file
+            writer.write_chunk_data(1, 2, "", 0, external);
+            TS_ASSERT(std::filesystem::exists("c.33.34.mcc"));
+            writer.write_chunk(1, 2, small);
+            TS_ASSERT(!std::filesystem::exists("c.33.34.mcc"));
+            writer.remove_chunk(3, 0);
+            TS_ASSERT(!std::filesystem::exists("c.35.32.mcc"));
+        }
+        {
+            io::region_reader reader("r.1.1.mca");
+            TS_ASSERT(*reader.read_chunk(1, 2) == small);
+            TS_ASSERT(!reader.has_chunk(3, 0));
+        }
+        std::remove("r.1.1.mca");
+
+        //Every codec can be used, and the reader picks it from the chunk's header
+        auto codecs = io::available_codecs();
+        {
+            io::region_writer writer("r.1.1.mca");
+            for(size_t i = 0; i < codecs.size(); ++i)
+                writer.write_chunk(i, 1, *bigtest, *codecs[i]);
+        }
+        {
+            io::region_reader reader("r.1.1.mca");
+            for(size_t i = 0; i < codecs.size(); ++i)
+            {
+                TS_ASSERT_EQUALS(reader.get_chunk(i, 1).scheme, codecs[i]->scheme());
+                TS_ASSERT(*reader.read_chunk(i, 1) == *bigtest);
+            }
+        }
+        std::remove("r.1.1.mca");
+
+        {
+            std::ofstream file("r.1.1.mca", std::ios::binary);
+            file << "short";
+        }
+        TS_ASSERT_THROWS(io::region_writer("r.1.1.mca"), io::input_error);
+        std::remove("r.1.1.mca");
+    }
+
+    void test_region_decoder()
+    {
+        namespace fs = std::filesystem;
+        std::string bigtest = read_file("bigtest_uncompr");
+        std::string region(8192, '\0');
+        for(int i = 0; i < 40; ++i)
+            add_chunk(region, 3 * i, 2, compress(bigtest));
+        add_chunk(region, 1, 2, compress(bigtest).substr(0, 100));
+
+        fs::create_directory("regions");
+        {
+            std::ofstream file("regions/r.0.0.mca", std::ios::binary);
+            file.write(region.data(), region.size());
+        }
+        {
+            std::ofstream file("regions/r.0.1.mca", std::ios::binary);
+            file.write(region.data(), 2 * 4096 + 4096);
+        }
+        std::ofstream("regions/readme.txt") << "not a region";
+
+        io::region_decoder decoder(3);
+        TS_ASSERT_EQUALS(decoder.threads(), 3u);
+        decoder.add_directory("regions");
+        decoder.add_file("regions/nonexistent.mca");
+        TS_ASSERT_EQUALS(decoder.files().size(), 3u);
+
+        auto chunks = decoder.decode_all();
+        //41 chunks in each file, most of which are broken in the truncated one, plus the missing file
+        TS_ASSERT_EQUALS(chunks.size(), 41u + 41u + 1u);
+        TS_ASSERT_EQUALS(chunks[0].file, decoder.files()[0]);
+        TS_ASSERT_EQUALS(chunks[0].x, 0);
+        TS_ASSERT(chunks[0].data);
+        TS_ASSERT(chunks[0].data->at("intTest") == tag_int(2147483647));
+        TS_ASSERT_EQUALS(chunks[0].timestamp, 0x5f606162);
+        TS_ASSERT_EQUALS(chunks[1].x, 1);
+        TS_ASSERT(chunks[1].error && !chunks[1].data);
+        TS_ASSERT_EQUALS(chunks[40].x, 39 * 3 % 32);
+        TS_ASSERT_EQUALS(chunks[40].z, 39 * 3 / 32);
+        TS_ASSERT(chunks[40].data);
+        TS_ASSERT(chunks[41].data); //The first chunk is still within the truncated file
+        TS_ASSERT(chunks[42].error);
+        TS_ASSERT_EQUALS(chunks[82].file, "regions/nonexistent.mca");
+        TS_ASSERT_EQUALS(chunks[82].x, -1);
+        TS_ASSERT_THROWS(std::rethrow_exception(chunks[82].error), io::input_error);
+
+        //Exceptions from the callback stop the decoding
+        std::atomic<int> calls{0};
+        TS_ASSERT_THROWS(decoder.run([&](io::region_decoder::chunk& c) {
+            if(++calls == 5)
+                throw std::runtime_error("stop");
+        }), std::runtime_error);
+        TS_ASSERT(calls < 83);
+
+        //Single-threaded decoding gives the same result
+        auto single = io::region_decoder(1);
+        single.add_file("regions/r.0.0.mca");
+        auto chunks1 = single.decode_all();
+        TS_ASSERT_EQUALS(chunks1.size(), 41u);
+        for(size_t i = 0; i < chunks1.size(); ++i)
+        {
+            TS_ASSERT_EQUALS(chunks1[i].x, chunks[i].x);
+            TS_ASSERT_EQUALS(bool(chunks1[i].data), bool(chunks[i].data));
+        }
+
+        fs::remove_all("regions");
+        TS_ASSERT_THROWS(io::region_decoder().add_directory("regions"), io::input_error);
+    }
+};
+
@@ -0,0 +1,172 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cxxtest/TestSuite.h>
+#include "text/snbt_parser.h"
+#include "nbt_tags.h"
+#include <cmath>
+#include <limits>
+
+using namespace nbt;
+using text::parse_error;
+
+class snbt_test : public CxxTest::TestSuite
+{
+private:
+    text::snbt_parser parser;
+
+    ///Returns the offset of the parse_error that parsing the string throws
+    size_t error_offset(const std::string& str)
+    {
+        try
+        {
+            parser.parse(str);
+        }
+        catch(parse_error& ex)
+        {
+            return ex.offset();
+        }
+        TS_FAIL("Expected a parse_error");
+        return -1;
+    }
+
+public:
+    void test_numbers()
+    {
+        TS_ASSERT(*parser.parse("12b") == tag_byte(12));
+        TS_ASSERT(*parser.parse("-128B") == tag_byte(-128));
+        TS_ASSERT(*parser.parse("true") == tag_byte(1));
+        TS_ASSERT(*parser.parse("false") == tag_byte(0));
+        TS_ASSERT(*parser.parse("-300s") == tag_short(-300));
+        TS_ASSERT(*parser.parse("+42") == tag_int(42));
+        TS_ASSERT(*parser.parse("-2147483648") == tag_int(-2147483648LL));
+        TS_ASSERT(*parser.parse("9223372036854775807L") == tag_long(9223372036854775807LL));
+        TS_ASSERT(*parser.parse("1.5f") == tag_float(1.5f));
+        TS_ASSERT(*parser.parse("3F") == tag_float(3));
+        TS_ASSERT(*parser.parse(".25") == tag_double(0.25));
+        TS_ASSERT(*parser.parse("2.") == tag_double(2));
+        TS_ASSERT(*parser.parse("1e3d") == tag_double(1000));
+        TS_ASSERT(*parser.parse("-1.5E-2") == tag_double(-0.015));
+        TS_ASSERT(*parser.parse("0.1f") == tag_float(0.1f));
+        TS_ASSERT(*parser.parse("0.1") == tag_double(0.1));
+        TS_ASSERT(std::isinf(parser.parse("1e400d")->as<tag_double>().get()));
+        TS_ASSERT(*parser.parse("-1e400d") == tag_double(-std::numeric_limits<double>::infinity()));
+        TS_ASSERT(*parser.parse("1e39f") == tag_float(std::numeric_limits<float>::infinity()));
+        TS_ASSERT(*parser.parse("100000000000000000000000000000000000000000f")
+            == tag_float(std::numeric_limits<float>::infinity()));
+        TS_ASSERT(*parser.parse("0.00000000000000000000000000000000000000000000000001f") == tag_float(0));
+        TS_ASSERT(*parser.parse("+1.0e-400") == tag_double(0));
+
+        //Tokens that are no valid numbers are strings
+        TS_ASSERT(*parser.parse("128b") == tag_string("128b"));
+        TS_ASSERT(*parser.parse("2147483648") == tag_string("2147483648"));
+        TS_ASSERT(*parser.parse("007") == tag_string("007"));
+        TS_ASSERT(*parser.parse("1e3") == tag_string("1e3"));
+        TS_ASSERT(*parser.parse("1.2.3") == tag_string("1.2.3"));
+        TS_ASSERT(*parser.parse("-") == tag_string("-"));
+        TS_ASSERT(*parser.parse("minecraft.stone") == tag_string("minecraft.stone"));
+    }
+
+    void test_strings()
+    {
+        TS_ASSERT(*parser.parse("\"Hello, World\"") == tag_string("Hello, World"));
+        TS_ASSERT(*parser.parse("'say \"hi\"'") == tag_string("say \"hi\""));
+        TS_ASSERT(*parser.parse(R"("a\\b\"c\'d\n")") == tag_string("a\\b\"c'd\n"));
+        TS_ASSERT(*parser.parse(R"("\u00e4\u20AC\ud83d\ude00")") == tag_string("\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80"));
+        TS_ASSERT(*parser.parse("''") == tag_string(""));
+    }
+
+    void test_compound()
+    {
+        auto comp = parser.parse_compound(
+            " { id: \"minecraft:diamond_sword\", Count: 1b, 'odd key': 2,"
+            " tag: {Damage: 5, display: {Name: '{\"text\":\"Sword\"}'}, empty: {}},"
+            " trailing: 1L, } ");
+        TS_ASSERT(*comp == (tag_compound{
+            {"id", "minecraft:diamond_sword"},
+            {"Count", int8_t(1)},
+            {"odd key", 2},
+            {"tag", tag_compound{
+                {"Damage", 5},
+                {"display", tag_compound{{"Name", "{\"text\":\"Sword\"}"}}},
+                {"empty", tag_compound()}
+            }},
+            {"trailing", int64_t(1)}
+        }));
+
+        //Later keys win
+        TS_ASSERT(*parser.parse("{a: 1, a: 2}") == (tag_compound{{"a", 2}}));
+        TS_ASSERT_THROWS(parser.parse_compound("[1, 2]"), parse_error);
+    }
+
+    void test_lists()
+    {
+        TS_ASSERT(*parser.parse("[]") == tag_list());
+        TS_ASSERT(*parser.parse("[1s, 2s, 3s]") == (tag_list{int16_t(1), int16_t(2), int16_t(3)}));
+        TS_ASSERT(*parser.parse("[1.5, 2.5,]") == (tag_list{1.5, 2.5}));
+        TS_ASSERT(*parser.parse("[a, \"b c\"]") == tag_list::of<tag_string>({"a", "b c"}));
+        TS_ASSERT(*parser.parse("[[1], [], [[I; 2]]]") == (tag_list{
+            tag_list{1}, tag_list(), tag_list{tag_int_array{2}}
+        }));
+        TS_ASSERT(*parser.parse("[{a: 1}, {}]") == (tag_list{
+            tag_compound{{"a", 1}}, tag_compound()
+        }));
+    }
+
+    void test_arrays()
+    {
+        TS_ASSERT(*parser.parse("[B; 1b, -2b, true, 3]") == (tag_byte_array{1, -2, 1, 3}));
+        TS_ASSERT(*parser.parse("[I;]") == tag_int_array());
+        TS_ASSERT(*parser.parse("[I; -1, 2147483647]") == (tag_int_array{-1, 2147483647}));
+        TS_ASSERT(*parser.parse("[L; 1l, 5000000000L, 7]") == (tag_long_array{1, 5000000000LL, 7}));
+        //Without a semicolon, it's a list
+        TS_ASSERT(*parser.parse("[B]") == tag_list::of<tag_string>({"B"}));
+    }
+
+    void test_errors()
+    {
+        TS_ASSERT_EQUALS(error_offset(""), 0u);
+        TS_ASSERT_EQUALS(error_offset("{a: 1"), 5u);
+        TS_ASSERT_EQUALS(error_offset("{a 1}"), 3u);
+        TS_ASSERT_EQUALS(error_offset("{: 1}"), 1u);
+        TS_ASSERT_EQUALS(error_offset("[1, 2b]"), 4u);
+        TS_ASSERT_EQUALS(error_offset("[1, {}]"), 4u);
+        TS_ASSERT_EQUALS(error_offset("[B; 1b, 2s]"), 8u);
+        TS_ASSERT_EQUALS(error_offset("[B; 300]"), 4u);
+        TS_ASSERT_EQUALS(error_offset("[I; 1.5]"), 4u);
+        TS_ASSERT_EQUALS(error_offset("{a: \"abc}"), 4u);
+        TS_ASSERT_EQUALS(error_offset("'\\q'"), 1u);
+        TS_ASSERT_EQUALS(error_offset("'\\u12'"), 1u);
+        TS_ASSERT_EQUALS(error_offset("1 2"), 2u);
+        TS_ASSERT_EQUALS(error_offset("{a: #}"), 4u);
+
+        std::string deep(600, '[');
+        TS_ASSERT_EQUALS(error_offset(deep), 512u);
+
+        try
+        {
+            parser.parse("{a: 1");
+            TS_FAIL("Expected a parse_error");
+        }
+        catch(parse_error& ex)
+        {
+            TS_ASSERT_EQUALS(std::string(ex.what()), "Expected '}' at offset 5");
+        }
+    }
+};
@@ -0,0 +1,177 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cxxtest/TestSuite.h>
+#include "stats.h"
+#include "io/imemstream.h"
+#include "io/omemstream.h"
+#include "io/stream_reader.h"
+#include "io/stream_writer.h"
+#include "nbt_tags.h"
+#include <sstream>
+#include <thread>
+#ifdef NBT_HAVE_ZLIB
+#include "io/izlibstream.h"
+#include "io/ozlibstream.h"
+#endif
+
+using namespace nbt;
+
+namespace
+{
+    struct null_visitor : io::stream_visitor {};
+
+    tag_compound make_sample()
+    {
+        tag_list entries;
+        entries.push_back(tag_compound{{"b", int8_t(1)}});
+        entries.push_back(tag_compound{{"b", int8_t(2)}});
+        return tag_compound{
+            {"a", 42},
+            {"l", tag_list{int16_t(1), int16_t(2), int16_t(3)}},
+            {"c", tag_compound{
+                {"s", "text"},
+                {"ll", std::move(entries)}
+            }},
+            {"arr", tag_int_array{1, 2, 3}}
+        };
+    }
+
+    std::string serialize(const tag_compound& comp)
+    {
+        io::omemstream os;
+        io::write_tag("", comp, os);
+        return os.take();
+    }
+
+    ///The number of tags of each type in make_sample, indexed by tag_type
+    const std::array<uint64_t, 13> sample_tags = {
+        0, 2, 3, 1, 0, 0, 0, 0, 1, 2, 4, 1, 0
+    };
+}
+
+class stats_test : public CxxTest::TestSuite
+{
+public:
+    void test_disabled()
+    {
+        if(stats::enabled)
+            return;
+        std::string data = serialize(make_sample());
+        io::imemstream is(data);
+        io::read_compound(is);
+
+        stats::snapshot s = stats::get_snapshot();
+        TS_ASSERT_EQUALS(s.total_tags_read(), 0u);
+        TS_ASSERT_EQUALS(s.total_tags_written(), 0u);
+        TS_ASSERT_EQUALS(s.bytes_read, 0u);
+        TS_ASSERT_EQUALS(s.tags_created, 0u);
+        TS_ASSERT_EQUALS(s.max_depth, 0u);
+    }
+
+    void test_counters()
+    {
+        if(!stats::enabled)
+            return;
+        tag_compound sample = make_sample();
+        io::omemstream os;
+
+        stats::reset();
+        io::write_tag("root", sample, os);
+        std::string data = os.take();
+        stats::snapshot s = stats::get_snapshot();
+        TS_ASSERT(s.tags_written == sample_tags);
+        TS_ASSERT_EQUALS(s.bytes_written, data.size());
+        TS_ASSERT_EQUALS(s.total_tags_read(), 0u);
+
+        stats::reset();
+        io::imemstream is(data);
+        auto pair = io::read_compound(is);
+        TS_ASSERT(*pair.second == sample);
+        s = stats::get_snapshot();
+        TS_ASSERT(s.tags_read == sample_tags);
+        TS_ASSERT_EQUALS(s.total_tags_read(), 14u);
+        TS_ASSERT_EQUALS(s.bytes_read, data.size());
+        TS_ASSERT_EQUALS(s.max_depth, 5u);
+        //All but the root and the unboxed shorts
+        TS_ASSERT_EQUALS(s.tags_created, 10u);
+        TS_ASSERT_EQUALS(s.total_tags_written(), 0u);
+
+        //Parsing sees the same tags without creating any
+        stats::reset();
+        io::imemstream is2(data);
+        null_visitor v;
+        TS_ASSERT(io::stream_reader(is2).parse(v));
+        s = stats::get_snapshot();
+        TS_ASSERT(s.tags_read == sample_tags);
+        TS_ASSERT_EQUALS(s.bytes_read, data.size());
+        TS_ASSERT_EQUALS(s.max_depth, 5u);
+        TS_ASSERT_EQUALS(s.tags_created, 0u);
+        TS_ASSERT(s.parse_time.count() > 0);
+
+        stats::reset();
+        s = stats::get_snapshot();
+        TS_ASSERT_EQUALS(s.total_tags_read(), 0u);
+        TS_ASSERT_EQUALS(s.bytes_read, 0u);
+        TS_ASSERT_EQUALS(s.max_depth, 0u);
+    }
+
+    void test_threads()
+    {
+        if(!stats::enabled)
+            return;
+        std::string data = serialize(make_sample());
+
+        stats::reset();
+        auto read = [&data] {
+            io::imemstream is(data);
+            io::read_compound(is);
+        };
+        std::thread t1(read), t2(read);
+        t1.join();
+        t2.join();
+        read();
+        //Includes the counters of threads that have finished
+        stats::snapshot s = stats::get_snapshot();
+        TS_ASSERT_EQUALS(s.total_tags_read(), 3 * 14u);
+        TS_ASSERT_EQUALS(s.bytes_read, 3 * data.size());
+        TS_ASSERT_EQUALS(s.max_depth, 5u);
+    }
+
+    void test_inflate_time()
+    {
+#ifdef NBT_HAVE_ZLIB
+        if(!stats::enabled)
+            return;
+        std::stringstream str;
+        {
+            zlib::ozlibstream zs(str);
+            io::write_tag("", make_sample(), zs);
+        }
+
+        stats::reset();
+        zlib::izlibstream zs(str);
+        io::read_compound(zs);
+        stats::snapshot s = stats::get_snapshot();
+        TS_ASSERT_EQUALS(s.total_tags_read(), 14u);
+        TS_ASSERT(s.inflate_time.count() > 0);
+        TS_ASSERT(s.parse_time.count() > 0);
+#endif
+    }
+};
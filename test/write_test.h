@@ -20,6 +20,8 @@
 #include <cxxtest/TestSuite.h>
 #include "io/stream_writer.h"
 #include "io/stream_reader.h"
+#include "io/level_dat.h"
+#include "io/omemstream.h"
 #ifdef NBT_HAVE_ZLIB
 #include "io/ozlibstream.h"
 #include "io/izlibstream.h"
@@ -92,6 +94,51 @@ public:
         TS_ASSERT(!os);
     }
 
+    void test_stream_writer_network()
+    {
+        //Writes to memory and through the std::ostream interface
+        io::omemstream mstr;
+        std::ostringstream sstr;
+        for(std::ostream* os: {static_cast<std::ostream*>(&mstr), static_cast<std::ostream*>(&sstr)})
+        {
+            nbt::io::stream_writer writer(*os, endian::network);
+            TS_ASSERT_EQUALS(writer.get_endian(), endian::network);
+
+            writer.write_num(int32_t(-3));
+            writer.write_num(int32_t(64));
+            writer.write_num(int32_t(INT32_MIN));
+            writer.write_num(int64_t(INT64_MAX));
+            writer.write_num(int16_t(258));
+            const int32_t arr[] = {-1, 1, -2};
+            writer.write_array(arr, 3);
+            writer.write_string("foobar");
+
+            TS_ASSERT(*os);
+            TS_ASSERT_THROWS(writer.write_string(std::string(65536, '.')), std::length_error);
+            TS_ASSERT(!*os);
+        }
+        const std::string expected{
+            '\x05', //Int -3 as zigzag varint
+            '\x80', '\x01', //Int 64
+            '\xFF', '\xFF', '\xFF', '\xFF', '\x0F', //Int INT32_MIN
+            '\xFE', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\x01', //Long INT64_MAX
+            0x02, 0x01, //Short 258 in Little Endian
+            0x01, 0x02, 0x03, //Ints -1, 1, -2
+
+            0x06, //String length as varint (not zigzag encoded)
+            'f', 'o', 'o', 'b', 'a', 'r'
+        };
+        TS_ASSERT_EQUALS(mstr.str(), expected);
+        TS_ASSERT_EQUALS(sstr.str(), expected);
+
+        //Lengths of lists and arrays are zigzag encoded
+        std::ostringstream os;
+        nbt::io::stream_writer writer(os, endian::network);
+        writer.write_payload(tag_list{int64_t(1), int64_t(-1)});
+        writer.write_payload(tag_byte_array{1, 2});
+        TS_ASSERT_EQUALS(os.str(), std::string({4, 0x04, 0x02, 0x01, 0x04, 1, 2}));
+    }
+
     void test_write_payload_big()
     {
         std::ostringstream os;
@@ -274,4 +321,127 @@ public:
         TS_ASSERT(*orig_pair.second == *written_pair.second);
 #endif
     }
+
+    void test_write_omemstream()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        auto orig = io::read_compound(file).second;
+        orig->put("doubles", tag_list{1.5, -2.25, 1e300});
+        orig->put("ints", tag_int_array{1, 2, 3});
+
+        for(auto e: {endian::big, endian::little, endian::network})
+        {
+            std::ostringstream sstr;
+            io::write_tag("Level", *orig, sstr, e);
+            io::omemstream mstr;
+            io::write_tag("Level", *orig, mstr, e);
+            TS_ASSERT(mstr);
+            TS_ASSERT_EQUALS(mstr.str(), sstr.str());
+            TS_ASSERT_EQUALS(static_cast<size_t>(mstr.tellp()), sstr.str().size());
+
+            //A buffer that is large enough
+            std::string fixed(sstr.str().size(), '\0');
+            io::omemstream fstr(&fixed[0], fixed.size());
+            io::write_tag("Level", *orig, fstr, e);
+            TS_ASSERT(fstr);
+            TS_ASSERT_EQUALS(fixed, sstr.str());
+        }
+
+        //A buffer that is too small
+        char small[100];
+        io::omemstream fstr(small, sizeof(small));
+        io::write_tag("Level", *orig, fstr);
+        TS_ASSERT(!fstr);
+        TS_ASSERT(fstr.size() <= sizeof(small));
+
+        io::omemstream mstr(16);
+        io::write_tag("Level", *orig, mstr);
+        const std::string expected = mstr.str();
+        std::string taken = mstr.take();
+        TS_ASSERT_EQUALS(taken, expected);
+        TS_ASSERT_EQUALS(mstr.size(), 0u);
+        io::write_tag("Level", *orig, mstr);
+        TS_ASSERT_EQUALS(mstr.str(), expected);
+        mstr.reset();
+        TS_ASSERT_EQUALS(mstr.size(), 0u);
+        mstr << "abc";
+        TS_ASSERT_EQUALS(mstr.str(), "abc");
+    }
+
+    void test_serialized_size()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        auto orig = io::read_compound(file).second;
+        orig->put("doubles", tag_list{1.5, -2.25, 1e300});
+        orig->put("strings", tag_list{"a", "bc"});
+        orig->put("empty", tag_list());
+        orig->put("longs", tag_long_array{1, 2, 3});
+        orig->put("intList", tag_list{0, -64, 100000});
+
+        for(auto e: {endian::big, endian::little, endian::network})
+        {
+            std::ostringstream sstr;
+            io::stream_writer writer(sstr, e);
+            writer.write_payload(*orig);
+            TS_ASSERT_EQUALS(io::serialized_size(*orig, e), sstr.str().size());
+
+            sstr.str("");
+            writer.write_tag("Level", *orig);
+            TS_ASSERT_EQUALS(writer.tag_size("Level", *orig), sstr.str().size());
+        }
+        //Measuring a list keeps references to its elements valid, whether they are boxed or not
+        tag_list boxed = tag_list::of<tag_int>({1, -300, 70000});
+        value& elem = boxed[1];
+        TS_ASSERT_EQUALS(io::serialized_size(boxed, endian::network), 8u);
+        elem = tag_int(5);
+        TS_ASSERT((boxed == tag_list{1, 5, 70000}));
+        tag_list unboxed{int64_t(-1), int64_t(200)};
+        std::vector<int64_t>& longs = unboxed.primitives<int64_t>();
+        TS_ASSERT_EQUALS(io::serialized_size(unboxed, endian::network), 5u);
+        longs[0] = 7;
+        TS_ASSERT((unboxed == tag_list{int64_t(7), int64_t(200)}));
+
+        TS_ASSERT_EQUALS(io::serialized_size(tag_int(5)), 4u);
+        TS_ASSERT_EQUALS(io::serialized_size(tag_string("abc")), 5u);
+        TS_ASSERT_EQUALS(io::serialized_size(tag_compound()), 1u);
+
+        //Lazily read payloads are measured without decoding them
+        std::ostringstream sstr;
+        io::write_tag("", *orig, sstr);
+        const std::string written = sstr.str();
+        io::imemstream mstr(written);
+        io::stream_reader reader(mstr);
+        reader.set_lazy(true);
+        auto lazy = reader.read_compound().second;
+        TS_ASSERT(lazy->at("nested compound test").as<tag_compound>().lazy_size() > 0);
+        TS_ASSERT_EQUALS(io::serialized_size(*lazy), written.size() - 3);
+        TS_ASSERT_EQUALS(lazy->at("nested compound test").as<tag_compound>().lazy_size(endian::network), 0u);
+        TS_ASSERT_EQUALS(io::serialized_size(*lazy, endian::network), io::serialized_size(*orig, endian::network));
+    }
+
+    void test_write_level_dat()
+    {
+        tag_compound comp{{"LevelName", "Bedrock level"}, {"StorageVersion", tag_int(10)}};
+        std::ostringstream os;
+        io::write_level_dat(10, "", comp, os);
+        TS_ASSERT(os);
+
+        std::ostringstream payload;
+        io::write_tag("", comp, payload, endian::little);
+        const std::string data = os.str();
+        TS_ASSERT_EQUALS(data.substr(8), payload.str());
+        TS_ASSERT_EQUALS(data.substr(0, 4), std::string("\x0a\0\0\0", 4));
+        uint32_t length;
+        endian::read_little(data.data() + 4, length);
+        TS_ASSERT_EQUALS(length, payload.str().size());
+
+        std::istringstream is(data);
+        auto level = io::read_level_dat(is);
+        TS_ASSERT_EQUALS(level.version, 10);
+        TS_ASSERT(*level.root == comp);
+
+        std::ostringstream header;
+        io::write_level_dat_header(header, {-2, 0x01020304});
+        TS_ASSERT_EQUALS(header.str(), std::string("\xFE\xFF\xFF\xFF\x04\x03\x02\x01"));
+    }
 };
@@ -20,7 +20,10 @@
 #include <cxxtest/TestSuite.h>
 #include "io/izlibstream.h"
 #include "io/ozlibstream.h"
+#include "io/zlib_buffer.h"
+#include "io/stream_reader.h"
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
 using namespace zlib;
@@ -378,4 +381,83 @@ public:
             TS_ASSERT(!str);
         }
     }
+
+    void test_buffer()
+    {
+        auto read_file = [](const char* name) {
+            std::ifstream file(name, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        };
+        const std::string uncompr = read_file("bigtest_uncompr");
+
+        //One-shot decompression of the test files
+        std::string in = read_file("bigtest.nbt");
+        std::string out;
+        decompress(in.data(), in.size(), out);
+        TS_ASSERT_EQUALS(out, uncompr);
+        //bigtest.zlib lacks the first byte of bigtest_uncompr
+        TS_ASSERT_EQUALS(decompress(read_file("bigtest.zlib")), uncompr.substr(1));
+        //A wrong size hint only costs a reallocation
+        TS_ASSERT_EQUALS(decompress(read_file("bigtest.zlib"), 10), uncompr.substr(1));
+        TS_ASSERT_THROWS(decompress(read_file("bigtest_corrupt.nbt")), zlib_error);
+        TS_ASSERT_THROWS(decompress(read_file("bigtest_eof.nbt")), zlib_error);
+        TS_ASSERT_THROWS(decompress(std::string()), zlib_error);
+
+        //Round trip with a large, well compressible input
+        std::string large;
+        for(int i = 0; i < 200; ++i)
+            large += uncompr;
+        for(bool gzip: {false, true})
+        {
+            for(int level: {Z_DEFAULT_COMPRESSION, 0, 1, 9})
+            {
+                std::string compressed = compress(large, level, gzip);
+                TS_ASSERT_EQUALS(compressed.substr(0, 2) == "\x1f\x8b", gzip);
+                TS_ASSERT_EQUALS(decompress(compressed), large);
+
+                //Must be readable by izlibstream as well
+                std::istringstream str(compressed);
+                izlibstream izls(str);
+                TS_ASSERT(std::string(std::istreambuf_iterator<char>(izls), std::istreambuf_iterator<char>()) == large);
+            }
+        }
+        TS_ASSERT_EQUALS(decompress(compress(std::string())), "");
+        TS_ASSERT_THROWS(compress(bigtest, 10), zlib_error);
+    }
+
+    void test_deflater_inflater()
+    {
+        std::ifstream file("bigtest_uncompr", std::ios::binary);
+        const auto orig = nbt::io::read_compound(file).second;
+
+        //The same objects are reused for every call
+        deflater def(9, true);
+        TS_ASSERT_EQUALS(def.level(), 9);
+        TS_ASSERT(def.is_gzip());
+        inflater inf;
+        std::string compressed, out;
+        for(int i = 0; i < 3; ++i)
+        {
+            def.compress_tag("Level", *orig, compressed);
+            auto pair = inf.read_compound(compressed.data(), compressed.size());
+            TS_ASSERT_EQUALS(pair.first, "Level");
+            TS_ASSERT(*pair.second == *orig);
+
+            //An error doesn't leave the inflater unusable
+            TS_ASSERT_THROWS(inf.decompress(compressed.data(), compressed.size() / 2, out), zlib_error);
+        }
+        def.compress_tag("", *orig, compressed, endian::little);
+        TS_ASSERT(*inf.read_compound(compressed.data(), compressed.size(), endian::little).second == *orig);
+
+        deflater moved = std::move(def);
+        moved.compress(bigtest.data(), bigtest.size(), compressed);
+        inf.decompress(compressed.data(), compressed.size(), out);
+        TS_ASSERT_EQUALS(out, bigtest);
+        //Compatible with the output of ozlibstream
+        std::istringstream str(compressed);
+        izlibstream izls(str);
+        TS_ASSERT_EQUALS(std::string(std::istreambuf_iterator<char>(izls), std::istreambuf_iterator<char>()), bigtest);
+
+        TS_ASSERT_THROWS(deflater(-2), zlib_error);
+    }
 };
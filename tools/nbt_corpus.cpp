@@ -0,0 +1,189 @@
+/*
+ * libnbt++ - A library for the Minecraft Named Binary Tag format.
+ * Copyright (C) 2013, 2015  ljfa-ag
+ *
+ * This file is part of libnbt++.
+ *
+ * libnbt++ is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libnbt++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libnbt++.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * Writes synthetic NBT files generated by nbt::corpus, e.g. as inputs for
+ * benchmarks or as a seed corpus for fuzzers. Run without arguments for usage.
+ */
+#include "corpus.h"
+#include "io/stream_writer.h"
+#ifdef NBT_HAVE_ZLIB
+#include "io/ozlibstream.h"
+#include "io/region_writer.h"
+#endif
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace nbt;
+
+namespace
+{
+    const char usage[] =
+        "Usage: nbt_corpus [options] <output directory>\n"
+        "\n"
+        "Options:\n"
+        "  --kind chunk|level|item  what to generate (default chunk)\n"
+        "  --count N                number of files, or of chunks in a region (default 1)\n"
+        "  --format nbt|gzip|region output format (default gzip, region only for chunks)\n"
+        "  --little                 write little endian instead of big endian\n"
+        "  --seed N                 seed of the random numbers (default 0)\n"
+        "  --sections N             sections per chunk (default 24)\n"
+        "  --palette N              maximum blocks per section palette (default 32)\n"
+        "  --block-entities X       mean number of block entities per chunk (default 8)\n"
+        "  --entities X             mean number of entities per chunk (default 6)\n"
+        "  --item-tags X            probability that an item has NBT (default 0.25)\n"
+        "  --item-depth N           maximum nesting of containers in items (default 4)\n";
+
+    struct arguments
+    {
+        corpus::options opt;
+        std::string kind = "chunk";
+        std::string format = "gzip";
+        unsigned count = 1;
+        endian::endian e = endian::big;
+        std::string dir;
+    };
+
+    arguments parse(int argc, char** argv)
+    {
+        arguments args;
+        for(int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if(++i >= argc)
+                    throw std::invalid_argument("Missing value for " + arg);
+                return argv[i];
+            };
+            if(arg == "--kind")
+                args.kind = next();
+            else if(arg == "--count")
+                args.count = std::stoul(next());
+            else if(arg == "--format")
+                args.format = next();
+            else if(arg == "--little")
+                args.e = endian::little;
+            else if(arg == "--seed")
+                args.opt.seed = std::stoul(next());
+            else if(arg == "--sections")
+                args.opt.sections = std::stoul(next());
+            else if(arg == "--palette")
+                args.opt.max_palette = std::stoul(next());
+            else if(arg == "--block-entities")
+                args.opt.block_entities = std::stod(next());
+            else if(arg == "--entities")
+                args.opt.entities = std::stod(next());
+            else if(arg == "--item-tags")
+                args.opt.item_tag_chance = std::stod(next());
+            else if(arg == "--item-depth")
+                args.opt.max_item_depth = std::stoul(next());
+            else if(arg.compare(0, 2, "--") == 0 || !args.dir.empty())
+                throw std::invalid_argument("Unknown argument " + arg);
+            else
+                args.dir = arg;
+        }
+        if(args.dir.empty())
+            throw std::invalid_argument("No output directory given");
+        if(args.kind != "chunk" && args.kind != "level" && args.kind != "item")
+            throw std::invalid_argument("Unknown kind " + args.kind);
+        if(args.format != "nbt" && args.format != "gzip" && args.format != "region")
+            throw std::invalid_argument("Unknown format " + args.format);
+        if(args.format == "region" && (args.kind != "chunk" || args.count > 1024))
+            throw std::invalid_argument("Regions hold at most 1024 chunks");
+        return args;
+    }
+
+    void write_file(const arguments& args, const std::string& name, const tag_compound& comp)
+    {
+        std::string path = args.dir + "/" + name + ".nbt";
+        std::ofstream file(path, std::ios::binary);
+        if(!file)
+            throw std::runtime_error("Could not open " + path);
+        if(args.format == "gzip")
+        {
+#ifdef NBT_HAVE_ZLIB
+            zlib::ozlibstream ozls(file, -1, true);
+            io::write_tag("", comp, ozls, args.e);
+            ozls.close();
+#else
+            throw std::runtime_error("gzip output requires zlib");
+#endif
+        }
+        else
+            io::write_tag("", comp, file, args.e);
+        if(!file.flush())
+            throw std::runtime_error("Could not write " + path);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    arguments args;
+    try
+    {
+        args = parse(argc, argv);
+    }
+    catch(std::exception& ex)
+    {
+        std::cerr << ex.what() << "\n\n" << usage;
+        return 2;
+    }
+
+    try
+    {
+        corpus::generator gen(args.opt);
+        if(args.format == "region")
+        {
+#ifdef NBT_HAVE_ZLIB
+            io::region_writer region(args.dir + "/r.0.0.mca");
+            for(unsigned i = 0; i < args.count; ++i)
+                region.write_chunk(i % 32, i / 32, *gen.chunk(i % 32, i / 32));
+#else
+            throw std::runtime_error("Region output requires zlib");
+#endif
+        }
+        else
+        {
+            for(unsigned i = 0; i < args.count; ++i)
+            {
+                if(args.kind == "chunk")
+                    write_file(args, "chunk." + std::to_string(i % 32) + "." + std::to_string(i / 32), *gen.chunk(i % 32, i / 32));
+                else if(args.kind == "level")
+                {
+                    //Every level uses a seed of its own
+                    corpus::options opt = args.opt;
+                    opt.seed += i;
+                    write_file(args, "level." + std::to_string(i), *corpus::generator(opt).level());
+                }
+                else
+                    write_file(args, "item." + std::to_string(i), *gen.item(i));
+            }
+        }
+    }
+    catch(std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}